@@ -16,6 +16,7 @@
 #include <openenclave/internal/pem.h>
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
 #include "crl.h"
 #include "ec.h"
@@ -46,18 +47,42 @@ typedef struct _referent
     volatile uint64_t refs;
 } Referent;
 
+/* Certificates and CRLs are parsed and released at high rates (for example
+ * for each quote verification), so their fixed-size structures come from
+ * pools. The chain of a referent is reordered by _sort_certs_by_issue_date()
+ * and released by mbedtls_x509_crt_free(), so only standalone certificates
+ * (see oe_cert_read_pem()) are allocated from _crt_pool. */
+static oe_pool_t* _referent_pool;
+static oe_pool_t* _crt_pool;
+static oe_pool_t* _crl_pool;
+static oe_once_t _pools_once = OE_ONCE_INIT;
+
+static void _create_pools(void)
+{
+    _referent_pool = oe_pool_create(sizeof(Referent), 0);
+    _crt_pool = oe_pool_create(sizeof(mbedtls_x509_crt), 0);
+    _crl_pool = oe_pool_create(sizeof(mbedtls_x509_crl), 0);
+}
+
+OE_INLINE void _init_pools(void)
+{
+    oe_once(&_pools_once, _create_pools);
+}
+
 /* Allocate and initialize a new referent */
 OE_INLINE Referent* _referent_new(void)
 {
     Referent* referent;
 
-    if (!(referent = (Referent*)mbedtls_calloc(1, sizeof(Referent))))
+    _init_pools();
+
+    if (!(referent = (Referent*)oe_pool_alloc(_referent_pool)))
         return NULL;
 
     if (!(referent->crt =
               (mbedtls_x509_crt*)mbedtls_calloc(1, sizeof(mbedtls_x509_crt))))
     {
-        mbedtls_free(referent);
+        oe_pool_free(_referent_pool, referent);
         return NULL;
     }
 
@@ -101,7 +126,7 @@ OE_INLINE void _referent_free(Referent* referent)
 
         /* Free the referent structure */
         oe_memset(referent, 0, sizeof(Referent));
-        mbedtls_free(referent);
+        oe_pool_free(_referent_pool, referent);
     }
 }
 
@@ -158,7 +183,7 @@ OE_INLINE void _cert_free(Cert* impl)
         /* Release the MBEDTLS certificate */
         mbedtls_x509_crt_free(impl->cert);
         oe_memset(impl->cert, 0, sizeof(mbedtls_x509_crt));
-        mbedtls_free(impl->cert);
+        oe_pool_free(_crt_pool, impl->cert);
     }
 
     /* Clear the fields */
@@ -602,7 +627,9 @@ oe_result_t oe_cert_read_pem(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Allocate memory for the certificate */
-    if (!(crt = mbedtls_calloc(1, sizeof(mbedtls_x509_crt))))
+    _init_pools();
+
+    if (!(crt = oe_pool_alloc(_crt_pool)))
         OE_RAISE(OE_OUT_OF_MEMORY);
 
     /* Initialize the certificate structure */
@@ -625,7 +652,7 @@ done:
     {
         mbedtls_x509_crt_free(crt);
         oe_memset(crt, 0, sizeof(mbedtls_x509_crt));
-        mbedtls_free(crt);
+        oe_pool_free(_crt_pool, crt);
     }
 
     return result;
@@ -769,7 +796,9 @@ oe_result_t oe_cert_verify(
             if (!crl_is_valid(crl_impl))
                 OE_RAISE(OE_INVALID_PARAMETER);
 
-            if (!(p = oe_malloc(sizeof(mbedtls_x509_crl))))
+            _init_pools();
+
+            if (!(p = oe_pool_alloc(_crl_pool)))
                 OE_RAISE(OE_OUT_OF_MEMORY);
 
             OE_CHECK(oe_memcpy_s(
@@ -859,7 +888,7 @@ done:
         for (mbedtls_x509_crl* p = crl_list; p;)
         {
             mbedtls_x509_crl* next = p->next;
-            oe_free(p);
+            oe_pool_free(_crl_pool, p);
             p = next;
         }
     }
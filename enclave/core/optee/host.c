@@ -31,3 +31,28 @@ void oe_free_ocall_buffer(void* buffer)
 {
     OE_UNUSED(buffer);
 }
+
+oe_result_t oe_get_shared_buffer(
+    const void* host_ptr,
+    size_t size,
+    bool copy_in,
+    void** buffer)
+{
+    OE_UNUSED(host_ptr);
+    OE_UNUSED(size);
+    OE_UNUSED(copy_in);
+    OE_UNUSED(buffer);
+    return OE_UNSUPPORTED;
+}
+
+void oe_put_shared_buffer(
+    void* host_ptr,
+    void* buffer,
+    size_t size,
+    bool copy_out)
+{
+    OE_UNUSED(host_ptr);
+    OE_UNUSED(buffer);
+    OE_UNUSED(size);
+    OE_UNUSED(copy_out);
+}
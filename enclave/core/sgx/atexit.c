@@ -27,6 +27,7 @@ struct _oe_atexit_entry
 };
 
 static oe_atexit_entry_t* _entries;
+static oe_pool_t* _entries_pool;
 static oe_spinlock_t _spin = OE_SPINLOCK_INITIALIZER;
 
 /*
@@ -34,7 +35,10 @@ static oe_spinlock_t _spin = OE_SPINLOCK_INITIALIZER;
 **
 ** _new_atexit_entry()
 **
-**     Allocate an oe_atexit_entry_t structure from the heap using sbrk().
+**     Allocate an oe_atexit_entry_t structure from a pool. Entries are never
+**     released. The pool is created under the spinlock rather than with
+**     oe_once() since static constructors, which register at-exit functions,
+**     are called by oe_once().
 **
 **==============================================================================
 */
@@ -42,9 +46,18 @@ static oe_spinlock_t _spin = OE_SPINLOCK_INITIALIZER;
 static oe_atexit_entry_t* _new_atexit_entry(void (*func)(void*), void* arg)
 {
     oe_atexit_entry_t* entry;
+    oe_pool_t* pool;
 
-    if ((entry = (oe_atexit_entry_t*)oe_sbrk(sizeof(oe_atexit_entry_t))) ==
-        (void*)-1)
+    oe_spin_lock(&_spin);
+    {
+        if (!_entries_pool)
+            _entries_pool = oe_pool_create(sizeof(oe_atexit_entry_t), 0);
+
+        pool = _entries_pool;
+    }
+    oe_spin_unlock(&_spin);
+
+    if (!(entry = (oe_atexit_entry_t*)oe_pool_alloc(pool)))
         return NULL;
 
     entry->func = func;
@@ -21,8 +21,11 @@
 #include "../../sgx/report.h"
 #include "asmdefs.h"
 #include "cpuid.h"
+#include "heapprofile.h"
 #include "init.h"
 #include "report.h"
+#include "sharedregion.h"
+#include "switchless.h"
 #include "td.h"
 
 oe_result_t __oe_enclave_status = OE_OK;
@@ -167,6 +170,9 @@ static oe_result_t _handle_init_enclave(uint64_t arg_in)
                     OE_RAISE(OE_INVALID_PARAMETER);
 
                 oe_enclave = safe_args.enclave;
+
+                /* Attach to the ring serviced by host worker threads */
+                OE_CHECK(oe_initialize_switchless(safe_args.host_worker_ring));
             }
 
             /* Call all enclave state initialization functions */
@@ -252,82 +258,110 @@ extern const oe_ecall_func_t __oe_ecalls_table[];
 extern const size_t __oe_ecalls_table_size;
 
 /**
- * This is the preferred way to call enclave functions.
+ * Dispatch one enclave function call through __oe_ecalls_table. The args
+ * must already be copied into enclave memory; the buffers they point to are
+ * validated here.
  */
-static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
+static oe_result_t _call_enclave_function(
+    td_t* td,
+    const oe_call_enclave_function_args_t* args,
+    size_t* output_bytes_written)
 {
-    oe_call_enclave_function_args_t args, *args_ptr;
     oe_result_t result = OE_OK;
     oe_ecall_func_t func = NULL;
     uint8_t* buffer = NULL;
     uint8_t* input_buffer = NULL;
     uint8_t* output_buffer = NULL;
     size_t buffer_size = 0;
-    size_t output_bytes_written = 0;
-
-    // Ensure that args lies outside the enclave.
-    if (!oe_is_outside_enclave(
-            (void*)arg_in, sizeof(oe_call_enclave_function_args_t)))
-        OE_RAISE(OE_INVALID_PARAMETER);
-
-    // Copy args to enclave memory to avoid TOCTOU issues.
-    args_ptr = (oe_call_enclave_function_args_t*)arg_in;
-    args = *args_ptr;
+    size_t scratch_size = 0;
 
     // Ensure that input buffer is valid.
-    if (args.input_buffer == NULL || args.input_buffer_size == 0 ||
-        !oe_is_outside_enclave(args.input_buffer, args.input_buffer_size))
+    if (args->input_buffer == NULL || args->input_buffer_size == 0 ||
+        !oe_is_outside_enclave(args->input_buffer, args->input_buffer_size))
         OE_RAISE(OE_INVALID_PARAMETER);
 
     // Ensure that output buffer is valid.
-    if (args.output_buffer == NULL || args.output_buffer_size == 0 ||
-        !oe_is_outside_enclave(args.output_buffer, args.output_buffer_size))
+    if (args->output_buffer == NULL || args->output_buffer_size == 0 ||
+        !oe_is_outside_enclave(args->output_buffer, args->output_buffer_size))
         OE_RAISE(OE_INVALID_PARAMETER);
 
     // Validate output and input buffer sizes.
     // Buffer sizes must be correctly aligned.
-    if ((args.input_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
+    if ((args->input_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    if ((args.output_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
+    if ((args->output_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     OE_CHECK(oe_safe_add_u64(
-        args.input_buffer_size, args.output_buffer_size, &buffer_size));
+        args->input_buffer_size, args->output_buffer_size, &buffer_size));
 
     // Fetch matching function.
-    if (args.function_id >= __oe_ecalls_table_size)
+    if (args->function_id >= __oe_ecalls_table_size)
         OE_RAISE(OE_NOT_FOUND);
 
-    func = __oe_ecalls_table[args.function_id];
+    func = __oe_ecalls_table[args->function_id];
 
     if (func == NULL)
         OE_RAISE(OE_NOT_FOUND);
 
-    // Allocate buffers in enclave memory
-    buffer = input_buffer = oe_malloc(buffer_size);
+    // Take buffers in enclave memory from the scratch buffer of this thread
+    buffer = input_buffer = td_get_ecall_buffer(td, buffer_size, &scratch_size);
     if (buffer == NULL)
         OE_RAISE(OE_OUT_OF_MEMORY);
 
     // Copy input buffer to enclave buffer.
-    oe_memcpy(input_buffer, args.input_buffer, args.input_buffer_size);
+    oe_memcpy(input_buffer, args->input_buffer, args->input_buffer_size);
 
     // Clear out output buffer.
     // This ensures reproducible behavior if say the function is reading from
-    // output buffer.
-    output_buffer = buffer + args.input_buffer_size;
-    oe_memset(output_buffer, 0, args.output_buffer_size);
+    // output buffer. Since the scratch buffer is reused, it also keeps data
+    // of an earlier ECALL from reaching the host through bytes that the
+    // function does not write (such as structure padding).
+    output_buffer = buffer + args->input_buffer_size;
+    oe_memset(output_buffer, 0, args->output_buffer_size);
 
     // Call the function.
+    *output_bytes_written = 0;
     func(
         input_buffer,
-        args.input_buffer_size,
+        args->input_buffer_size,
         output_buffer,
-        args.output_buffer_size,
-        &output_bytes_written);
+        args->output_buffer_size,
+        output_bytes_written);
 
     // Copy outputs to host memory.
-    oe_memcpy(args.output_buffer, output_buffer, output_bytes_written);
+    oe_memcpy(args->output_buffer, output_buffer, *output_bytes_written);
+
+    result = OE_OK;
+
+done:
+    if (buffer)
+        td_put_ecall_buffer(td, buffer, scratch_size);
+
+    return result;
+}
+
+/**
+ * This is the preferred way to call enclave functions. Also used by the
+ * switchless enclave workers.
+ */
+oe_result_t oe_handle_call_enclave_function(uint64_t arg_in)
+{
+    oe_call_enclave_function_args_t args, *args_ptr;
+    oe_result_t result = OE_OK;
+    size_t output_bytes_written = 0;
+
+    // Ensure that args lies outside the enclave.
+    if (!oe_is_outside_enclave(
+            (void*)arg_in, sizeof(oe_call_enclave_function_args_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Copy args to enclave memory to avoid TOCTOU issues.
+    args_ptr = (oe_call_enclave_function_args_t*)arg_in;
+    args = *args_ptr;
+
+    OE_CHECK(_call_enclave_function(oe_get_td(), &args, &output_bytes_written));
 
     // The ecall succeeded.
     args_ptr->output_bytes_written = output_bytes_written;
@@ -335,9 +369,56 @@ static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
     result = OE_OK;
 
 done:
-    if (buffer)
-        oe_free(buffer);
+    return result;
+}
 
+/**
+ * Handle OE_ECALL_CALL_ENCLAVE_FUNCTION_BATCH: dispatch each call of the
+ * batch in order within a single ECALL. The outcome of each call is written
+ * back to its descriptor in host memory; a failed call does not stop the
+ * batch.
+ */
+static oe_result_t _handle_call_enclave_function_batch(uint64_t arg_in)
+{
+    oe_call_enclave_function_batch_args_t args, *args_ptr;
+    oe_result_t result = OE_OK;
+    td_t* td = oe_get_td();
+    size_t calls_size = 0;
+
+    // Ensure that args lies outside the enclave.
+    if (!oe_is_outside_enclave(
+            (void*)arg_in, sizeof(oe_call_enclave_function_batch_args_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Copy args to enclave memory to avoid TOCTOU issues.
+    args_ptr = (oe_call_enclave_function_batch_args_t*)arg_in;
+    args = *args_ptr;
+
+    // Ensure that the array of calls lies outside the enclave.
+    OE_CHECK(oe_safe_mul_u64(
+        args.num_calls, sizeof(oe_call_enclave_function_args_t), &calls_size));
+
+    if (args.calls == NULL || args.num_calls == 0 ||
+        !oe_is_outside_enclave(args.calls, calls_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    for (uint64_t i = 0; i < args.num_calls; i++)
+    {
+        // Copy each descriptor to enclave memory before using it.
+        oe_call_enclave_function_args_t call = args.calls[i];
+        size_t output_bytes_written = 0;
+        oe_result_t call_result;
+
+        call_result = _call_enclave_function(td, &call, &output_bytes_written);
+
+        args.calls[i].output_bytes_written = output_bytes_written;
+        args.calls[i].result = call_result;
+    }
+
+    args_ptr->result = OE_OK;
+    result = OE_OK;
+
+done:
     return result;
 }
 
@@ -430,7 +511,32 @@ static void _handle_ecall(
         }
         case OE_ECALL_CALL_ENCLAVE_FUNCTION:
         {
-            arg_out = _handle_call_enclave_function(arg_in);
+            arg_out = oe_handle_call_enclave_function(arg_in);
+            break;
+        }
+        case OE_ECALL_SWITCHLESS_WORKER:
+        {
+            arg_out = oe_handle_switchless_worker(arg_in);
+            break;
+        }
+        case OE_ECALL_CALL_ENCLAVE_FUNCTION_BATCH:
+        {
+            arg_out = _handle_call_enclave_function_batch(arg_in);
+            break;
+        }
+        case OE_ECALL_REGISTER_SHARED_REGION:
+        {
+            arg_out = oe_handle_register_shared_region(arg_in);
+            break;
+        }
+        case OE_ECALL_SET_HEAP_PROFILE_RATE:
+        {
+            arg_out = oe_handle_set_heap_profile_rate(arg_in);
+            break;
+        }
+        case OE_ECALL_GET_HEAP_PROFILE:
+        {
+            arg_out = oe_handle_get_heap_profile(arg_in);
             break;
         }
         case OE_ECALL_DESTRUCTOR:
@@ -441,6 +547,9 @@ static void _handle_ecall(
             /* Call all finalization functions */
             oe_call_fini_functions();
 
+            /* Release the per-thread buffers of all threads */
+            td_free_buffers();
+
 #if defined(OE_USE_DEBUG_MALLOC)
 
             /* If memory still allocated, print a trace and return an error */
@@ -486,6 +595,11 @@ static void _handle_ecall(
 
 done:
 
+    /* Write the partial line that oe_host_printf() left in the staging
+     * buffer of this thread when the outermost ECALL returns */
+    if (td->depth == 1)
+        oe_host_flush(0);
+
     /* Remove ECALL context from front of td_t.ecalls list */
     td_pop_callsite(td);
 
@@ -556,6 +670,15 @@ oe_result_t oe_ocall(uint16_t func, uint64_t arg_in, uint64_t* arg_out)
     if (!td_initialized(td))
         OE_RAISE_NO_TRACE(OE_FAILURE);
 
+    /* Write the partial line staged by oe_host_printf() before the host runs
+     * user code, which may print to the same stream */
+    if (func == OE_OCALL_CALL_HOST || func == OE_OCALL_CALL_HOST_FUNCTION ||
+        func == OE_OCALL_CALL_HOST_BY_ADDRESS ||
+        func == OE_OCALL_CALL_HOST_BY_HANDLE)
+    {
+        oe_host_flush(0);
+    }
+
     /* Save call site where execution will resume after OCALL */
     if (oe_setjmp(&callsite->jmpbuf) == 0)
     {
@@ -592,13 +715,14 @@ done:
 oe_result_t oe_call_host(const char* func, void* args_in)
 {
     oe_result_t result = OE_UNEXPECTED;
+    td_t* td = oe_get_td();
     oe_call_host_args_t* args = NULL;
 
     /* Reject invalid parameters */
     if (!func)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Initialize the arguments */
+    /* Initialize the arguments (in the host arena to avoid extra OCALLs) */
     {
         size_t len = oe_strlen(func);
         size_t total_len;
@@ -607,7 +731,7 @@ oe_result_t oe_call_host(const char* func, void* args_in)
         OE_CHECK(oe_safe_add_sizet(
             len, 1 + sizeof(oe_call_host_args_t), &total_len));
 
-        if (!(args = oe_host_calloc(1, total_len)))
+        if (!(args = td_host_arena_alloc(td, total_len)))
         {
             /* If the enclave is in crashing/crashed status, new OCALL should
              * fail immediately. */
@@ -630,7 +754,105 @@ oe_result_t oe_call_host(const char* func, void* args_in)
     result = OE_OK;
 
 done:
-    oe_host_free(args);
+    td_host_arena_free(td, args);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_host_function_handle()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_host_function_handle(const char* func, uint64_t* handle)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    td_t* td = oe_get_td();
+    oe_get_host_function_handle_args_t* args = NULL;
+
+    if (handle)
+        *handle = 0;
+
+    /* Reject invalid parameters */
+    if (!func || !handle)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Initialize the arguments */
+    {
+        size_t len = oe_strlen(func);
+        size_t total_len;
+
+        OE_CHECK(oe_safe_add_sizet(
+            len, 1 + sizeof(oe_get_host_function_handle_args_t), &total_len));
+
+        if (!(args = td_host_arena_alloc(td, total_len)))
+        {
+            /* Fail if the enclave is crashing. */
+            OE_CHECK(__oe_enclave_status);
+            OE_RAISE(OE_OUT_OF_MEMORY);
+        }
+
+        OE_CHECK(oe_memcpy_s(args->func, len + 1, func, len + 1));
+
+        args->handle = 0;
+        args->result = OE_UNEXPECTED;
+    }
+
+    /* Ask the host to resolve the name */
+    OE_CHECK(oe_ocall(OE_OCALL_GET_HOST_FUNCTION_HANDLE, (uint64_t)args, NULL));
+
+    /* Check the result */
+    OE_CHECK(args->result);
+
+    /* The host validates handles when they are used */
+    *handle = args->handle;
+    result = OE_OK;
+
+done:
+    td_host_arena_free(td, args);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_call_host_by_handle()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_host_by_handle(uint64_t handle, void* args_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    td_t* td = oe_get_td();
+    oe_call_host_by_handle_args_t* args = NULL;
+
+    /* Initialize the arguments */
+    {
+        if (!(args = td_host_arena_alloc(td, sizeof(*args))))
+        {
+            /* Fail if the enclave is crashing. */
+            OE_CHECK(__oe_enclave_status);
+            OE_RAISE(OE_OUT_OF_MEMORY);
+        }
+
+        args->args = args_in;
+        args->handle = handle;
+        args->result = OE_UNEXPECTED;
+    }
+
+    /* Call the host function with this handle */
+    OE_CHECK(oe_ocall(OE_OCALL_CALL_HOST_BY_HANDLE, (uint64_t)args, NULL));
+
+    /* Check the result */
+    OE_CHECK(args->result);
+
+    result = OE_OK;
+
+done:
+    td_host_arena_free(td, args);
     return result;
 }
 
@@ -647,6 +869,7 @@ oe_result_t oe_call_host_by_address(
     void* args_in)
 {
     oe_result_t result = OE_UNEXPECTED;
+    td_t* td = oe_get_td();
     oe_call_host_by_address_args_t* args = NULL;
 
     /* Reject invalid parameters */
@@ -659,7 +882,7 @@ oe_result_t oe_call_host_by_address(
 
     /* Initialize the arguments */
     {
-        if (!(args = oe_host_calloc(1, sizeof(*args))))
+        if (!(args = td_host_arena_alloc(td, sizeof(*args))))
         {
             /* Fail if the enclave is crashing. */
             OE_CHECK(__oe_enclave_status);
@@ -681,7 +904,7 @@ oe_result_t oe_call_host_by_address(
 
 done:
 
-    oe_host_free(args);
+    td_host_arena_free(td, args);
 
     return result;
 }
@@ -704,15 +927,16 @@ oe_result_t oe_call_host_function(
     size_t* output_bytes_written)
 {
     oe_result_t result = OE_UNEXPECTED;
+    td_t* td = oe_get_td();
     oe_call_host_function_args_t* args = NULL;
 
     /* Reject invalid parameters */
     if (!input_buffer || input_buffer_size == 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Initialize the arguments */
+    /* Initialize the arguments (in the host arena to avoid extra OCALLs) */
     {
-        if (!(args = oe_host_calloc(1, sizeof(*args))))
+        if (!(args = td_host_arena_alloc(td, sizeof(*args))))
         {
             /* Fail if the enclave is crashing. */
             OE_CHECK(__oe_enclave_status);
@@ -724,6 +948,7 @@ oe_result_t oe_call_host_function(
         args->input_buffer_size = input_buffer_size;
         args->output_buffer = output_buffer;
         args->output_buffer_size = output_buffer_size;
+        args->output_bytes_written = 0;
         args->result = OE_UNEXPECTED;
     }
 
@@ -738,7 +963,7 @@ oe_result_t oe_call_host_function(
 
 done:
 
-    oe_host_free(args);
+    td_host_arena_free(td, args);
 
     return result;
 }
@@ -972,6 +1197,11 @@ void oe_notify_nested_exit_start(
 
 void oe_abort(void)
 {
+    // Write the output staged by oe_host_printf() while OCALLs still work.
+    // The staging buffer is emptied first, so this does not recurse.
+    if (__oe_enclave_status == OE_OK)
+        oe_host_flush(0);
+
     // Once it starts to crash, the state can only transit forward, not
     // backward.
     if (__oe_enclave_status < OE_ENCLAVE_ABORTING)
@@ -0,0 +1,279 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "clock.h"
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
+#include <openenclave/internal/utils.h>
+
+/*
+**==============================================================================
+**
+** TSC clock:
+**
+**     When the enclave uses OE_USE_TSC_CLOCK(), each clock is anchored to the
+**     host clock (one OCALL) and the TSC read around that OCALL. Later reads
+**     add the TSC ticks elapsed since the anchor, converted to nanoseconds,
+**     until the anchor is older than oe_tsc_clock_max_staleness; then the
+**     next read anchors the clock again.
+**
+**     The nanoseconds per tick (the scale) are measured between anchors at
+**     least CLOCK_MIN_CALIBRATION_NSEC apart. Until then, every read anchors
+**     the clock, which is as slow as reading the host clock directly.
+**
+**     Readers do not take a lock: they copy the anchor under a sequence
+**     number that the (serialized) writers make odd while they update it.
+**
+**==============================================================================
+*/
+
+#define CLOCK_MIN_CALIBRATION_NSEC (10 * 1000000UL)
+
+static const uint64_t _MSEC_TO_NSEC = 1000000UL;
+
+typedef struct _clock_state
+{
+    /* Incremented before and after each update of the anchor */
+    volatile uint64_t sequence;
+
+    /* The anchor: the TSC and the time of the clock at that TSC */
+    uint64_t tsc;
+    uint64_t time;
+
+    /* Nanoseconds per tick as 32.32 fixed point, or zero if not calibrated */
+    uint64_t scale;
+
+    /* Ticks after the anchor that may be interpolated */
+    uint64_t max_ticks;
+
+    /* The anchor the scale is measured from */
+    uint64_t baseline_tsc;
+    uint64_t baseline_time;
+
+    /* Serializes the writers */
+    oe_spinlock_t lock;
+
+    /* The largest time returned so far (OE_CLOCK_MONOTONIC only) */
+    volatile uint64_t last;
+} clock_state_t;
+
+static clock_state_t _clocks[] = {
+    {.lock = OE_SPINLOCK_INITIALIZER}, /* OE_CLOCK_REALTIME */
+    {.lock = OE_SPINLOCK_INITIALIZER}, /* OE_CLOCK_MONOTONIC */
+};
+
+/* Overridden by OE_USE_TSC_CLOCK() in the enclave (zero-initialized without
+ * an initializer, which GCC would fold into the callers) */
+__attribute__((weak)) const uint64_t oe_tsc_clock_max_staleness;
+
+OE_INLINE uint64_t _rdtsc(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+**==============================================================================
+**
+** _probe_rdtsc()
+**
+**     RDTSC raises #UD in SGX1 enclaves. oe_emulate_rdtsc() lets the RDTSC
+**     of this function (and no other) return zero instead.
+**
+**==============================================================================
+*/
+
+extern const uint8_t __oe_rdtsc_probe[];
+
+static OE_NEVER_INLINE uint64_t _probe_rdtsc(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile("__oe_rdtsc_probe:\n"
+                 "rdtsc\n"
+                 : "=a"(lo), "=d"(hi));
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+int oe_emulate_rdtsc(uint64_t rip, uint64_t* rax, uint64_t* rdx)
+{
+    if (rip != (uint64_t)__oe_rdtsc_probe)
+        return -1;
+
+    *rax = 0;
+    *rdx = 0;
+    return 0;
+}
+
+static bool _have_rdtsc(void)
+{
+    /* 0: not probed yet, 1: RDTSC works, 2: RDTSC faults. Threads may probe
+     * concurrently, with the same outcome */
+    static volatile int _state;
+
+    if (_state == 0)
+        _state = _probe_rdtsc() ? 1 : 2;
+
+    return _state == 1;
+}
+
+/* Return (x << 32) / y, dropping low bits of both as needed to fit x << 32
+ * in 64 bits (this avoids a 128-bit division) */
+static uint64_t _divide_fixed(uint64_t x, uint64_t y)
+{
+    while (x >> 32)
+    {
+        x >>= 1;
+        y >>= 1;
+    }
+
+    return y ? (x << 32) / y : 0;
+}
+
+static uint64_t _get_host_time(oe_clock_t clock)
+{
+    uint64_t time = (uint64_t)-1;
+
+    if (oe_ocall(OE_OCALL_GET_CLOCK, (uint64_t)clock, &time) != OE_OK)
+        return (uint64_t)-1;
+
+    return time;
+}
+
+/* Interpolate the time at the given TSC from the current anchor. Fail if
+ * the clock is not calibrated or the anchor is too old. */
+static bool _interpolate(clock_state_t* state, uint64_t tsc, uint64_t* time)
+{
+    uint64_t sequence;
+    uint64_t anchor_tsc;
+    uint64_t anchor_time;
+    uint64_t scale;
+    uint64_t max_ticks;
+
+    do
+    {
+        sequence = state->sequence;
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+        anchor_tsc = state->tsc;
+        anchor_time = state->time;
+        scale = state->scale;
+        max_ticks = state->max_ticks;
+
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+    } while ((sequence & 1) || sequence != state->sequence);
+
+    if (!scale || tsc < anchor_tsc || tsc - anchor_tsc > max_ticks)
+        return false;
+
+    *time = anchor_time +
+            (uint64_t)(((unsigned __int128)(tsc - anchor_tsc) * scale) >> 32);
+
+    return true;
+}
+
+/* Read the host clock and make it the new anchor */
+static uint64_t _anchor(oe_clock_t clock, clock_state_t* state)
+{
+    uint64_t time;
+    uint64_t before;
+    uint64_t after;
+    uint64_t tsc;
+
+    oe_spin_lock(&state->lock);
+
+    /* Another thread may have anchored the clock in the meantime */
+    if (_interpolate(state, _rdtsc(), &time))
+        goto done;
+
+    before = _rdtsc();
+
+    if ((time = _get_host_time(clock)) == (uint64_t)-1)
+        goto done;
+
+    after = _rdtsc();
+
+    /* The host read its clock somewhere between the two reads of the TSC */
+    tsc = before + (after - before) / 2;
+
+    state->sequence++;
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+
+    if (!state->baseline_tsc || tsc < state->baseline_tsc ||
+        time < state->baseline_time)
+    {
+        /* First anchor, or the TSC or the host clock went back */
+        state->baseline_tsc = tsc;
+        state->baseline_time = time;
+    }
+    else if (time - state->baseline_time >= CLOCK_MIN_CALIBRATION_NSEC)
+    {
+        state->scale = _divide_fixed(
+            time - state->baseline_time, tsc - state->baseline_tsc);
+        state->baseline_tsc = tsc;
+        state->baseline_time = time;
+    }
+
+    state->tsc = tsc;
+    state->time = time;
+
+    if (state->scale)
+    {
+        state->max_ticks = _divide_fixed(
+            oe_tsc_clock_max_staleness * _MSEC_TO_NSEC, state->scale);
+    }
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    state->sequence++;
+
+done:
+    oe_spin_unlock(&state->lock);
+    return time;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_clock_time()
+**
+**==============================================================================
+*/
+
+uint64_t oe_get_clock_time(oe_clock_t clock)
+{
+    clock_state_t* state;
+    uint64_t time;
+    uint64_t last;
+
+    if ((size_t)clock >= OE_COUNTOF(_clocks))
+        return (uint64_t)-1;
+
+    state = &_clocks[clock];
+
+    if (!oe_tsc_clock_max_staleness || !_have_rdtsc())
+        return _get_host_time(clock);
+
+    if (!_interpolate(state, _rdtsc(), &time))
+        time = _anchor(clock, state);
+
+    /* OE_CLOCK_REALTIME follows the host clock, even when it is set back */
+    if (time == (uint64_t)-1 || clock != OE_CLOCK_MONOTONIC)
+        return time;
+
+    /* Never return less than before, which a new anchor could otherwise do
+     * by correcting the interpolation error */
+    do
+    {
+        if (time <= (last = state->last))
+            return last;
+    } while (!oe_atomic_compare_and_swap(&state->last, last, time));
+
+    return time;
+}
@@ -0,0 +1,13 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_CLOCK_ENCLAVE_H
+#define _OE_CLOCK_ENCLAVE_H
+
+#include <openenclave/bits/types.h>
+
+#define OE_RDTSC_OPCODE 0x310F
+
+int oe_emulate_rdtsc(uint64_t rip, uint64_t* rax, uint64_t* rdx);
+
+#endif /* _OE_CLOCK_ENCLAVE_H */
@@ -16,6 +16,7 @@
 #include <openenclave/internal/thread.h>
 #include <openenclave/internal/trace.h>
 #include "asmdefs.h"
+#include "clock.h"
 #include "cpuid.h"
 #include "init.h"
 #include "td.h"
@@ -225,6 +226,12 @@ int _emulate_illegal_instruction(sgx_ssa_gpr_t* ssa_gpr)
             &ssa_gpr->rax, &ssa_gpr->rbx, &ssa_gpr->rcx, &ssa_gpr->rdx);
     }
 
+    // Emulate the RDTSC that probes for RDTSC support (SGX1)
+    if (*((uint16_t*)ssa_gpr->rip) == OE_RDTSC_OPCODE)
+    {
+        return oe_emulate_rdtsc(ssa_gpr->rip, &ssa_gpr->rax, &ssa_gpr->rdx);
+    }
+
     return -1;
 }
 
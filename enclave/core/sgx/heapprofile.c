@@ -0,0 +1,374 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#define USE_DL_PREFIX
+#include "heapprofile.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/backtrace.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/malloc.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/trace.h>
+#include "../3rdparty/dlmalloc/dlmalloc/malloc.h"
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Heap profiler:
+**
+**     Once the host sets a sampling interval of N bytes, each thread samples
+**     the allocation that brings the bytes it allocated since its previous
+**     sample to N or more. A sample records the stack of the allocation
+**     (oe_backtrace(), or only the caller of the allocation function if no
+**     frames are available) in the stack table, which counts the sampled
+**     allocations per stack, and the block in the block table, so that
+**     freeing it can be charged back to its stack.
+**
+**     Both tables are allocated when profiling starts and are never freed.
+**     The block table is probed without the lock on every free while there
+**     are sampled blocks; samples that do not fit in the tables are dropped.
+**
+**==============================================================================
+*/
+
+#define HEAP_PROFILE_MAX_STACKS 512
+#define HEAP_PROFILE_MAX_BLOCKS 4096
+
+/* Number of block table slots where a block may be stored */
+#define HEAP_PROFILE_BLOCK_PROBES 8
+
+/* Frames of oe_heap_profile_sample() and of the allocation function */
+#define HEAP_PROFILE_SKIP_FRAMES 2
+
+typedef struct _heap_profile_stack
+{
+    uint64_t hash;
+    oe_heap_profile_entry_t entry;
+} heap_profile_stack_t;
+
+typedef struct _heap_profile_block
+{
+    void* volatile ptr;
+    uint64_t size;
+    uint64_t stack;
+} heap_profile_block_t;
+
+volatile uint64_t oe_heap_profile_rate;
+volatile uint64_t oe_heap_profile_num_live;
+
+/* The last nonzero sampling interval, which the recorded samples used */
+static uint64_t _sample_rate;
+
+static heap_profile_stack_t* _stacks;
+static heap_profile_block_t* volatile _blocks;
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+static uint64_t _hash_frames(void* const* frames, size_t num_frames)
+{
+    /* FNV-1a over the return addresses */
+    uint64_t hash = 14695981039346656037UL;
+
+    for (size_t i = 0; i < num_frames; i++)
+    {
+        hash ^= (uint64_t)frames[i];
+        hash *= 1099511628211UL;
+    }
+
+    return hash;
+}
+
+static size_t _hash_block(const void* ptr)
+{
+    /* Blocks are at least 16-byte aligned */
+    return (size_t)(((uint64_t)ptr >> 4) * 11400714819323198485UL >> 52);
+}
+
+OE_STATIC_ASSERT(HEAP_PROFILE_MAX_BLOCKS == (1 << 12));
+
+/* Find or add the stack table entry of the given frames (under _lock) */
+static heap_profile_stack_t* _get_stack(
+    void* const* frames,
+    size_t num_frames,
+    uint64_t* index)
+{
+    uint64_t hash = _hash_frames(frames, num_frames);
+
+    for (size_t i = 0; i < HEAP_PROFILE_MAX_STACKS; i++)
+    {
+        size_t j = (hash + i) % HEAP_PROFILE_MAX_STACKS;
+        heap_profile_stack_t* stack = &_stacks[j];
+        bool match = true;
+
+        if (stack->entry.num_frames == 0)
+        {
+            stack->hash = hash;
+            stack->entry.num_frames = num_frames;
+
+            for (size_t k = 0; k < num_frames; k++)
+                stack->entry.frames[k] = (uint64_t)frames[k];
+
+            *index = j;
+            return stack;
+        }
+
+        if (stack->hash != hash || stack->entry.num_frames != num_frames)
+            continue;
+
+        for (size_t k = 0; k < num_frames && match; k++)
+            match = stack->entry.frames[k] == (uint64_t)frames[k];
+
+        if (match)
+        {
+            *index = j;
+            return stack;
+        }
+    }
+
+    return NULL;
+}
+
+static void _record_sample(
+    void* ptr,
+    size_t size,
+    void* const* frames,
+    size_t num_frames)
+{
+    heap_profile_stack_t* stack;
+    uint64_t index;
+
+    oe_spin_lock(&_lock);
+
+    if (!(stack = _get_stack(frames, num_frames, &index)))
+        goto done;
+
+    stack->entry.alloc_count++;
+    stack->entry.alloc_bytes += size;
+
+    for (size_t i = 0; i < HEAP_PROFILE_BLOCK_PROBES; i++)
+    {
+        size_t j = (_hash_block(ptr) + i) % HEAP_PROFILE_MAX_BLOCKS;
+        heap_profile_block_t* block = &_blocks[j];
+
+        if (!block->ptr)
+        {
+            block->size = size;
+            block->stack = index;
+            block->ptr = ptr;
+
+            stack->entry.in_use_count++;
+            stack->entry.in_use_bytes += size;
+            oe_heap_profile_num_live++;
+            break;
+        }
+    }
+
+done:
+    oe_spin_unlock(&_lock);
+}
+
+/*
+**==============================================================================
+**
+** oe_heap_profile_sample()
+**
+**     Called by oe_heap_profile_malloc() while the profiler is running.
+**
+**==============================================================================
+*/
+
+OE_NEVER_INLINE void oe_heap_profile_sample(
+    void* ptr,
+    size_t size,
+    void* caller)
+{
+    td_state_t* state = td_get_state(oe_get_td());
+    void* frames[HEAP_PROFILE_SKIP_FRAMES + OE_HEAP_PROFILE_MAX_FRAMES];
+    int n;
+
+    if (state->heap_profile_bytes > size)
+    {
+        state->heap_profile_bytes -= size;
+        return;
+    }
+
+    state->heap_profile_bytes = oe_heap_profile_rate;
+
+    n = oe_backtrace(frames, OE_COUNTOF(frames));
+
+    if (n > HEAP_PROFILE_SKIP_FRAMES)
+    {
+        _record_sample(
+            ptr,
+            size,
+            frames + HEAP_PROFILE_SKIP_FRAMES,
+            (size_t)n - HEAP_PROFILE_SKIP_FRAMES);
+    }
+    else
+    {
+        _record_sample(ptr, size, &caller, 1);
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_heap_profile_release()
+**
+**     Called by oe_heap_profile_free() while sampled blocks are live.
+**
+**==============================================================================
+*/
+
+void oe_heap_profile_release(void* ptr)
+{
+    for (size_t i = 0; i < HEAP_PROFILE_BLOCK_PROBES; i++)
+    {
+        size_t j = (_hash_block(ptr) + i) % HEAP_PROFILE_MAX_BLOCKS;
+        heap_profile_block_t* block = &_blocks[j];
+
+        if (block->ptr != ptr)
+            continue;
+
+        oe_spin_lock(&_lock);
+
+        /* The block cannot be sampled again before it is freed */
+        if (block->ptr == ptr)
+        {
+            oe_heap_profile_entry_t* entry = &_stacks[block->stack].entry;
+
+            entry->in_use_count--;
+            entry->in_use_bytes -= block->size;
+            block->ptr = NULL;
+            oe_heap_profile_num_live--;
+        }
+
+        oe_spin_unlock(&_lock);
+        break;
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_set_heap_profile_rate()
+**
+**     Handle OE_ECALL_SET_HEAP_PROFILE_RATE. The counts recorded so far are
+**     kept when sampling stops or restarts. Heap profiles reveal how the
+**     enclave runs, so only debug enclaves give them to the host.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_set_heap_profile_rate(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!is_enclave_debug_allowed())
+        OE_RAISE(OE_UNSUPPORTED);
+
+    oe_spin_lock(&_lock);
+
+    /* Allocate the tables with dlmalloc to keep them out of the profile */
+    if (arg_in && !_blocks)
+    {
+        _stacks = (heap_profile_stack_t*)dlcalloc(
+            HEAP_PROFILE_MAX_STACKS, sizeof(heap_profile_stack_t));
+        _blocks = (heap_profile_block_t*)dlcalloc(
+            HEAP_PROFILE_MAX_BLOCKS, sizeof(heap_profile_block_t));
+
+        if (!_stacks || !_blocks)
+        {
+            dlfree(_stacks);
+            dlfree(_blocks);
+            _stacks = NULL;
+            _blocks = NULL;
+            oe_spin_unlock(&_lock);
+            OE_RAISE(OE_OUT_OF_MEMORY);
+        }
+    }
+
+    if (arg_in)
+        _sample_rate = arg_in;
+
+    oe_heap_profile_rate = arg_in;
+
+    oe_spin_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_get_heap_profile()
+**
+**     Handle OE_ECALL_GET_HEAP_PROFILE (debug enclaves only, like
+**     OE_ECALL_SET_HEAP_PROFILE_RATE).
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_get_heap_profile(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_get_heap_profile_args_t args, *args_ptr;
+    oe_heap_stats_t stats;
+    uint64_t size;
+    uint64_t n = 0;
+
+    if (!is_enclave_debug_allowed())
+        OE_RAISE(OE_UNSUPPORTED);
+
+    // Ensure that args lies outside the enclave.
+    if (!oe_is_outside_enclave(
+            (void*)arg_in, sizeof(oe_get_heap_profile_args_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Copy args to enclave memory to avoid TOCTOU issues.
+    args_ptr = (oe_get_heap_profile_args_t*)arg_in;
+    args = *args_ptr;
+
+    OE_CHECK(oe_safe_mul_u64(
+        args.max_entries, sizeof(oe_heap_profile_entry_t), &size));
+
+    if (size && !oe_is_outside_enclave(args.entries, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_get_heap_stats(&stats));
+
+    oe_spin_lock(&_lock);
+
+    if (_stacks)
+    {
+        for (size_t i = 0; i < HEAP_PROFILE_MAX_STACKS; i++)
+        {
+            if (_stacks[i].entry.num_frames == 0)
+                continue;
+
+            if (n < args.max_entries)
+                args.entries[n] = _stacks[i].entry;
+
+            n++;
+        }
+    }
+
+    args_ptr->sample_rate = _sample_rate;
+
+    oe_spin_unlock(&_lock);
+
+    args_ptr->num_entries = n;
+    args_ptr->stats = stats;
+    args_ptr->result = n > args.max_entries ? OE_BUFFER_TOO_SMALL : OE_OK;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
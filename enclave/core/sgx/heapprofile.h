@@ -0,0 +1,37 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef OE_HEAPPROFILE_H
+#define OE_HEAPPROFILE_H
+
+#include <openenclave/enclave.h>
+
+/* Sampling interval in bytes, or zero if the heap profiler is stopped */
+extern volatile uint64_t oe_heap_profile_rate;
+
+/* Number of sampled blocks not freed yet */
+extern volatile uint64_t oe_heap_profile_num_live;
+
+void oe_heap_profile_sample(void* ptr, size_t size, void* caller);
+
+void oe_heap_profile_release(void* ptr);
+
+/* Called by the allocation functions for each block they return */
+OE_INLINE void oe_heap_profile_malloc(void* ptr, size_t size, void* caller)
+{
+    if (oe_heap_profile_rate && ptr)
+        oe_heap_profile_sample(ptr, size, caller);
+}
+
+/* Called by the allocation functions for each block they release */
+OE_INLINE void oe_heap_profile_free(void* ptr)
+{
+    if (oe_heap_profile_num_live && ptr)
+        oe_heap_profile_release(ptr);
+}
+
+oe_result_t oe_handle_set_heap_profile_rate(uint64_t arg_in);
+
+oe_result_t oe_handle_get_heap_profile(uint64_t arg_in);
+
+#endif /* OE_HEAPPROFILE_H */
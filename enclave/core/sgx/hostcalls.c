@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#define USE_DL_PREFIX
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/bits/safemath.h>
 #include <openenclave/edger8r/enclave.h>
@@ -8,6 +9,7 @@
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/print.h>
+#include "../3rdparty/dlmalloc/dlmalloc/malloc.h"
 #include "td.h"
 
 void* oe_host_malloc(size_t size)
@@ -98,37 +100,136 @@ char* oe_host_strndup(const char* str, size_t n)
     return p;
 }
 
-int oe_host_write(int device, const char* str, size_t len)
+/*
+**==============================================================================
+**
+** Host output:
+**
+**     Every write to the host stdout or stderr is a single OE_OCALL_WRITE
+**     whose arguments come from the host arena of the calling thread (see
+**     td_host_arena_alloc()), so it costs one enclave exit rather than three.
+**
+**     Output of oe_host_printf() and friends to stdout is also
+**     line-buffered: each thread stages it in an enclave buffer and writes it
+**     to the host when a newline is printed, when the buffer is full, on
+**     oe_host_flush(), before any user OCALL (whose host code may print as
+**     well), on oe_abort() and when the outermost ECALL of the thread (or a
+**     switchless ECALL) returns. Output to stderr is unbuffered, as in C
+**     stdio, so that nothing is lost when the enclave crashes. Direct writes
+**     (oe_host_write(), oe_host_writev()) are not buffered, but they carry
+**     the staged output of the thread along with them so that the order of
+**     the output is kept.
+**
+**     Staging buffers are taken from dlmalloc directly rather than from
+**     oe_malloc(), so the debug allocator does not report them as leaks.
+**
+**==============================================================================
+*/
+
+/* Size of the staging buffer of a thread for one device */
+#define PRINT_BUFFER_SIZE 1024
+
+/* Threads with a larger td_get_index() write through to the host */
+#define PRINT_MAX_THREADS 64
+
+typedef struct _print_buffer
+{
+    size_t size;
+    char data[PRINT_BUFFER_SIZE];
+} print_buffer_t;
+
+/* Staging buffers of stdout indexed by td_get_index(), created on first use.
+ * Each one is only accessed by its own thread. */
+static print_buffer_t* _print_buffers[PRINT_MAX_THREADS];
+
+static print_buffer_t* _get_print_buffer(int device, bool create)
+{
+    size_t index = td_get_index(oe_get_td());
+    print_buffer_t** buffer;
+
+    if (device != 0 || index >= PRINT_MAX_THREADS)
+        return NULL;
+
+    buffer = &_print_buffers[index];
+
+    if (!*buffer && create)
+    {
+        if ((*buffer = (print_buffer_t*)dlmalloc(sizeof(print_buffer_t))))
+            (*buffer)->size = 0;
+    }
+
+    return *buffer;
+}
+
+/* Write the staged output in buffer (if any) followed by the given vector to
+ * the host with a single OCALL, and empty the buffer */
+static int _write_to_host(
+    int device,
+    print_buffer_t* buffer,
+    const oe_host_iovec_t* iov,
+    size_t iovcnt)
 {
     int ret = -1;
+    td_t* td = oe_get_td();
     oe_print_args_t* args = NULL;
+    size_t len = buffer ? buffer->size : 0;
+    size_t total_size;
+    char* p;
+    char* end;
 
     /* Reject invalid arguments */
-    if ((device != 0 && device != 1) || !str)
+    if ((device != 0 && device != 1) || (iovcnt && !iov))
         goto done;
 
-    /* Determine the length of the string */
-    if (len == (size_t)-1)
-        len = oe_strlen(str);
+    /* Determine the length of the output, checking for integer overflow */
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+        if (!iov[i].base && iov[i].len)
+            goto done;
 
-    /* Check for integer overflow and allocate space for the arguments followed
-     * by null-terminated string */
-    size_t total_size;
+        if (oe_safe_add_sizet(len, iov[i].len, &len) != OE_OK)
+            goto done;
+    }
+
+    if (len == 0)
+    {
+        ret = 0;
+        goto done;
+    }
+
+    /* Allocate space for the arguments followed by null-terminated string */
     if (oe_safe_add_sizet(len, 1 + sizeof(oe_print_args_t), &total_size) !=
         OE_OK)
         goto done;
 
-    if (!(args = (oe_print_args_t*)oe_host_calloc(1, total_size)))
+    if (!(args = (oe_print_args_t*)td_host_arena_alloc(td, total_size)))
         goto done;
 
     /* Initialize the arguments */
     args->device = device;
-    args->str = (char*)(args + 1);
+    args->str = p = (char*)(args + 1);
+    end = p + len;
 
-    if (oe_memcpy_s(args->str, len, str, len) != OE_OK)
-        goto done;
+    if (buffer)
+    {
+        if (oe_memcpy_s(p, (size_t)(end - p), buffer->data, buffer->size) !=
+            OE_OK)
+            goto done;
+
+        p += buffer->size;
+        buffer->size = 0;
+    }
 
-    args->str[len] = '\0';
+    for (size_t i = 0; i < iovcnt; i++)
+    {
+        if (oe_memcpy_s(p, (size_t)(end - p), iov[i].base, iov[i].len) !=
+            OE_OK)
+            goto done;
+
+        p += iov[i].len;
+    }
+
+    *p = '\0';
 
     /* Perform OCALL */
     if (oe_ocall(OE_OCALL_WRITE, (uint64_t)args, NULL) != OE_OK)
@@ -137,15 +238,51 @@ int oe_host_write(int device, const char* str, size_t len)
     ret = 0;
 
 done:
-    oe_host_free(args);
+    td_host_arena_free(td, args);
     return ret;
 }
 
+int oe_host_write(int device, const char* str, size_t len)
+{
+    oe_host_iovec_t iov;
+
+    if (!str)
+        return -1;
+
+    /* Determine the length of the string */
+    if (len == (size_t)-1)
+        len = oe_strlen(str);
+
+    iov.base = str;
+    iov.len = len;
+
+    return _write_to_host(device, _get_print_buffer(device, false), &iov, 1);
+}
+
+int oe_host_writev(int device, const oe_host_iovec_t* iov, size_t iovcnt)
+{
+    return _write_to_host(
+        device, _get_print_buffer(device, false), iov, iovcnt);
+}
+
+int oe_host_flush(int device)
+{
+    print_buffer_t* buffer = _get_print_buffer(device, false);
+
+    if (!buffer || buffer->size == 0)
+        return 0;
+
+    return _write_to_host(device, buffer, NULL, 0);
+}
+
 int oe_host_vfprintf(int device, const char* fmt, oe_va_list ap_)
 {
     char buf[256];
     char* p = buf;
     int n;
+    print_buffer_t* buffer;
+    oe_host_iovec_t iov;
+    bool newline = false;
 
     /* Try first with a fixed-length scratch buffer */
     {
@@ -167,7 +304,26 @@ int oe_host_vfprintf(int device, const char* fmt, oe_va_list ap_)
         oe_va_end(ap);
     }
 
-    oe_host_write(device, p, (size_t)-1);
+    if (n < 0)
+        return n;
+
+    for (int i = n - 1; i >= 0 && !newline; i--)
+        newline = p[i] == '\n';
+
+    /* Stage a partial line if it fits, else write it with the staged output */
+    buffer = _get_print_buffer(device, true);
+
+    if (buffer && !newline && (size_t)n <= PRINT_BUFFER_SIZE - buffer->size)
+    {
+        oe_memcpy(buffer->data + buffer->size, p, (size_t)n);
+        buffer->size += (size_t)n;
+    }
+    else
+    {
+        iov.base = p;
+        iov.len = (size_t)n;
+        _write_to_host(device, buffer, &iov, 1);
+    }
 
     return n;
 }
@@ -196,14 +352,15 @@ int oe_host_fprintf(int device, const char* fmt, ...)
     return n;
 }
 
-// Function used by oeedger8r for allocating ocall buffers.
+// Function used by oeedger8r for allocating ocall buffers. The buffer comes
+// from the host arena of the calling thread (see td_host_arena_alloc()).
 void* oe_allocate_ocall_buffer(size_t size)
 {
-    return oe_host_malloc(size);
+    return td_host_arena_alloc(oe_get_td(), size);
 }
 
 // Function used by oeedger8r for freeing ocall buffers.
 void oe_free_ocall_buffer(void* buffer)
 {
-    oe_host_free(buffer);
+    td_host_arena_free(oe_get_td(), buffer);
 }
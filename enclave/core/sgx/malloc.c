@@ -10,6 +10,8 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/thread.h>
 #include "debugmalloc.h"
+#include "heapprofile.h"
+#include "td.h"
 
 #define HAVE_MMAP 0
 #define LACKS_UNISTD_H
@@ -21,7 +23,7 @@
 #define USE_DL_PREFIX
 #define LACKS_STDLIB_H
 #define LACKS_STRING_H
-#define USE_LOCKS 1
+#define USE_LOCKS 2
 #define size_t size_t
 #define ptrdiff_t ptrdiff_t
 #define memset oe_memset
@@ -31,6 +33,50 @@
 
 typedef struct _FILE FILE;
 
+/*
+**==============================================================================
+**
+** Allocator variants
+**
+**     This file is built twice. The default build is a single dlmalloc heap
+**     whose entry points are weak. malloc_arenas.c builds it again with
+**     OE_MALLOC_THREAD_ARENAS defined, which adds per-thread arenas; the
+**     linker only pulls that object in for enclaves that reference
+**     oe_link_thread_arenas (see OE_USE_THREAD_ARENAS()), and its strong
+**     definitions then override the default ones.
+**
+**==============================================================================
+*/
+
+#if defined(OE_MALLOC_THREAD_ARENAS)
+#define MSPACES 1
+#define FOOTERS 1
+#define OE_MALLOC_EXPORT
+#else
+#define DLMALLOC_EXPORT extern __attribute__((weak))
+#define OE_MALLOC_EXPORT __attribute__((weak))
+/* The only dlmalloc entry point declared without DLMALLOC_EXPORT */
+__attribute__((weak)) size_t dlmalloc_usable_size(void* mem);
+#endif
+
+/* dlmalloc takes the enclave spin lock (a fair ticket lock) for the heap and
+ * each arena instead of its own test-and-set lock */
+#define MLOCK_T oe_spinlock_t
+#define INITIAL_LOCK(lk) (*(lk) = OE_SPINLOCK_INITIALIZER)
+#define DESTROY_LOCK(lk) (0)
+#define ACQUIRE_LOCK(lk) _dlmalloc_acquire_lock(lk)
+#define RELEASE_LOCK(lk) oe_spin_unlock(lk)
+#define TRY_LOCK(lk) (oe_spin_trylock(lk) == OE_OK)
+
+/* Returns zero once the lock is acquired, as dlmalloc expects */
+OE_INLINE int _dlmalloc_acquire_lock(oe_spinlock_t* lock)
+{
+    oe_spin_lock(lock);
+    return 0;
+}
+
+static MLOCK_T malloc_global_mutex = OE_SPINLOCK_INITIALIZER;
+
 static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 
 #pragma GCC diagnostic push
@@ -42,6 +88,149 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 
 #pragma GCC diagnostic pop
 
+/*
+**==============================================================================
+**
+** Per-thread arenas (see OE_USE_THREAD_ARENAS())
+**
+**     Each arena is a dlmalloc mspace with its own lock, created on first use
+**     from MALLOC_ARENA_INITIAL_SIZE bytes of oe_sbrk() memory and grown with
+**     oe_sbrk() like the global heap. Threads are bound to arenas round-robin
+**     (by td_get_index()) so that threads on different TCSs rarely share a
+**     lock.
+**
+**     This variant builds dlmalloc with FOOTERS, which records the owning
+**     arena in each chunk: dlfree() and dlrealloc() find the arena from the
+**     chunk, so any thread can free memory allocated by another. The
+**     overhead of a chunk grows from 8 to 16 bytes, so requests of 17 to 24
+**     bytes, 33 to 40 bytes and so on take 16 more bytes. The default build
+**     keeps the 8-byte overhead.
+**
+**==============================================================================
+*/
+
+#if defined(OE_MALLOC_THREAD_ARENAS)
+
+#define MALLOC_NUM_ARENAS 16
+#define MALLOC_ARENA_INITIAL_SIZE (256 * 1024)
+
+/* Referenced by OE_USE_THREAD_ARENAS() to link this variant */
+const bool oe_link_thread_arenas = true;
+
+const bool oe_use_thread_arenas = true;
+
+static mspace volatile _arenas[MALLOC_NUM_ARENAS];
+
+#else
+
+__attribute__((weak)) const bool oe_use_thread_arenas;
+
+#endif /* defined(OE_MALLOC_THREAD_ARENAS) */
+
+#if defined(OE_MALLOC_THREAD_ARENAS) && !defined(OE_USE_DEBUG_MALLOC)
+
+static oe_spinlock_t _arenas_lock = OE_SPINLOCK_INITIALIZER;
+
+static mspace _create_arena(size_t index)
+{
+    mspace arena;
+
+    oe_spin_lock(&_arenas_lock);
+
+    if (!(arena = _arenas[index]))
+    {
+        void* base;
+
+        /* dlmalloc extends arenas by calling sbrk() twice under this lock */
+        ACQUIRE_MALLOC_GLOBAL_LOCK();
+        base = oe_sbrk(MALLOC_ARENA_INITIAL_SIZE);
+        RELEASE_MALLOC_GLOBAL_LOCK();
+
+        if (base != (void*)-1)
+        {
+            arena = create_mspace_with_base(base, MALLOC_ARENA_INITIAL_SIZE, 1);
+            _arenas[index] = arena;
+        }
+    }
+
+    oe_spin_unlock(&_arenas_lock);
+
+    return arena;
+}
+
+/* Return the arena of the calling thread or null to use the global heap */
+static mspace _get_arena(void)
+{
+    size_t index = td_get_index(oe_get_td()) % MALLOC_NUM_ARENAS;
+    mspace arena;
+
+    if (!(arena = _arenas[index]))
+        arena = _create_arena(index);
+
+    return arena;
+}
+
+static void* _malloc(size_t size)
+{
+    mspace arena;
+
+    if ((arena = _get_arena()))
+        return mspace_malloc(arena, size);
+
+    return dlmalloc(size);
+}
+
+static void* _calloc(size_t nmemb, size_t size)
+{
+    mspace arena;
+
+    if ((arena = _get_arena()))
+        return mspace_calloc(arena, nmemb, size);
+
+    return dlcalloc(nmemb, size);
+}
+
+static void* _realloc(void* ptr, size_t size)
+{
+    /* An existing chunk is resized within the arena that owns it */
+    if (!ptr)
+        return _malloc(size);
+
+    return dlrealloc(ptr, size);
+}
+
+static void* _memalign(size_t alignment, size_t size)
+{
+    mspace arena;
+
+    if ((arena = _get_arena()))
+        return mspace_memalign(arena, alignment, size);
+
+    return dlmemalign(alignment, size);
+}
+
+static int _posix_memalign(void** memptr, size_t alignment, size_t size)
+{
+    mspace arena;
+    void* p;
+
+    if (!(arena = _get_arena()))
+        return dlposix_memalign(memptr, alignment, size);
+
+    /* Same checks as dlposix_memalign() */
+    if (alignment % sizeof(void*) != 0 || alignment == 0 ||
+        (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+
+    if (!(p = mspace_memalign(arena, alignment, size)))
+        return ENOMEM;
+
+    *memptr = p;
+    return 0;
+}
+
+#endif /* defined(OE_MALLOC_THREAD_ARENAS) && !defined(OE_USE_DEBUG_MALLOC) */
+
 /* Choose release mode or debug mode allocation functions */
 #if defined(OE_USE_DEBUG_MALLOC)
 #define MALLOC oe_debug_malloc
@@ -50,24 +239,31 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 #define MEMALIGN oe_debug_memalign
 #define POSIX_MEMALIGN oe_debug_posix_memalign
 #define FREE oe_debug_free
-#else
+#elif !defined(OE_MALLOC_THREAD_ARENAS)
 #define MALLOC dlmalloc
 #define CALLOC dlcalloc
 #define REALLOC dlrealloc
 #define MEMALIGN dlmemalign
 #define POSIX_MEMALIGN dlposix_memalign
 #define FREE dlfree
+#else
+#define MALLOC _malloc
+#define CALLOC _calloc
+#define REALLOC _realloc
+#define MEMALIGN _memalign
+#define POSIX_MEMALIGN _posix_memalign
+#define FREE dlfree
 #endif
 
 static oe_allocation_failure_callback_t _failure_callback;
 
-void oe_set_allocation_failure_callback(
+OE_MALLOC_EXPORT void oe_set_allocation_failure_callback(
     oe_allocation_failure_callback_t function)
 {
     _failure_callback = function;
 }
 
-void* oe_malloc(size_t size)
+OE_MALLOC_EXPORT void* oe_malloc(size_t size)
 {
     void* p = MALLOC(size);
 
@@ -79,15 +275,18 @@ void* oe_malloc(size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, size);
     }
 
+    oe_heap_profile_malloc(p, size, __builtin_return_address(0));
+
     return p;
 }
 
-void oe_free(void* ptr)
+OE_MALLOC_EXPORT void oe_free(void* ptr)
 {
+    oe_heap_profile_free(ptr);
     FREE(ptr);
 }
 
-void* oe_calloc(size_t nmemb, size_t size)
+OE_MALLOC_EXPORT void* oe_calloc(size_t nmemb, size_t size)
 {
     void* p = CALLOC(nmemb, size);
 
@@ -99,12 +298,20 @@ void* oe_calloc(size_t nmemb, size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, nmemb * size);
     }
 
+    oe_heap_profile_malloc(p, nmemb * size, __builtin_return_address(0));
+
     return p;
 }
 
-void* oe_realloc(void* ptr, size_t size)
+OE_MALLOC_EXPORT void* oe_realloc(void* ptr, size_t size)
 {
-    void* p = REALLOC(ptr, size);
+    void* p;
+
+    /* Release the old block from the profile first: once REALLOC() frees
+     * it, another thread may be given (and sample) the same address */
+    oe_heap_profile_free(ptr);
+
+    p = REALLOC(ptr, size);
 
     if (!p && size)
     {
@@ -114,10 +321,15 @@ void* oe_realloc(void* ptr, size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, size);
     }
 
+    oe_heap_profile_malloc(p, size, __builtin_return_address(0));
+
     return p;
 }
 
-int oe_posix_memalign(void** memptr, size_t alignment, size_t size)
+OE_MALLOC_EXPORT int oe_posix_memalign(
+    void** memptr,
+    size_t alignment,
+    size_t size)
 {
     int rc = POSIX_MEMALIGN(memptr, alignment, size);
 
@@ -129,10 +341,13 @@ int oe_posix_memalign(void** memptr, size_t alignment, size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, size);
     }
 
+    if (rc == 0)
+        oe_heap_profile_malloc(*memptr, size, __builtin_return_address(0));
+
     return rc;
 }
 
-void* oe_memalign(size_t alignment, size_t size)
+OE_MALLOC_EXPORT void* oe_memalign(size_t alignment, size_t size)
 {
     void* p = MEMALIGN(alignment, size);
 
@@ -144,6 +359,8 @@ void* oe_memalign(size_t alignment, size_t size)
             _failure_callback(__FILE__, __LINE__, __FUNCTION__, size);
     }
 
+    oe_heap_profile_malloc(p, size, __builtin_return_address(0));
+
     return p;
 }
 
@@ -205,7 +422,7 @@ done:
     return ret;
 }
 
-oe_result_t oe_get_malloc_stats(oe_malloc_stats_t* stats)
+OE_MALLOC_EXPORT oe_result_t oe_get_malloc_stats(oe_malloc_stats_t* stats)
 {
     oe_result_t result = OE_UNEXPECTED;
     static oe_mutex_t _mutex = OE_MUTEX_INITIALIZER;
@@ -227,6 +444,23 @@ oe_result_t oe_get_malloc_stats(oe_malloc_stats_t* stats)
     if (_dlmalloc_stats_fprintf_calls != 3)
         goto done;
 
+#if defined(OE_MALLOC_THREAD_ARENAS)
+    /* Add the arenas, if any */
+    for (size_t i = 0; i < MALLOC_NUM_ARENAS; i++)
+    {
+        mspace arena = _arenas[i];
+
+        if (arena)
+        {
+            struct mallinfo info = mspace_mallinfo(arena);
+
+            _malloc_stats.peak_system_bytes += mspace_max_footprint(arena);
+            _malloc_stats.system_bytes += mspace_footprint(arena);
+            _malloc_stats.in_use_bytes += info.uordblks;
+        }
+    }
+#endif
+
     *stats = _malloc_stats;
 
     result = OE_OK;
@@ -235,3 +469,67 @@ done:
     oe_mutex_unlock(&_mutex);
     return result;
 }
+
+/*
+**==============================================================================
+**
+** oe_get_heap_stats()
+**
+**     Unlike oe_get_malloc_stats(), use dlmallinfo(), which also reports the
+**     free bytes (fordblks) and the releasable part of the top chunk
+**     (keepcost). Free bytes outside the top chunk are fragmentation.
+**
+**==============================================================================
+*/
+
+static void _add_mallinfo(
+    oe_heap_stats_t* stats,
+    const struct mallinfo* info,
+    size_t footprint,
+    size_t max_footprint)
+{
+    stats->system_bytes += footprint;
+    stats->peak_system_bytes += max_footprint;
+    stats->in_use_bytes += info->uordblks;
+    stats->free_bytes += info->fordblks;
+    stats->fragmented_bytes += info->fordblks - info->keepcost;
+}
+
+OE_MALLOC_EXPORT oe_result_t oe_get_heap_stats(oe_heap_stats_t* stats)
+{
+    const uint64_t heap_base = (uint64_t)__oe_get_heap_base();
+
+    if (!stats)
+        return OE_INVALID_PARAMETER;
+
+    oe_memset(stats, 0, sizeof(oe_heap_stats_t));
+
+    stats->heap_size = __oe_get_heap_size();
+    stats->sbrk_bytes = (uint64_t)oe_sbrk(0) - heap_base;
+    stats->peak_sbrk_bytes = (uint64_t)oe_sbrk_high_water_mark() - heap_base;
+
+    {
+        struct mallinfo info = dlmallinfo();
+        _add_mallinfo(
+            stats, &info, dlmalloc_footprint(), dlmalloc_max_footprint());
+    }
+
+#if defined(OE_MALLOC_THREAD_ARENAS)
+    for (size_t i = 0; i < MALLOC_NUM_ARENAS; i++)
+    {
+        mspace arena = _arenas[i];
+
+        if (arena)
+        {
+            struct mallinfo info = mspace_mallinfo(arena);
+            _add_mallinfo(
+                stats,
+                &info,
+                mspace_footprint(arena),
+                mspace_max_footprint(arena));
+        }
+    }
+#endif
+
+    return OE_OK;
+}
@@ -0,0 +1,6 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+/* The allocator with per-thread arenas, linked by OE_USE_THREAD_ARENAS() */
+#define OE_MALLOC_THREAD_ARENAS
+#include "malloc.c"
@@ -0,0 +1,330 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#define USE_DL_PREFIX
+#include <openenclave/enclave.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "../3rdparty/dlmalloc/dlmalloc/malloc.h"
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Object pools:
+**
+**     A pool carves objects of one size out of slabs of enclave heap pages.
+**     Free objects are kept in two places:
+**
+**         (1) The magazine of each thread: a small stack of objects that only
+**             that thread (TCS) uses, so it needs no lock.
+**         (2) The depot: a free list shared by all threads and guarded by the
+**             pool lock.
+**
+**     A thread whose magazine is empty refills half of it from the depot (or
+**     from the current slab) and a thread whose magazine is full returns half
+**     of it to the depot, so the lock is taken once per POOL_BATCH_SIZE
+**     operations at most.
+**
+**     Pools take their memory from dlmalloc directly rather than from
+**     oe_malloc(): the debug allocator does not track it, so pools that live
+**     as long as the enclave are not reported as leaks.
+**
+**==============================================================================
+*/
+
+/* Threads with a larger td_get_index() use the depot directly */
+#define POOL_MAX_THREADS 64
+
+#define POOL_MAGAZINE_SIZE 32
+#define POOL_BATCH_SIZE (POOL_MAGAZINE_SIZE / 2)
+
+#define POOL_MAX_OBJECT_SIZE (64 * 1024)
+#define POOL_MIN_SLAB_SIZE (4 * OE_PAGE_SIZE)
+
+/* Alignment of oe_malloc() */
+#define POOL_DEFAULT_ALIGNMENT 16
+
+typedef struct _pool_object
+{
+    struct _pool_object* next;
+} pool_object_t;
+
+typedef struct _pool_slab
+{
+    struct _pool_slab* next;
+} pool_slab_t;
+
+typedef struct _pool_magazine
+{
+    size_t count;
+    void* objects[POOL_MAGAZINE_SIZE];
+} pool_magazine_t;
+
+struct _oe_pool
+{
+    size_t object_size;
+    size_t slab_size;
+
+    /* Offset of the first object within each slab */
+    size_t slab_header_size;
+
+    /* Guards the fields below except for the magazines */
+    oe_spinlock_t lock;
+
+    /* The depot */
+    pool_object_t* free_list;
+
+    /* Unused space at the end of the most recent slab */
+    uint8_t* slab_next;
+    uint8_t* slab_end;
+
+    /* All the slabs, released by oe_pool_destroy() */
+    pool_slab_t* slabs;
+
+    /* Magazines indexed by td_get_index(), created on first use */
+    pool_magazine_t* magazines[POOL_MAX_THREADS];
+};
+
+/*
+**==============================================================================
+**
+** _get_objects()
+**
+**     Take up to count objects from the depot or from the slabs. Return the
+**     number of objects taken, which is zero if out of memory.
+**
+**==============================================================================
+*/
+
+static size_t _get_objects(oe_pool_t* pool, void** objects, size_t count)
+{
+    size_t n = 0;
+
+    oe_spin_lock(&pool->lock);
+
+    while (n < count && pool->free_list)
+    {
+        objects[n++] = pool->free_list;
+        pool->free_list = pool->free_list->next;
+    }
+
+    while (n < count)
+    {
+        if (pool->slab_next == pool->slab_end)
+        {
+            pool_slab_t* slab;
+
+            if (!(slab = dlmemalign(OE_PAGE_SIZE, pool->slab_size)))
+                break;
+
+            slab->next = pool->slabs;
+            pool->slabs = slab;
+            pool->slab_next = (uint8_t*)slab + pool->slab_header_size;
+            pool->slab_end = pool->slab_next +
+                             (pool->slab_size - pool->slab_header_size) /
+                                 pool->object_size * pool->object_size;
+        }
+
+        objects[n++] = pool->slab_next;
+        pool->slab_next += pool->object_size;
+    }
+
+    oe_spin_unlock(&pool->lock);
+
+    return n;
+}
+
+/*
+**==============================================================================
+**
+** _put_objects()
+**
+**     Return objects to the depot.
+**
+**==============================================================================
+*/
+
+static void _put_objects(oe_pool_t* pool, void** objects, size_t count)
+{
+    oe_spin_lock(&pool->lock);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        pool_object_t* object = (pool_object_t*)objects[i];
+
+        object->next = pool->free_list;
+        pool->free_list = object;
+    }
+
+    oe_spin_unlock(&pool->lock);
+}
+
+/*
+**==============================================================================
+**
+** _get_magazine()
+**
+**     Return the magazine of the calling thread or null if the thread has
+**     none (too many threads or out of memory).
+**
+**==============================================================================
+*/
+
+static pool_magazine_t* _get_magazine(oe_pool_t* pool)
+{
+    size_t index = td_get_index(oe_get_td());
+    pool_magazine_t* magazine;
+
+    if (index >= POOL_MAX_THREADS)
+        return NULL;
+
+    /* Only this thread ever sets this slot */
+    if (!(magazine = pool->magazines[index]))
+    {
+        magazine = (pool_magazine_t*)dlmalloc(sizeof(pool_magazine_t));
+
+        if (magazine)
+        {
+            magazine->count = 0;
+            pool->magazines[index] = magazine;
+        }
+    }
+
+    return magazine;
+}
+
+/*
+**==============================================================================
+**
+** oe_pool_create()
+**
+**==============================================================================
+*/
+
+oe_pool_t* oe_pool_create(size_t object_size, size_t alignment)
+{
+    oe_pool_t* pool;
+
+    if (object_size == 0 || object_size > POOL_MAX_OBJECT_SIZE)
+        return NULL;
+
+    if (alignment == 0)
+        alignment = POOL_DEFAULT_ALIGNMENT;
+
+    if ((alignment & (alignment - 1)) != 0 || alignment > OE_PAGE_SIZE)
+        return NULL;
+
+    /* Free objects hold the link of the depot */
+    if (alignment < sizeof(pool_object_t))
+        alignment = sizeof(pool_object_t);
+
+    if (!(pool = (oe_pool_t*)dlcalloc(1, sizeof(oe_pool_t))))
+        return NULL;
+
+    pool->object_size = oe_round_up_to_multiple(object_size, alignment);
+    pool->slab_header_size =
+        oe_round_up_to_multiple(sizeof(pool_slab_t), alignment);
+
+    /* A slab holds at least one magazine worth of objects */
+    pool->slab_size = oe_round_up_to_page_size(
+        pool->slab_header_size + POOL_MAGAZINE_SIZE * pool->object_size);
+
+    if (pool->slab_size < POOL_MIN_SLAB_SIZE)
+        pool->slab_size = POOL_MIN_SLAB_SIZE;
+
+    pool->lock = OE_SPINLOCK_INITIALIZER;
+
+    return pool;
+}
+
+/*
+**==============================================================================
+**
+** oe_pool_alloc()
+**
+**==============================================================================
+*/
+
+void* oe_pool_alloc(oe_pool_t* pool)
+{
+    pool_magazine_t* magazine;
+    void* object = NULL;
+
+    if (!pool)
+        return NULL;
+
+    if (!(magazine = _get_magazine(pool)))
+    {
+        _get_objects(pool, &object, 1);
+        return object;
+    }
+
+    if (magazine->count == 0)
+        magazine->count =
+            _get_objects(pool, magazine->objects, POOL_BATCH_SIZE);
+
+    if (magazine->count == 0)
+        return NULL;
+
+    return magazine->objects[--magazine->count];
+}
+
+/*
+**==============================================================================
+**
+** oe_pool_free()
+**
+**==============================================================================
+*/
+
+void oe_pool_free(oe_pool_t* pool, void* object)
+{
+    pool_magazine_t* magazine;
+
+    if (!pool || !object)
+        return;
+
+    if (!(magazine = _get_magazine(pool)))
+    {
+        _put_objects(pool, &object, 1);
+        return;
+    }
+
+    if (magazine->count == POOL_MAGAZINE_SIZE)
+    {
+        magazine->count -= POOL_BATCH_SIZE;
+        _put_objects(
+            pool, magazine->objects + magazine->count, POOL_BATCH_SIZE);
+    }
+
+    magazine->objects[magazine->count++] = object;
+}
+
+/*
+**==============================================================================
+**
+** oe_pool_destroy()
+**
+**==============================================================================
+*/
+
+void oe_pool_destroy(oe_pool_t* pool)
+{
+    if (!pool)
+        return;
+
+    for (size_t i = 0; i < POOL_MAX_THREADS; i++)
+        dlfree(pool->magazines[i]);
+
+    for (pool_slab_t* p = pool->slabs; p;)
+    {
+        pool_slab_t* next = p->next;
+        dlfree(p);
+        p = next;
+    }
+
+    oe_memset(pool, 0, sizeof(oe_pool_t));
+    dlfree(pool);
+}
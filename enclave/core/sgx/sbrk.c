@@ -2,31 +2,51 @@
 // Licensed under the MIT License.
 
 #include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/globals.h>
-#include <openenclave/internal/thread.h>
+
+/* Highest end of the heap (see oe_sbrk_high_water_mark()) */
+static volatile uint64_t _heap_peak;
 
 void* oe_sbrk(ptrdiff_t increment)
 {
-    static unsigned char* _heap_next;
-    static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
-    void* ptr = (void*)-1;
+    static volatile uint64_t _heap_next;
+    const uint64_t heap_end = (uint64_t)__oe_get_heap_end();
+    uint64_t next;
+    uint64_t peak;
+
+    if (!_heap_next)
+        oe_atomic_compare_and_swap(
+            &_heap_next, 0, (uint64_t)__oe_get_heap_base());
 
-    oe_spin_lock(&_lock);
+    /* Bump the break with a compare-and-swap rather than a lock */
+    do
     {
-        ptrdiff_t remaining;
+        next = _heap_next;
 
-        if (!_heap_next)
-            _heap_next = (unsigned char*)__oe_get_heap_base();
+        if (increment > (ptrdiff_t)(heap_end - next))
+            return (void*)-1;
+    } while (!oe_atomic_compare_and_swap(
+        &_heap_next, next, next + (uint64_t)increment));
+
+    /* Raise the high-water mark */
+    do
+    {
+        peak = _heap_peak;
 
-        remaining = (unsigned char*)__oe_get_heap_end() - _heap_next;
+        if (next + (uint64_t)increment <= peak)
+            break;
+    } while (!oe_atomic_compare_and_swap(
+        &_heap_peak, peak, next + (uint64_t)increment));
 
-        if (increment <= remaining)
-        {
-            ptr = _heap_next;
-            _heap_next += increment;
-        }
-    }
-    oe_spin_unlock(&_lock);
+    return (void*)next;
+}
+
+void* oe_sbrk_high_water_mark(void)
+{
+    if (!_heap_peak)
+        return (void*)__oe_get_heap_base();
 
-    return ptr;
+    return (void*)_heap_peak;
 }
@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "sharedregion.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/raise.h>
+
+/*
+** States of the shared region. The region is registered at most once and is
+** never unregistered: the host must keep it mapped until the enclave is
+** terminated.
+*/
+#define SHARED_REGION_UNREGISTERED 0
+#define SHARED_REGION_REGISTERING 1
+#define SHARED_REGION_REGISTERED 2
+
+static volatile uint64_t _state = SHARED_REGION_UNREGISTERED;
+
+/* The region (in host memory); valid once _state is REGISTERED */
+static volatile uint64_t _region_start;
+static volatile uint64_t _region_end;
+
+/*
+**==============================================================================
+**
+** oe_handle_register_shared_region()
+**
+**     Handle OE_ECALL_REGISTER_SHARED_REGION: check that the region lies
+**     outside the enclave and record it. This is the only time the region is
+**     validated; [shared] parameters are only checked against its bounds.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_register_shared_region(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_register_shared_region_args_t args, *args_ptr;
+    uint64_t end;
+
+    // Ensure that args lies outside the enclave.
+    if (!oe_is_outside_enclave(
+            (void*)arg_in, sizeof(oe_register_shared_region_args_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Copy args to enclave memory to avoid TOCTOU issues.
+    args_ptr = (oe_register_shared_region_args_t*)arg_in;
+    args = *args_ptr;
+
+    if (!args.data || args.size == 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!oe_is_outside_enclave(args.data, args.size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (oe_safe_add_u64((uint64_t)args.data, args.size, &end) != OE_OK)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Only one region may be registered (full barrier).
+    if (!oe_atomic_compare_and_swap(
+            &_state,
+            SHARED_REGION_UNREGISTERED,
+            SHARED_REGION_REGISTERING))
+        OE_RAISE(OE_UNSUPPORTED);
+
+    _region_start = (uint64_t)args.data;
+    _region_end = end;
+
+    // Publish the region (full barrier).
+    oe_atomic_compare_and_swap(
+        &_state, SHARED_REGION_REGISTERING, SHARED_REGION_REGISTERED);
+
+    args_ptr->result = OE_OK;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _is_within_shared_region()
+**
+**==============================================================================
+*/
+
+static bool _is_within_shared_region(const void* ptr, size_t size)
+{
+    uint64_t start = (uint64_t)ptr;
+    uint64_t end;
+
+    if (_state != SHARED_REGION_REGISTERED)
+        return false;
+
+    if (oe_safe_add_u64(start, size, &end) != OE_OK)
+        return false;
+
+    return start >= _region_start && end <= _region_end;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_shared_buffer()
+**
+**     Called by the oeedger8r-generated ecall wrappers for [shared]
+**     parameters. The host passes the pointer as it is (no marshalling), so
+**     this is the only copy of the data.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_shared_buffer(
+    const void* host_ptr,
+    size_t size,
+    bool copy_in,
+    void** buffer)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    void* ptr = NULL;
+
+    if (!buffer)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *buffer = NULL;
+
+    // Null pointers are passed through as for other parameters.
+    if (!host_ptr)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    if (!_is_within_shared_region(host_ptr, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Allocate at least one byte so that the parameter stays non-null.
+    if (!(ptr = oe_malloc(size ? size : 1)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    if (copy_in)
+        oe_memcpy(ptr, host_ptr, size);
+    else
+        oe_memset(ptr, 0, size);
+
+    *buffer = ptr;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_put_shared_buffer()
+**
+**==============================================================================
+*/
+
+void oe_put_shared_buffer(
+    void* host_ptr,
+    void* buffer,
+    size_t size,
+    bool copy_out)
+{
+    if (!buffer)
+        return;
+
+    // host_ptr was checked against the region by oe_get_shared_buffer().
+    if (copy_out && host_ptr)
+        oe_memcpy(host_ptr, buffer, size);
+
+    oe_free(buffer);
+}
@@ -0,0 +1,11 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef OE_SHAREDREGION_H
+#define OE_SHAREDREGION_H
+
+#include <openenclave/enclave.h>
+
+oe_result_t oe_handle_register_shared_region(uint64_t arg_in);
+
+#endif /* OE_SHAREDREGION_H */
@@ -8,18 +8,35 @@
 #include <openenclave/host.h>
 #endif
 
-/* Set the spinlock value to 1 and return the old value */
-static unsigned int _spin_set_locked(oe_spinlock_t* spinlock)
-{
-    unsigned int value = 1;
+/*
+**==============================================================================
+**
+** Ticket spin locks:
+**
+**     The low 16 bits of the lock hold the ticket being served and the high
+**     16 bits the next ticket to hand out; the lock is free when the two are
+**     equal (OE_SPINLOCK_INITIALIZER). A thread takes the next ticket with
+**     one atomic add and waits until its ticket is served, so threads get
+**     the lock in the order in which they asked for it. The owner releases
+**     it by serving the next ticket with a plain store.
+**
+**     A waiter pauses in proportion to the number of threads ahead of it
+**     (SPINLOCK_BACKOFF pauses each, up to SPINLOCK_MAX_BACKOFF) between two
+**     reads of the lock, so that the waiters far from the head of the line
+**     leave the cache line to the owner and to the next waiter.
+**
+**==============================================================================
+*/
+
+#define SPINLOCK_TICKET_SHIFT 16
+#define SPINLOCK_TICKET_MASK 0xffff
 
-    asm volatile("lock xchg %0, %1;"
-                 : "=r"(value)     /* %0 */
-                 : "m"(*spinlock), /* %1 */
-                   "0"(value)      /* also %2 */
-                 : "memory");
+#define SPINLOCK_BACKOFF 32
+#define SPINLOCK_MAX_BACKOFF 4096
 
-    return value;
+OE_INLINE void _spin_pause(void)
+{
+    asm volatile("pause" ::: "memory");
 }
 
 oe_result_t oe_spin_init(oe_spinlock_t* spinlock)
@@ -34,17 +51,54 @@ oe_result_t oe_spin_init(oe_spinlock_t* spinlock)
 
 oe_result_t oe_spin_lock(oe_spinlock_t* spinlock)
 {
+    uint32_t ticket;
+
     if (!spinlock)
         return OE_INVALID_PARAMETER;
 
-    while (_spin_set_locked((volatile unsigned int*)spinlock) != 0)
+    /* Take the next ticket */
+    ticket = __sync_fetch_and_add(spinlock, 1U << SPINLOCK_TICKET_SHIFT) >>
+             SPINLOCK_TICKET_SHIFT;
+
+    for (;;)
     {
-        /* Spin while waiting for spinlock to be released (become 1) */
-        while (*spinlock)
-        {
-            /* Yield to CPU */
-            asm volatile("pause");
-        }
+        uint32_t ahead = (ticket - *spinlock) & SPINLOCK_TICKET_MASK;
+        uint32_t pauses;
+
+        /* If this ticket is being served */
+        if (ahead == 0)
+            break;
+
+        /* The next waiter only pauses once */
+        pauses = (ahead - 1) * SPINLOCK_BACKOFF + 1;
+
+        if (pauses > SPINLOCK_MAX_BACKOFF)
+            pauses = SPINLOCK_MAX_BACKOFF;
+
+        while (pauses--)
+            _spin_pause();
+    }
+
+    return OE_OK;
+}
+
+oe_result_t oe_spin_trylock(oe_spinlock_t* spinlock)
+{
+    uint32_t value;
+
+    if (!spinlock)
+        return OE_INVALID_PARAMETER;
+
+    value = *spinlock;
+
+    /* Take the next ticket only if it would be served at once */
+    if ((value & SPINLOCK_TICKET_MASK) != (value >> SPINLOCK_TICKET_SHIFT))
+        return OE_BUSY;
+
+    if (!__sync_bool_compare_and_swap(
+            spinlock, value, value + (1U << SPINLOCK_TICKET_SHIFT)))
+    {
+        return OE_BUSY;
     }
 
     return OE_OK;
@@ -52,13 +106,22 @@ oe_result_t oe_spin_lock(oe_spinlock_t* spinlock)
 
 oe_result_t oe_spin_unlock(oe_spinlock_t* spinlock)
 {
+    volatile uint16_t* serving = (volatile uint16_t*)spinlock;
+    uint32_t value;
+
     if (!spinlock)
         return OE_INVALID_PARAMETER;
 
-    asm volatile("movl %0, %1;"
-                 :
-                 : "r"(OE_SPINLOCK_INITIALIZER), "m"(*spinlock) /* %1 */
-                 : "memory");
+    value = *spinlock;
+
+    /* Unlocking a free lock leaves it free */
+    if ((value & SPINLOCK_TICKET_MASK) == (value >> SPINLOCK_TICKET_SHIFT))
+        return OE_OK;
+
+    /* Serve the next ticket. Only the owner writes the low 16 bits, so a
+     * 16-bit store (a release on x86) is enough. */
+    asm volatile("" ::: "memory");
+    *serving = (uint16_t)(value + 1);
 
     return OE_OK;
 }
@@ -0,0 +1,621 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "switchless.h"
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/fault.h>
+#include <openenclave/internal/print.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/utils.h>
+#include "td.h"
+
+/*
+** Backoff policy of enclave workers: between two polls of an idle slot the
+** worker pauses for an exponentially growing number of iterations (up to
+** ENCLAVE_WORKER_MAX_BACKOFF). After ENCLAVE_WORKER_IDLE_LIMIT iterations
+** without work it parks on its TCS event (OE_OCALL_THREAD_WAIT) until a host
+** caller claims its slot.
+*/
+#define ENCLAVE_WORKER_MAX_BACKOFF 256
+#define ENCLAVE_WORKER_IDLE_LIMIT (1 << 20)
+
+/*
+** States of an oe_ocall_token_t. A thread in oe_ocall_wait_any() polls the
+** pending calls OCALL_WAIT_SPIN_COUNT times before it sleeps on its TCS
+** event (OE_OCALL_THREAD_WAIT) until a host worker completes one of them.
+*/
+#define OCALL_TOKEN_RELEASED 0
+#define OCALL_TOKEN_PENDING 1
+#define OCALL_TOKEN_COMPLETED 2
+#define OCALL_WAIT_SPIN_COUNT 4096
+
+/* Ring serviced by host worker threads (in host memory) */
+static oe_switchless_ring_t* _host_worker_ring;
+
+/* Copy of _host_worker_ring->num_slots taken at initialization time */
+static size_t _num_host_workers;
+
+/*
+**==============================================================================
+**
+** oe_initialize_switchless()
+**
+**     Called once during enclave initialization with the ring allocated by
+**     the host (or null if the host did not start any workers).
+**
+**==============================================================================
+*/
+
+oe_result_t oe_initialize_switchless(oe_switchless_ring_t* host_worker_ring)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (host_worker_ring)
+    {
+        size_t num_slots;
+
+        if (!oe_is_outside_enclave(host_worker_ring, sizeof(*host_worker_ring)))
+            OE_RAISE(OE_INVALID_PARAMETER);
+
+        /* Read the slot count only once since the host may change it */
+        num_slots = host_worker_ring->num_slots;
+
+        if (num_slots == 0 || num_slots > OE_SWITCHLESS_MAX_WORKERS)
+            OE_RAISE(OE_INVALID_PARAMETER);
+
+        _num_host_workers = num_slots;
+        _host_worker_ring = host_worker_ring;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _claim_host_worker()
+**
+**     Claim the slot of an idle host worker (IDLE -> CLAIMED). If none is
+**     available, count a fallback and ask the host to wake sleeping workers.
+**
+**==============================================================================
+*/
+
+static bool _claim_host_worker(oe_switchless_ring_t* ring, size_t* index)
+{
+    bool sleeping = false;
+
+    for (size_t i = 0; i < _num_host_workers; i++)
+    {
+        oe_switchless_slot_t* slot = &ring->slots[i];
+        uint64_t state = slot->state;
+
+        if (state == OE_SWITCHLESS_SLOT_IDLE &&
+            oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_IDLE,
+                OE_SWITCHLESS_SLOT_CLAIMED))
+        {
+            *index = i;
+            return true;
+        }
+
+        if (state == OE_SWITCHLESS_SLOT_SLEEPING)
+            sleeping = true;
+    }
+
+    /* No worker is free: ask the host to wake sleepers and use EEXIT */
+    oe_atomic_increment(&ring->fallbacks);
+
+    if (sleeping)
+        ring->wake_requested = 1;
+
+    return false;
+}
+
+/*
+**==============================================================================
+**
+** _post_to_host_worker()
+** _collect_from_host_worker()
+**
+**     Post the call to the given slot (already claimed by the caller). Once
+**     the host worker has set DONE, collect the results and hand the slot
+**     back.
+**
+**==============================================================================
+*/
+
+static void _post_to_host_worker(
+    oe_switchless_slot_t* slot,
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size)
+{
+    slot->args.host_function.function_id = function_id;
+    slot->args.host_function.input_buffer = input_buffer;
+    slot->args.host_function.input_buffer_size = input_buffer_size;
+    slot->args.host_function.output_buffer = output_buffer;
+    slot->args.host_function.output_buffer_size = output_buffer_size;
+    slot->args.host_function.output_bytes_written = 0;
+    slot->args.host_function.result = OE_UNEXPECTED;
+
+    /* Publish the request (full barrier) */
+    oe_atomic_compare_and_swap(
+        &slot->state, OE_SWITCHLESS_SLOT_CLAIMED, OE_SWITCHLESS_SLOT_POSTED);
+}
+
+static oe_result_t _collect_from_host_worker(
+    oe_switchless_slot_t* slot,
+    size_t* output_bytes_written)
+{
+    oe_result_t result;
+    size_t bytes_written;
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    /* Collect the results before handing the slot back */
+    result = slot->args.host_function.result;
+    bytes_written = slot->args.host_function.output_bytes_written;
+
+    oe_atomic_compare_and_swap(
+        &slot->state, OE_SWITCHLESS_SLOT_DONE, OE_SWITCHLESS_SLOT_IDLE);
+
+    if (result == OE_OK)
+        *output_bytes_written = bytes_written;
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_switchless_call_host_function()
+**
+**     Post the call to a free host worker and spin until it is dispatched;
+**     fall back to a regular OCALL when no worker is available.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_switchless_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    oe_switchless_ring_t* ring = _host_worker_ring;
+    size_t index;
+
+    /* Reject invalid parameters */
+    if (!input_buffer || input_buffer_size == 0)
+        return OE_INVALID_PARAMETER;
+
+    if (ring && _claim_host_worker(ring, &index))
+    {
+        oe_switchless_slot_t* slot = &ring->slots[index];
+
+        /* The host function may print: write what oe_host_printf() staged */
+        oe_host_flush(0);
+
+        _post_to_host_worker(
+            slot,
+            function_id,
+            input_buffer,
+            input_buffer_size,
+            output_buffer,
+            output_buffer_size);
+
+        while (slot->state != OE_SWITCHLESS_SLOT_DONE)
+            oe_pause();
+
+        return _collect_from_host_worker(slot, output_bytes_written);
+    }
+
+    return oe_call_host_function(
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written);
+}
+
+/*
+**==============================================================================
+**
+** oe_call_host_function_async()
+**
+**     Post the call to a free host worker and return; the token records the
+**     worker's slot. Without a free worker, make a regular OCALL and record
+**     its outcome in the token.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_host_function_async(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    oe_ocall_token_t* token)
+{
+    oe_switchless_ring_t* ring = _host_worker_ring;
+    size_t index;
+
+    /* Reject invalid parameters */
+    if (!token || token->state == OCALL_TOKEN_PENDING)
+        return OE_INVALID_PARAMETER;
+
+    /* The host accesses the buffers after this function returns */
+    if (!input_buffer || input_buffer_size == 0 ||
+        !oe_is_outside_enclave(input_buffer, input_buffer_size))
+        return OE_INVALID_PARAMETER;
+
+    if (!output_buffer || output_buffer_size == 0 ||
+        !oe_is_outside_enclave(output_buffer, output_buffer_size))
+        return OE_INVALID_PARAMETER;
+
+    token->result = OE_UNEXPECTED;
+    token->output_bytes_written = 0;
+
+    if (ring && _claim_host_worker(ring, &index))
+    {
+        /* The host function may print: write what oe_host_printf() staged */
+        oe_host_flush(0);
+
+        /* Clear any waiter before the host worker can see the request */
+        ring->waiters[index] = 0;
+
+        _post_to_host_worker(
+            &ring->slots[index],
+            function_id,
+            input_buffer,
+            input_buffer_size,
+            output_buffer,
+            output_buffer_size);
+
+        token->slot = index + 1;
+        token->state = OCALL_TOKEN_PENDING;
+    }
+    else
+    {
+        token->result = oe_call_host_function(
+            function_id,
+            input_buffer,
+            input_buffer_size,
+            output_buffer,
+            output_buffer_size,
+            &token->output_bytes_written);
+
+        token->slot = 0;
+        token->state = OCALL_TOKEN_COMPLETED;
+    }
+
+    return OE_OK;
+}
+
+/*
+**==============================================================================
+**
+** _complete_ocall_token()
+** _release_ocall_token()
+**
+**     Move a pending token whose host worker is done to COMPLETED. Return
+**     the outcome of a completed token and release it.
+**
+**==============================================================================
+*/
+
+static bool _complete_ocall_token(oe_ocall_token_t* token)
+{
+    if (token->state == OCALL_TOKEN_PENDING)
+    {
+        oe_switchless_slot_t* slot = &_host_worker_ring->slots[token->slot - 1];
+
+        if (slot->state != OE_SWITCHLESS_SLOT_DONE)
+            return false;
+
+        token->result =
+            _collect_from_host_worker(slot, &token->output_bytes_written);
+        token->slot = 0;
+        token->state = OCALL_TOKEN_COMPLETED;
+    }
+
+    return token->state == OCALL_TOKEN_COMPLETED;
+}
+
+static oe_result_t _release_ocall_token(
+    oe_ocall_token_t* token,
+    size_t* output_bytes_written)
+{
+    if (token->result == OE_OK)
+        *output_bytes_written = token->output_bytes_written;
+
+    token->state = OCALL_TOKEN_RELEASED;
+
+    return token->result;
+}
+
+/*
+**==============================================================================
+**
+** oe_ocall_poll()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_ocall_poll(oe_ocall_token_t* token, size_t* output_bytes_written)
+{
+    /* Reject invalid parameters */
+    if (!token || !output_bytes_written)
+        return OE_INVALID_PARAMETER;
+
+    if (token->state == OCALL_TOKEN_RELEASED)
+        return OE_NOT_FOUND;
+
+    if (!_complete_ocall_token(token))
+        return OE_BUSY;
+
+    return _release_ocall_token(token, output_bytes_written);
+}
+
+/*
+**==============================================================================
+**
+** _park_ocall_waiter()
+**
+**     Register the calling thread as the waiter of each pending call and
+**     sleep on its TCS event unless one of them completed meanwhile. Both
+**     this thread (waiter then state) and the host worker (state then
+**     waiter) use full barriers, so at least one of them sees the other.
+**
+**     Every waiter that a host worker took is a wake-up signaled on the TCS
+**     event. Wake-ups not consumed by the sleep are consumed before
+**     returning so that later waits on this TCS are not cut short.
+**
+**==============================================================================
+*/
+
+static void _park_ocall_waiter(oe_ocall_token_t* tokens, size_t num_tokens)
+{
+    oe_switchless_ring_t* ring = _host_worker_ring;
+    const uint64_t tcs = (uint64_t)td_to_tcs(oe_get_td());
+    bool completed = false;
+    size_t taken = 0;
+    size_t consumed = 0;
+
+    for (size_t i = 0; i < num_tokens; i++)
+    {
+        if (tokens[i].state == OCALL_TOKEN_PENDING)
+            oe_atomic_compare_and_swap(
+                &ring->waiters[tokens[i].slot - 1], 0, tcs);
+    }
+
+    for (size_t i = 0; i < num_tokens; i++)
+    {
+        if (tokens[i].state == OCALL_TOKEN_PENDING &&
+            ring->slots[tokens[i].slot - 1].state == OE_SWITCHLESS_SLOT_DONE)
+        {
+            completed = true;
+        }
+    }
+
+    if (!completed)
+    {
+        oe_ocall(OE_OCALL_THREAD_WAIT, tcs, NULL);
+        consumed++;
+    }
+
+    for (size_t i = 0; i < num_tokens; i++)
+    {
+        if (tokens[i].state == OCALL_TOKEN_PENDING &&
+            !oe_atomic_compare_and_swap(
+                &ring->waiters[tokens[i].slot - 1], tcs, 0))
+        {
+            taken++;
+        }
+    }
+
+    for (; consumed < taken; consumed++)
+        oe_ocall(OE_OCALL_THREAD_WAIT, tcs, NULL);
+}
+
+/*
+**==============================================================================
+**
+** oe_ocall_wait_any()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_ocall_wait_any(
+    oe_ocall_token_t* tokens,
+    size_t num_tokens,
+    size_t* index,
+    size_t* output_bytes_written)
+{
+    size_t spins = 0;
+
+    /* Reject invalid parameters */
+    if (!tokens || !index || !output_bytes_written)
+        return OE_INVALID_PARAMETER;
+
+    for (;;)
+    {
+        bool pending = false;
+
+        for (size_t i = 0; i < num_tokens; i++)
+        {
+            if (tokens[i].state == OCALL_TOKEN_RELEASED)
+                continue;
+
+            if (_complete_ocall_token(&tokens[i]))
+            {
+                *index = i;
+                return _release_ocall_token(&tokens[i], output_bytes_written);
+            }
+
+            pending = true;
+        }
+
+        if (!pending)
+            return OE_NOT_FOUND;
+
+        if (++spins < OCALL_WAIT_SPIN_COUNT)
+        {
+            oe_pause();
+        }
+        else
+        {
+            _park_ocall_waiter(tokens, num_tokens);
+            spins = 0;
+        }
+    }
+}
+
+/*
+**==============================================================================
+**
+** _park_enclave_worker()
+**
+**     Publish SLEEPING and wait on this thread's TCS event. A host caller
+**     that claims a sleeping slot (SLEEPING -> CLAIMED) signals the event.
+**
+**==============================================================================
+*/
+
+static void _park_enclave_worker(
+    oe_switchless_ring_t* ring,
+    oe_switchless_slot_t* slot,
+    const void* tcs)
+{
+    if (oe_atomic_compare_and_swap(
+            &slot->state, OE_SWITCHLESS_SLOT_IDLE, OE_SWITCHLESS_SLOT_SLEEPING))
+    {
+        /* Recheck after publishing SLEEPING so a concurrent stop is seen */
+        if (!ring->stop)
+            oe_ocall(OE_OCALL_THREAD_WAIT, (uint64_t)tcs, NULL);
+
+        /* No-op if a caller claimed the slot while this worker slept */
+        oe_atomic_compare_and_swap(
+            &slot->state, OE_SWITCHLESS_SLOT_SLEEPING, OE_SWITCHLESS_SLOT_IDLE);
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_switchless_worker()
+**
+**     Handle OE_ECALL_SWITCHLESS_WORKER: poll one slot of the ring serviced
+**     by enclave workers and dispatch posted enclave function calls until
+**     the host stops the ring.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_switchless_worker(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_worker_args_t* args = (oe_switchless_worker_args_t*)arg_in;
+    oe_switchless_worker_args_t safe_args;
+    oe_switchless_ring_t* ring;
+    oe_switchless_slot_t* slot;
+    const void* tcs = td_to_tcs(oe_get_td());
+    size_t backoff = 1;
+    size_t idle = 0;
+
+    if (!oe_is_outside_enclave(args, sizeof(*args)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Copy structure into enclave memory */
+    safe_args = *args;
+    ring = safe_args.ring;
+
+    if (!oe_is_outside_enclave(ring, sizeof(*ring)) ||
+        safe_args.slot >= OE_SWITCHLESS_MAX_WORKERS)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    slot = &ring->slots[safe_args.slot];
+
+    /* Tell the host which TCS to signal, then accept requests */
+    args->tcs = (uint64_t)tcs;
+    oe_atomic_compare_and_swap(
+        &slot->state, OE_SWITCHLESS_SLOT_OFFLINE, OE_SWITCHLESS_SLOT_IDLE);
+
+    while (!ring->stop)
+    {
+        uint64_t state = slot->state;
+
+        if (state == OE_SWITCHLESS_SLOT_POSTED)
+        {
+            oe_call_enclave_function_args_t* call = &slot->args.enclave_function;
+            oe_result_t call_result;
+
+            OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+            /* Results of successful calls are written to the slot already */
+            call_result = oe_handle_call_enclave_function((uint64_t)call);
+
+            if (call_result != OE_OK)
+                call->result = call_result;
+
+            /* The worker's own ECALL returns only when it stops: write the
+             * partial line the ECALL left, as if it had returned */
+            oe_host_flush(0);
+
+            oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_POSTED,
+                OE_SWITCHLESS_SLOT_DONE);
+
+            backoff = 1;
+            idle = 0;
+        }
+        else if (state == OE_SWITCHLESS_SLOT_IDLE)
+        {
+            if (idle >= ENCLAVE_WORKER_IDLE_LIMIT)
+            {
+                _park_enclave_worker(ring, slot, tcs);
+                backoff = 1;
+                idle = 0;
+                continue;
+            }
+
+            for (size_t i = 0; i < backoff; i++)
+                oe_pause();
+
+            idle += backoff;
+
+            if (backoff < ENCLAVE_WORKER_MAX_BACKOFF)
+                backoff *= 2;
+        }
+        else
+        {
+            /* A host caller owns the slot */
+            oe_pause();
+        }
+    }
+
+    /* Stop accepting requests */
+    oe_atomic_compare_and_swap(
+        &slot->state, OE_SWITCHLESS_SLOT_IDLE, OE_SWITCHLESS_SLOT_OFFLINE);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -0,0 +1,16 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef OE_SWITCHLESS_H
+#define OE_SWITCHLESS_H
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/switchless.h>
+
+oe_result_t oe_initialize_switchless(oe_switchless_ring_t* host_worker_ring);
+
+oe_result_t oe_handle_switchless_worker(uint64_t arg_in);
+
+oe_result_t oe_handle_call_enclave_function(uint64_t arg_in);
+
+#endif /* OE_SWITCHLESS_H */
@@ -4,11 +4,13 @@
 #include "td.h"
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/fault.h>
 #include <openenclave/internal/globals.h>
 #include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
 #include "asmdefs.h"
 #include "thread.h"
@@ -19,6 +21,22 @@
 
 #define TD_FROM_TCS (4 * OE_PAGE_SIZE)
 
+/* Bounds of the per-thread host arena (see td_host_arena_alloc()) */
+#define TD_HOST_ARENA_MIN_SIZE (4 * OE_PAGE_SIZE)
+#define TD_HOST_ARENA_MAX_SIZE (256 * OE_PAGE_SIZE)
+
+/* Largest ECALL scratch buffer kept between ECALLs */
+size_t oe_ecall_buffer_high_water_mark = OE_ECALL_BUFFER_HIGH_WATER_MARK;
+
+/* Set once td_free_buffers() has released the per-thread buffers */
+static bool _buffers_freed;
+
+/* Number of indices handed out by td_get_index() */
+static volatile uint64_t _num_indices;
+
+/* Per-thread state indexed by td_get_index() (see td_get_state()) */
+static td_state_t _states[OE_SGX_MAX_TCS];
+
 OE_STATIC_ASSERT(OE_OFFSETOF(td_t, magic) == td_magic);
 OE_STATIC_ASSERT(OE_OFFSETOF(td_t, depth) == td_depth);
 OE_STATIC_ASSERT(OE_OFFSETOF(td_t, host_rcx) == td_host_rcx);
@@ -204,6 +222,47 @@ bool td_initialized(td_t* td)
     return false;
 }
 
+/*
+**==============================================================================
+**
+** td_get_index()
+**
+**     Return a small index that is unique to this thread (TCS). Indices are
+**     assigned in order on first use and never change, so they stay below the
+**     number of TCSs of the enclave.
+**
+**==============================================================================
+*/
+
+size_t td_get_index(td_t* td)
+{
+    if (td->index == 0)
+        td->index = (uint32_t)oe_atomic_increment(&_num_indices);
+
+    return (size_t)(td->index - 1);
+}
+
+/*
+**==============================================================================
+**
+** td_get_state()
+**
+**     Return the per-thread state of oecore for this thread (see
+**     td_state_t). An enclave has at most OE_SGX_MAX_TCS threads.
+**
+**==============================================================================
+*/
+
+td_state_t* td_get_state(td_t* td)
+{
+    size_t index = td_get_index(td);
+
+    if (index >= OE_SGX_MAX_TCS)
+        oe_abort();
+
+    return &_states[index];
+}
+
 /*
 **==============================================================================
 **
@@ -307,3 +366,238 @@ void td_clear(td_t* td)
 
     /* Never clear td_t.initialized nor host registers */
 }
+
+/*
+**==============================================================================
+**
+** td_host_arena_alloc()
+**
+**     Allocate host memory for an OCALL from the host arena of this thread.
+**     The arena is allocated by the first call and is grown (only while it
+**     is empty) when a request does not fit. Requests that cannot be served
+**     from the arena fall back to oe_host_malloc(). Allocations should be
+**     released in reverse order with td_host_arena_free(), as an arena block
+**     is only reclaimed once every block allocated after it is freed.
+**
+**     Serving the OCALL arguments and marshalling buffers from the arena
+**     saves the OE_OCALL_MALLOC and OE_OCALL_FREE transitions that would
+**     otherwise surround every OCALL.
+**
+**==============================================================================
+*/
+
+void* td_host_arena_alloc(td_t* td, size_t size)
+{
+    td_state_t* state;
+    void* ptr;
+
+    if (size > TD_HOST_ARENA_MAX_SIZE)
+        return oe_host_malloc(size);
+
+    size = oe_round_up_to_multiple(size, sizeof(uint64_t));
+    state = td_get_state(td);
+
+    if (state->host_arena_num_blocks == TD_HOST_ARENA_MAX_BLOCKS)
+        return oe_host_malloc(size);
+
+    if (size > state->host_arena_size - state->host_arena_used)
+    {
+        uint8_t* arena;
+        size_t arena_size;
+
+        /* Cannot move the arena while it holds live allocations */
+        if (state->host_arena_used != 0 || _buffers_freed)
+            return oe_host_malloc(size);
+
+        arena_size = state->host_arena_size * 2;
+
+        if (arena_size < TD_HOST_ARENA_MIN_SIZE)
+            arena_size = TD_HOST_ARENA_MIN_SIZE;
+
+        if (arena_size < size)
+            arena_size = oe_round_up_to_multiple(size, OE_PAGE_SIZE);
+
+        if (!(arena = oe_host_malloc(arena_size)))
+            return NULL;
+
+        if (state->host_arena)
+            oe_host_free(state->host_arena);
+
+        state->host_arena = arena;
+        state->host_arena_size = arena_size;
+    }
+
+    ptr = state->host_arena + state->host_arena_used;
+    state->host_arena_blocks[state->host_arena_num_blocks++] =
+        state->host_arena_used;
+    state->host_arena_used += size;
+
+    return ptr;
+}
+
+/*
+**==============================================================================
+**
+** td_host_arena_free()
+**
+**     Release memory obtained from td_host_arena_alloc(). Freeing the most
+**     recent arena block returns it to the arena, along with the blocks
+**     below it that were already freed. Freeing any other arena block only
+**     marks it, so that the blocks allocated after it stay intact.
+**
+**==============================================================================
+*/
+
+void td_host_arena_free(td_t* td, void* ptr)
+{
+    uint8_t* p = (uint8_t*)ptr;
+    td_state_t* state;
+
+    if (!p)
+        return;
+
+    state = td_get_state(td);
+
+    if (state->host_arena && p >= state->host_arena &&
+        p < state->host_arena + state->host_arena_size)
+    {
+        size_t* blocks = state->host_arena_blocks;
+        size_t offset = (size_t)(p - state->host_arena);
+        size_t n = state->host_arena_num_blocks;
+
+        /* Find the block (usually the most recent one) */
+        while (n > 0 && (blocks[n - 1] & ~(size_t)1) != offset)
+            n--;
+
+        /* Not a live block */
+        if (n == 0)
+            return;
+
+        /* Blocks allocated after this one are still live */
+        if (n < state->host_arena_num_blocks)
+        {
+            blocks[n - 1] |= 1;
+            return;
+        }
+
+        /* Pop this block and the freed blocks below it */
+        n--;
+
+        while (n > 0 && (blocks[n - 1] & 1))
+            n--;
+
+        state->host_arena_num_blocks = n;
+        state->host_arena_used = blocks[n] & ~(size_t)1;
+    }
+    else
+    {
+        oe_host_free(ptr);
+    }
+}
+
+/*
+**==============================================================================
+**
+** td_get_ecall_buffer()
+**
+**     Take the ECALL scratch buffer of this thread, growing it to at least
+**     the given size. The buffer is detached from the thread until it is
+**     handed back with td_put_ecall_buffer(), so a nested ECALL (made by the
+**     host while this one is in an OCALL) gets a buffer of its own.
+**
+**     Reusing the buffer keeps the common ECALL path off the enclave heap
+**     and its global lock.
+**
+**==============================================================================
+*/
+
+uint8_t* td_get_ecall_buffer(td_t* td, size_t size, size_t* buffer_size)
+{
+    td_state_t* state = td_get_state(td);
+    uint8_t* buffer = state->ecall_buffer;
+
+    if (buffer && state->ecall_buffer_size >= size)
+    {
+        *buffer_size = state->ecall_buffer_size;
+    }
+    else
+    {
+        oe_free(buffer);
+
+        if (!(buffer = oe_malloc(size)))
+            return NULL;
+
+        *buffer_size = size;
+    }
+
+    state->ecall_buffer = NULL;
+    state->ecall_buffer_size = 0;
+
+    return buffer;
+}
+
+/*
+**==============================================================================
+**
+** td_put_ecall_buffer()
+**
+**     Hand a buffer obtained from td_get_ecall_buffer() back to this thread.
+**     Buffers larger than oe_ecall_buffer_high_water_mark are freed so that
+**     a single large ECALL does not pin its buffer for the thread lifetime.
+**
+**==============================================================================
+*/
+
+void td_put_ecall_buffer(td_t* td, uint8_t* buffer, size_t buffer_size)
+{
+    td_state_t* state = td_get_state(td);
+
+    if (state->ecall_buffer || _buffers_freed ||
+        buffer_size > oe_ecall_buffer_high_water_mark)
+    {
+        oe_free(buffer);
+        return;
+    }
+
+    state->ecall_buffer = buffer;
+    state->ecall_buffer_size = buffer_size;
+}
+
+/*
+**==============================================================================
+**
+** td_free_buffers()
+**
+**     Release the per-thread buffers (host arenas and ECALL scratch buffers)
+**     of all threads. Called by the enclave destructor; later requests are
+**     served without caching.
+**
+**==============================================================================
+*/
+
+void td_free_buffers(void)
+{
+    size_t num_states = (size_t)_num_indices;
+
+    _buffers_freed = true;
+
+    if (num_states > OE_SGX_MAX_TCS)
+        num_states = OE_SGX_MAX_TCS;
+
+    for (size_t i = 0; i < num_states; i++)
+    {
+        td_state_t* state = &_states[i];
+
+        if (state->host_arena)
+            oe_host_free(state->host_arena);
+
+        state->host_arena = NULL;
+        state->host_arena_size = 0;
+        state->host_arena_used = 0;
+        state->host_arena_num_blocks = 0;
+
+        oe_free(state->ecall_buffer);
+        state->ecall_buffer = NULL;
+        state->ecall_buffer_size = 0;
+    }
+}
@@ -54,6 +54,46 @@ struct _callsite
     Callsite* next;
 };
 
+/*
+**==============================================================================
+**
+** td_state_t
+**
+**     Per-thread state of oecore that is kept in a table indexed by
+**     td_get_index() rather than in td_t, whose free space is left to the
+**     thread-local variables of the enclave (see OE_THREAD_LOCAL_SPACE).
+**
+**==============================================================================
+*/
+
+/* Live blocks of a host arena that are tracked; further allocations are
+ * served by oe_host_malloc() */
+#define TD_HOST_ARENA_MAX_BLOCKS 32
+
+typedef struct _td_state
+{
+    /* Host memory arena from which ocall arguments and marshalling buffers
+     * are allocated (see td_host_arena_alloc()) */
+    uint8_t* host_arena;
+    size_t host_arena_size;
+    size_t host_arena_used;
+
+    /* Offsets of the live arena blocks in allocation order. The low bit is
+     * set once a block has been freed before the blocks above it. Kept in
+     * enclave memory since the host can write to the arena */
+    size_t host_arena_blocks[TD_HOST_ARENA_MAX_BLOCKS];
+    size_t host_arena_num_blocks;
+
+    /* Enclave memory scratch buffer for ECALL marshalling (see
+     * td_get_ecall_buffer()) */
+    uint8_t* ecall_buffer;
+    size_t ecall_buffer_size;
+
+    /* Bytes left to allocate before the next heap profile sample (see
+     * oe_heap_profile_sample()) */
+    size_t heap_profile_bytes;
+} td_state_t;
+
 /*
 **==============================================================================
 **
@@ -76,4 +116,18 @@ void td_clear(td_t* td);
 
 bool td_initialized(td_t* td);
 
+size_t td_get_index(td_t* td);
+
+td_state_t* td_get_state(td_t* td);
+
+void* td_host_arena_alloc(td_t* td, size_t size);
+
+void td_host_arena_free(td_t* td, void* ptr);
+
+uint8_t* td_get_ecall_buffer(td_t* td, size_t size, size_t* buffer_size);
+
+void td_put_ecall_buffer(td_t* td, uint8_t* buffer, size_t buffer_size);
+
+void td_free_buffers(void);
+
 #endif /* _TD_H */
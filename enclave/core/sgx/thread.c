@@ -6,6 +6,7 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/fault.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/thread.h>
@@ -114,6 +115,28 @@ static bool _queue_contains(Queue* queue, oe_thread_data_t* thread)
     return false;
 }
 
+static void _queue_remove(Queue* queue, oe_thread_data_t* thread)
+{
+    oe_thread_data_t* prev = NULL;
+    oe_thread_data_t* p;
+
+    for (p = queue->front; p; prev = p, p = p->next)
+    {
+        if (p == thread)
+        {
+            if (prev)
+                prev->next = p->next;
+            else
+                queue->front = p->next;
+
+            if (queue->back == p)
+                queue->back = prev;
+
+            return;
+        }
+    }
+}
+
 static __inline__ bool _queue_empty(Queue* queue)
 {
     return queue->front ? false : true;
@@ -145,6 +168,22 @@ bool oe_thread_equal(oe_thread_t thread1, oe_thread_t thread2)
 **==============================================================================
 */
 
+/*
+** A thread that finds the mutex locked spins (up to oe_mutex_spin_count
+** polls) until the owner releases it, and only then queues itself and asks
+** the host to put it to sleep. Unlocking wakes the thread at the front of
+** the queue, and only if the queue is not empty: spinning threads are not
+** queued, so an uncontended unlock or one that only spinning threads wait
+** for makes no OCALL.
+**
+** The mutex is not handed to the woken thread: any thread may take it once
+** it is released (as with a futex), and a woken thread that finds it taken
+** again spins and queues itself at the back.
+*/
+
+/* Tunable number of polls of a locked mutex before sleeping */
+uint32_t oe_mutex_spin_count = OE_MUTEX_SPIN_COUNT;
+
 /* Internal mutex implementation */
 typedef struct _oe_mutex_impl
 {
@@ -157,7 +196,7 @@ typedef struct _oe_mutex_impl
     /* The thread that has locked this mutex */
     oe_thread_data_t* owner;
 
-    /* Queue of waiting threads (front holds the mutex) */
+    /* Queue of sleeping threads (the front one is woken by the next unlock) */
     Queue queue;
 } oe_mutex_impl_t;
 
@@ -190,38 +229,37 @@ static int _mutex_lock(oe_mutex_impl_t* m, oe_thread_data_t* self)
         return 0;
     }
 
-    /* If no thread has locked this mutex yet */
+    /* If no thread has locked this mutex */
     if (m->owner == NULL)
     {
-        /* If the waiters queue is empty */
-        if (m->queue.front == NULL)
-        {
-            /* Obtain the mutex */
-            m->owner = self;
-            m->refs = 1;
-            return 0;
-        }
+        /* A thread that woke up spuriously may still be queued */
+        if (m->queue.front)
+            _queue_remove(&m->queue, self);
 
-        /* If this thread is at the front of the waiters queue */
-        if (m->queue.front == self)
-        {
-            /* Remove this thread from front of the waiters queue */
-            _queue_pop_front(&m->queue);
-
-            /* Obtain the mutex */
-            m->owner = self;
-            m->refs = 1;
-            return 0;
-        }
+        /* Obtain the mutex */
+        m->owner = self;
+        m->refs = 1;
+        return 0;
     }
 
     return -1;
 }
 
+/* Poll the owner of the mutex without the spinlock until the mutex is
+ * released or the spin budget runs out */
+static void _mutex_spin(oe_mutex_impl_t* m)
+{
+    volatile oe_mutex_impl_t* vm = m;
+
+    for (uint32_t i = 0; i < oe_mutex_spin_count && vm->owner; i++)
+        oe_pause();
+}
+
 oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
 {
     oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
     oe_thread_data_t* self = oe_get_thread_data();
+    bool spin = true;
 
     if (!m)
         return OE_INVALID_PARAMETER;
@@ -238,8 +276,8 @@ oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
                 return OE_OK;
             }
 
-            /* If the waiters queue does not contain this thread */
-            if (!_queue_contains(&m->queue, self))
+            /* If this thread is about to sleep and is not queued yet */
+            if (!spin && !_queue_contains(&m->queue, self))
             {
                 /* Insert thread at back of waiters queue */
                 _queue_push_back(&m->queue, self);
@@ -247,8 +285,18 @@ oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
         }
         oe_spin_unlock(&m->lock);
 
-        /* Ask host to wait for an event on this thread */
-        _thread_wait(self);
+        if (spin)
+        {
+            /* Wait for the owner to release the mutex for a while */
+            _mutex_spin(m);
+            spin = false;
+        }
+        else
+        {
+            /* Ask host to wait for an event on this thread */
+            _thread_wait(self);
+            spin = true;
+        }
     }
 
     /* Unreachable! */
@@ -293,8 +341,8 @@ static int _mutex_unlock(oe_mutex_t* mutex, oe_thread_data_t** waiter)
                 /* Thread no longer has this mutex locked */
                 m->owner = NULL;
 
-                /* Set waiter to the next thread on the queue (maybe none) */
-                *waiter = m->queue.front;
+                /* Take the next sleeping thread off the queue (maybe none) */
+                *waiter = _queue_pop_front(&m->queue);
             }
 
             ret = 0;
@@ -513,13 +561,54 @@ oe_result_t oe_cond_broadcast(oe_cond_t* condition)
 **==============================================================================
 */
 
+/*
+** Readers and writers synchronize through the spinlock and queue of the
+** lock, except for readers of a read-biased lock: these announce themselves
+** in their own thread's row of _reader_slots (a cache line that no other
+** thread writes) and do not touch the lock, so that readers on different
+** cores do not contend for its cache line.
+**
+** A writer revokes the bias before it takes the lock: it marks the lock as
+** RWLOCK_REVOKING and then sleeps in the queue (OE_OCALL_THREAD_WAIT) until
+** no reader slot holds the lock any more. A reader that sees the bias gone
+** after announcing itself withdraws and takes the slow path, and a reader
+** that leaves its slot while the bias is being revoked wakes the queue.
+**
+** The bias is granted again once RWLOCK_REBIAS_READS read locks have been
+** taken through the slow path with no writer holding or waiting for the
+** lock, so locks that are written often stay on the slow path.
+*/
+
+/* Threads with a larger td_get_index() always take the slow path */
+#define RWLOCK_MAX_THREADS 64
+
+/* Reader slots of each thread (a thread holding several locks for reading
+ * uses the slow path for those that map to a slot in use) */
+#define RWLOCK_READER_SLOTS 8
+
+#define RWLOCK_REBIAS_READS 256
+
+/* Values of oe_rwlock_impl_t.bias */
+#define RWLOCK_UNBIASED 0
+#define RWLOCK_BIASED 1
+#define RWLOCK_REVOKING 2
+
+typedef struct _rwlock_reader_slots
+{
+    /* Locks held for reading by this thread through the fast path */
+    volatile uint64_t slots[RWLOCK_READER_SLOTS];
+} OE_ALIGNED(64) rwlock_reader_slots_t;
+
+/* Reader slots indexed by td_get_index() */
+static rwlock_reader_slots_t _reader_slots[RWLOCK_MAX_THREADS];
+
 /* Internal readers-writer lock variable implementation. */
 typedef struct _oe_rwlock_impl
 {
     /* Spinlock for synchronizing readers and writers.*/
     oe_spinlock_t lock;
 
-    /* Number of reader threads owning this lock. */
+    /* Number of reader threads owning this lock through the slow path. */
     uint32_t readers;
 
     /* The writer thread that currently owns this lock.*/
@@ -528,10 +617,146 @@ typedef struct _oe_rwlock_impl
     /* Queue of threads waiting on this variable. */
     Queue queue;
 
+    /* Whether readers may use their reader slots (RWLOCK_BIASED). */
+    volatile uint32_t bias;
+
+    /* Read locks taken through the slow path since the bias was revoked. */
+    uint32_t slow_reads;
+
 } oe_rwlock_impl_t;
 
 OE_STATIC_ASSERT(sizeof(oe_rwlock_impl_t) <= sizeof(oe_rwlock_t));
 
+static size_t _reader_slot_index(oe_rwlock_impl_t* rw_lock)
+{
+    return (size_t)(((uint64_t)rw_lock >> 3) % RWLOCK_READER_SLOTS);
+}
+
+/* Return the reader slot of the calling thread for this lock, or NULL if
+ * the thread has no reader slots */
+static volatile uint64_t* _get_reader_slot(oe_rwlock_impl_t* rw_lock)
+{
+    size_t index = td_get_index((td_t*)oe_get_thread_data());
+
+    if (index >= RWLOCK_MAX_THREADS)
+        return NULL;
+
+    return &_reader_slots[index].slots[_reader_slot_index(rw_lock)];
+}
+
+/* Check whether any thread holds the lock through its reader slot. The
+ * caller has taken the bias away. */
+static bool _has_slot_readers(oe_rwlock_impl_t* rw_lock)
+{
+    size_t n = _reader_slot_index(rw_lock);
+
+    for (size_t i = 0; i < RWLOCK_MAX_THREADS; i++)
+    {
+        if (_reader_slots[i].slots[n] == (uint64_t)rw_lock)
+            return true;
+    }
+
+    return false;
+}
+
+// The current thread must hold the spinlock.
+// _wake_waiters releases ownership of the spinlock.
+static oe_result_t _wake_waiters(oe_rwlock_impl_t* rw_lock)
+{
+    oe_thread_data_t* p = NULL;
+    Queue waiters = {NULL, NULL};
+
+    // Take a snapshot of current list of waiters.
+    while ((p = _queue_pop_front(&rw_lock->queue)))
+        _queue_push_back(&waiters, p);
+
+    // Release the lock and wake up the waiters. This allows waiter that is
+    // woken up to immediately acquire the spinlock and subsequently, the
+    // ownership of the rw_lock.
+    oe_spin_unlock(&rw_lock->lock);
+
+    // Wake the waiters in FIFO order. However actual acquisition of the lock
+    // will be dependent on OS scheduling of the threads.
+    while ((p = _queue_pop_front(&waiters)))
+        _thread_wake(p);
+
+    return OE_OK;
+}
+
+// Release a read lock held through the reader slot.
+static void _fast_rdunlock(oe_rwlock_impl_t* rw_lock, volatile uint64_t* slot)
+{
+    *slot = 0;
+
+    // Clear the slot before checking the bias (see _revoke_bias()).
+    __sync_synchronize();
+
+    // A writer may be waiting for this reader to leave.
+    if (rw_lock->bias != RWLOCK_BIASED)
+    {
+        oe_spin_lock(&rw_lock->lock);
+        _wake_waiters(rw_lock);
+    }
+}
+
+// Take a biased lock for reading through the reader slot.
+static bool _fast_rdlock(oe_rwlock_impl_t* rw_lock)
+{
+    volatile uint64_t* slot;
+
+    if (rw_lock->bias != RWLOCK_BIASED || !(slot = _get_reader_slot(rw_lock)))
+        return false;
+
+    // The slot is taken by another lock or by a nested read lock.
+    if (*slot)
+        return false;
+
+    *slot = (uint64_t)rw_lock;
+
+    // Announce the reader before checking the bias (see _revoke_bias()).
+    __sync_synchronize();
+
+    if (rw_lock->bias == RWLOCK_BIASED)
+        return true;
+
+    // A writer is revoking the bias.
+    _fast_rdunlock(rw_lock, slot);
+    return false;
+}
+
+// The current thread must hold the spinlock. Take the bias away and return
+// true once no reader holds the lock through its reader slot.
+static bool _revoke_bias(oe_rwlock_impl_t* rw_lock)
+{
+    if (rw_lock->bias == RWLOCK_UNBIASED)
+        return true;
+
+    rw_lock->bias = RWLOCK_REVOKING;
+    rw_lock->slow_reads = 0;
+
+    // Take the bias away before checking the slots (see _fast_rdlock()).
+    __sync_synchronize();
+
+    if (_has_slot_readers(rw_lock))
+        return false;
+
+    rw_lock->bias = RWLOCK_UNBIASED;
+    return true;
+}
+
+// The current thread must hold the spinlock and no writer may own the lock.
+static void _add_slow_reader(oe_rwlock_impl_t* rw_lock)
+{
+    rw_lock->readers++;
+
+    // Grant the bias again after enough reads with no writer around.
+    if (rw_lock->bias != RWLOCK_BIASED && _queue_empty(&rw_lock->queue) &&
+        ++rw_lock->slow_reads >= RWLOCK_REBIAS_READS)
+    {
+        rw_lock->bias = RWLOCK_BIASED;
+    }
+}
+
 oe_result_t oe_rwlock_init(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
@@ -556,6 +781,9 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    if (_fast_rdlock(rw_lock))
+        return OE_OK;
+
     oe_spin_lock(&rw_lock->lock);
 
     // Wait for writer to finish.
@@ -575,7 +803,7 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
     }
 
     // Increment number of readers.
-    rw_lock->readers++;
+    _add_slow_reader(rw_lock);
 
     oe_spin_unlock(&rw_lock->lock);
 
@@ -589,6 +817,9 @@ oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    if (_fast_rdlock(rw_lock))
+        return OE_OK;
+
     oe_spin_lock(&rw_lock->lock);
 
     oe_result_t result = OE_BUSY;
@@ -596,7 +827,7 @@ oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
     // If no writer is active, then lock is successful.
     if (rw_lock->writer == NULL)
     {
-        rw_lock->readers++;
+        _add_slow_reader(rw_lock);
         result = OE_OK;
     }
 
@@ -605,37 +836,21 @@ oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
     return result;
 }
 
-// The current thread must hold the spinlock.
-// _wake_waiters releases ownership of the spinlock.
-static oe_result_t _wake_waiters(oe_rwlock_impl_t* rw_lock)
-{
-    oe_thread_data_t* p = NULL;
-    Queue waiters = {NULL, NULL};
-
-    // Take a snapshot of current list of waiters.
-    while ((p = _queue_pop_front(&rw_lock->queue)))
-        _queue_push_back(&waiters, p);
-
-    // Release the lock and wake up the waiters. This allows waiter that is
-    // woken up to immediately acquire the spinlock and subsequently, the
-    // ownership of the rw_lock.
-    oe_spin_unlock(&rw_lock->lock);
-
-    // Wake the waiters in FIFO order. However actual acquisition of the lock
-    // will be dependent on OS scheduling of the threads.
-    while ((p = _queue_pop_front(&waiters)))
-        _thread_wake(p);
-
-    return OE_OK;
-}
-
 static oe_result_t _rwlock_rdunlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
+    volatile uint64_t* slot;
 
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    // If this thread holds the lock through its reader slot.
+    if ((slot = _get_reader_slot(rw_lock)) && *slot == (uint64_t)rw_lock)
+    {
+        _fast_rdunlock(rw_lock, slot);
+        return OE_OK;
+    }
+
     oe_spin_lock(&rw_lock->lock);
 
     // There must be at least 1 reader and no writers.
@@ -674,7 +889,8 @@ oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
     }
 
     // Wait for all readers and any other writer to finish.
-    while (rw_lock->readers > 0 || rw_lock->writer != NULL)
+    while (rw_lock->readers > 0 || rw_lock->writer != NULL ||
+           !_revoke_bias(rw_lock))
     {
         // Add self to list of waiters, and go to wait state.
         if (!_queue_contains(&rw_lock->queue, self))
@@ -707,7 +923,8 @@ oe_result_t oe_rwlock_trywrlock(oe_rwlock_t* read_write_lock)
     oe_spin_lock(&rw_lock->lock);
 
     // If no readers and no writers are active, then lock is successful.
-    if (rw_lock->readers == 0 && rw_lock->writer == NULL)
+    if (rw_lock->readers == 0 && rw_lock->writer == NULL &&
+        _revoke_bias(rw_lock))
     {
         rw_lock->writer = self;
         result = OE_OK;
@@ -759,7 +976,8 @@ oe_result_t oe_rwlock_destroy(oe_rwlock_t* read_write_lock)
     oe_spin_lock(&rw_lock->lock);
 
     // There must not be any active readers or writers.
-    if (rw_lock->readers != 0 || rw_lock->writer != NULL)
+    if (rw_lock->readers != 0 || rw_lock->writer != NULL ||
+        (rw_lock->bias != RWLOCK_UNBIASED && _has_slot_readers(rw_lock)))
     {
         oe_spin_unlock(&rw_lock->lock);
         return OE_BUSY;
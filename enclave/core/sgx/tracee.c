@@ -4,10 +4,12 @@
 #include <openenclave/bits/safemath.h>
 #include <openenclave/bits/types.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/report.h>
 #include <openenclave/internal/sgxtypes.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/trace.h>
 #include <openenclave/internal/utils.h>
 #include "report.h"
@@ -16,6 +18,9 @@ static log_level_t _active_log_level = OE_LOG_LEVEL_ERROR;
 static char _enclave_filename[MAX_FILENAME_LEN];
 static bool _debug_allowed_enclave = false;
 
+/* The log ring shared with the host, or null to log with OE_OCALL_LOG */
+static oe_log_ring_t* _log_ring = NULL;
+
 const char* get_filename_from_path(const char* path, size_t path_len)
 {
     if (path)
@@ -95,7 +100,15 @@ oe_result_t _handle_oelog_init(uint64_t arg)
         goto done;
     }
 
+    if (local.ring &&
+        !oe_is_outside_enclave((void*)local.ring, sizeof(oe_log_ring_t)))
+    {
+        result = OE_INVALID_PARAMETER;
+        goto done;
+    }
+
     _active_log_level = local.level;
+    _log_ring = local.ring;
     filename = get_filename_from_path(local.path, local.path_len);
     if (filename)
     {
@@ -112,13 +125,111 @@ done:
     return result;
 }
 
+/* Format the message prefixed with the enclave file name into buffer (of
+ * OE_LOG_MESSAGE_LEN_MAX bytes) and return its length, or -1 on error */
+static int _format_message(char* buffer, const char* fmt, oe_va_list ap)
+{
+    int bytes_written = 0;
+    int n = 0;
+
+    bytes_written = oe_snprintf(
+        buffer, OE_LOG_MESSAGE_LEN_MAX, "%s:", _enclave_filename);
+
+    if (bytes_written < 0)
+        return -1;
+
+    n = oe_vsnprintf(
+        &buffer[bytes_written],
+        OE_LOG_MESSAGE_LEN_MAX - (size_t)bytes_written,
+        fmt,
+        ap);
+
+    if (n < 0)
+        return -1;
+
+    /* The message may have been truncated */
+    return (int)oe_strlen(buffer);
+}
+
+/*
+**==============================================================================
+**
+** _append_to_ring()
+**
+**     Append a record to the log ring without leaving the enclave, or count
+**     it as dropped if the ring is full. See oe_log_ring_t.
+**
+**==============================================================================
+*/
+
+static void _append_to_ring(
+    log_level_t level,
+    const char* message,
+    size_t length)
+{
+    oe_log_ring_t* ring = _log_ring;
+    const uint64_t size = oe_round_up_to_multiple(
+        sizeof(oe_log_record_t) + length + 1, sizeof(oe_log_record_t));
+    uint64_t head;
+    uint64_t tail;
+    uint64_t offset;
+    uint64_t padding;
+    oe_log_record_t* record;
+
+    /* Reserve the record, and the end of the ring if it does not fit there */
+    do
+    {
+        head = ring->head;
+        tail = ring->tail;
+
+        /* The ring is in host memory: a head that is not aligned to a record
+         * (or too far from the tail) would place the records across the end
+         * of the ring, so the ring is treated as full */
+        if (head % sizeof(oe_log_record_t) || head - tail > OE_LOG_RING_SIZE)
+        {
+            oe_atomic_increment(&ring->dropped);
+            return;
+        }
+
+        offset = head & (OE_LOG_RING_SIZE - 1);
+        padding = offset + size > OE_LOG_RING_SIZE ? OE_LOG_RING_SIZE - offset
+                                                   : 0;
+
+        if (head + padding + size - tail > OE_LOG_RING_SIZE)
+        {
+            oe_atomic_increment(&ring->dropped);
+            return;
+        }
+    } while (
+        !oe_atomic_compare_and_swap(&ring->head, head, head + padding + size));
+
+    if (padding)
+    {
+        record = (oe_log_record_t*)(ring->data + offset);
+        record->level = OE_LOG_LEVEL_MAX;
+        record->thread = 0;
+        OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+        record->size = (uint32_t)padding;
+        offset = 0;
+    }
+
+    record = (oe_log_record_t*)(ring->data + offset);
+    record->level = level;
+    record->thread = oe_thread_self();
+    oe_memcpy(record + 1, message, length);
+    ((char*)(record + 1))[length] = '\0';
+
+    /* Complete the record */
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    record->size = (uint32_t)size;
+}
+
 oe_result_t oe_log(log_level_t level, const char* fmt, ...)
 {
     oe_result_t result = OE_FAILURE;
     oe_log_args_t* args = NULL;
     oe_va_list ap;
     int n = 0;
-    int bytes_written = 0;
 
     // skip logging for non-debug-allowed enclaves
     if (!_debug_allowed_enclave)
@@ -140,6 +251,24 @@ oe_result_t oe_log(log_level_t level, const char* fmt, ...)
         goto done;
     }
 
+    // Append to the log ring, which the host drains in batches
+    if (_log_ring)
+    {
+        char message[OE_LOG_MESSAGE_LEN_MAX];
+
+        oe_va_start(ap, fmt);
+        n = _format_message(message, fmt, ap);
+        oe_va_end(ap);
+
+        if (n < 0)
+            goto done;
+
+        _append_to_ring(level, message, (size_t)n);
+
+        result = OE_OK;
+        goto done;
+    }
+
     // Prepare a log record for sending to the host for logging
     if (!(args = oe_host_malloc(sizeof(oe_log_args_t))))
     {
@@ -147,19 +276,9 @@ oe_result_t oe_log(log_level_t level, const char* fmt, ...)
         goto done;
     }
 
-    bytes_written = oe_snprintf(
-        args->message, OE_LOG_MESSAGE_LEN_MAX, "%s:", _enclave_filename);
-
-    if (bytes_written < 0)
-        goto done;
-
     args->level = level;
     oe_va_start(ap, fmt);
-    n = oe_vsnprintf(
-        &args->message[bytes_written],
-        OE_LOG_MESSAGE_LEN_MAX - (size_t)bytes_written,
-        fmt,
-        ap);
+    n = _format_message(args->message, fmt, ap);
     oe_va_end(ap);
 
     if (n < 0)
@@ -5,10 +5,12 @@
 #include <mbedtls/platform.h>
 #include <mbedtls/x509_crl.h>
 #include <openenclave/bits/safecrt.h>
+#include <openenclave/enclave.h>
 #include <openenclave/internal/crl.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
 #include <openenclave/internal/utils.h>
 
 /* Randomly generated magic number */
@@ -16,6 +18,15 @@
 
 OE_STATIC_ASSERT(sizeof(crl_t) <= sizeof(oe_crl_t));
 
+/* CRLs are read for each quote verification: allocate them from a pool */
+static oe_pool_t* _crl_pool;
+static oe_once_t _crl_pool_once = OE_ONCE_INIT;
+
+static void _create_crl_pool(void)
+{
+    _crl_pool = oe_pool_create(sizeof(mbedtls_x509_crl), 0);
+}
+
 OE_INLINE void _crl_init(crl_t* impl, mbedtls_x509_crl* crl)
 {
     impl->magic = OE_CRL_MAGIC;
@@ -31,7 +42,7 @@ OE_INLINE void _crl_free(crl_t* impl)
 {
     mbedtls_x509_crl_free(impl->crl);
     oe_memset(impl->crl, 0, sizeof(mbedtls_x509_crl));
-    mbedtls_free(impl->crl);
+    oe_pool_free(_crl_pool, impl->crl);
     oe_memset(impl, 0, sizeof(crl_t));
 }
 
@@ -54,7 +65,9 @@ oe_result_t oe_crl_read_der(
         OE_RAISE(OE_UNEXPECTED);
 
     /* Allocate memory for the CRL */
-    if (!(x509_crl = mbedtls_calloc(1, sizeof(mbedtls_x509_crl))))
+    oe_once(&_crl_pool_once, _create_crl_pool);
+
+    if (!(x509_crl = oe_pool_alloc(_crl_pool)))
         OE_RAISE(OE_OUT_OF_MEMORY);
 
     /* Initialize the CRL structure */
@@ -77,7 +90,7 @@ done:
     {
         mbedtls_x509_crl_free(x509_crl);
         oe_memset(x509_crl, 0, sizeof(mbedtls_x509_crl));
-        mbedtls_free(x509_crl);
+        oe_pool_free(_crl_pool, x509_crl);
     }
 
     return result;
@@ -8,6 +8,7 @@
 
 static const uint64_t _SEC_TO_MSEC = 1000UL;
 static const uint64_t _MSEC_TO_NSEC = 1000000UL;
+static const uint64_t _SEC_TO_NSEC = 1000000000UL;
 
 /* Return milliseconds elapsed since the Epoch. */
 static uint64_t _time()
@@ -49,3 +50,31 @@ void oe_handle_get_time(uint64_t arg_in, uint64_t* arg_out)
     if (arg_out)
         *arg_out = _time();
 }
+
+void oe_handle_get_clock(uint64_t arg_in, uint64_t* arg_out)
+{
+    clockid_t clk_id;
+    struct timespec ts;
+
+    if (!arg_out)
+        return;
+
+    *arg_out = (uint64_t)-1;
+
+    switch ((oe_clock_t)arg_in)
+    {
+        case OE_CLOCK_REALTIME:
+            clk_id = CLOCK_REALTIME;
+            break;
+        case OE_CLOCK_MONOTONIC:
+            clk_id = CLOCK_MONOTONIC;
+            break;
+        default:
+            return;
+    }
+
+    if (clock_gettime(clk_id, &ts) != 0)
+        return;
+
+    *arg_out = ((uint64_t)ts.tv_sec * _SEC_TO_NSEC) + (uint64_t)ts.tv_nsec;
+}
@@ -12,4 +12,6 @@ void oe_handle_sleep(uint64_t arg_in);
 
 void oe_handle_get_time(uint64_t arg_in, uint64_t* arg_out);
 
+void oe_handle_get_clock(uint64_t arg_in, uint64_t* arg_out);
+
 #endif /* _OE_HOST_OCALLS_H */
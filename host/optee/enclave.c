@@ -52,3 +52,83 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
     OE_UNUSED(enclave);
     return OE_UNSUPPORTED;
 }
+
+oe_result_t oe_get_switchless_stats(
+    oe_enclave_t* enclave,
+    oe_switchless_stats_t* stats)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(stats);
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    return oe_call_enclave_function(
+        enclave,
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written);
+}
+
+oe_result_t oe_call_enclave_function_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    if (!enclave || (!calls && num_calls))
+        return OE_INVALID_PARAMETER;
+
+    for (size_t i = 0; i < num_calls; i++)
+    {
+        calls[i].output_bytes_written = 0;
+        calls[i].result = oe_call_enclave_function(
+            enclave,
+            (uint32_t)calls[i].function_id,
+            calls[i].input_buffer,
+            calls[i].input_buffer_size,
+            calls[i].output_buffer,
+            calls[i].output_buffer_size,
+            &calls[i].output_bytes_written);
+    }
+
+    return OE_OK;
+}
+
+oe_result_t oe_register_shared_region(
+    oe_enclave_t* enclave,
+    void* data,
+    size_t size)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(data);
+    OE_UNUSED(size);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_set_heap_profile_rate(oe_enclave_t* enclave, size_t sample_rate)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(sample_rate);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_write_heap_profile(oe_enclave_t* enclave, const char* path)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(path);
+
+    return OE_UNSUPPORTED;
+}
@@ -20,7 +20,9 @@
 
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/bits/safemath.h>
+#include <openenclave/edger8r/host.h>
 #include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/registers.h>
@@ -30,6 +32,7 @@
 #include "asmdefs.h"
 #include "enclave.h"
 #include "ocalls.h"
+#include "switchless.h"
 
 /*
 **==============================================================================
@@ -274,6 +277,228 @@ static oe_host_func_t _find_host_func(const char* name)
 #endif
 }
 
+/*
+**==============================================================================
+**
+** _find_host_func_entry()
+**
+**     Find the entry of the function with the given name and hash in the
+**     host function table. The caller holds enclave->lock.
+**
+**==============================================================================
+*/
+
+static uint64_t _find_host_func_entry(
+    const oe_host_func_table_t* table,
+    const char* name,
+    uint64_t hash)
+{
+    size_t mask = table->index_size - 1;
+
+    if (table->index_size == 0)
+        return 0;
+
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        uint32_t n = table->index[i];
+
+        if (n == 0)
+            return 0;
+
+        if (table->entries[n - 1].hash == hash &&
+            strcmp(table->entries[n - 1].name, name) == 0)
+        {
+            return n;
+        }
+    }
+}
+
+/*
+**==============================================================================
+**
+** _add_host_func_entry()
+**
+**     Append an entry to the host function table, growing the entries array
+**     and the index as needed (the index is kept at most half full). The
+**     caller holds enclave->lock. Returns the handle of the new entry.
+**
+**==============================================================================
+*/
+
+#define HOST_FUNC_INDEX_MIN_SIZE 64
+
+static oe_result_t _add_host_func_entry(
+    oe_host_func_table_t* table,
+    const char* name,
+    uint64_t hash,
+    oe_host_func_t func,
+    uint64_t* handle)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    char* name_copy = NULL;
+
+    if (table->num_entries >= OE_UINT32_MAX / 2)
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    if (!(name_copy = strdup(name)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* Grow the entries array */
+    if (table->num_entries == table->max_entries)
+    {
+        size_t max_entries = table->max_entries ? table->max_entries * 2
+                                                : HOST_FUNC_INDEX_MIN_SIZE / 2;
+        oe_host_func_entry_t* entries =
+            realloc(table->entries, max_entries * sizeof(*entries));
+
+        if (!entries)
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        table->entries = entries;
+        table->max_entries = max_entries;
+    }
+
+    /* Grow and rebuild the index */
+    if ((table->num_entries + 1) * 2 > table->index_size)
+    {
+        size_t index_size = table->index_size ? table->index_size * 2
+                                              : HOST_FUNC_INDEX_MIN_SIZE;
+        uint32_t* index = calloc(index_size, sizeof(*index));
+
+        if (!index)
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        for (size_t n = 0; n < table->num_entries; n++)
+        {
+            size_t i = table->entries[n].hash & (index_size - 1);
+
+            while (index[i])
+                i = (i + 1) & (index_size - 1);
+
+            index[i] = (uint32_t)(n + 1);
+        }
+
+        free(table->index);
+        table->index = index;
+        table->index_size = index_size;
+    }
+
+    /* Add the entry */
+    {
+        size_t n = table->num_entries++;
+        size_t i = hash & (table->index_size - 1);
+
+        table->entries[n].name = name_copy;
+        table->entries[n].hash = hash;
+        table->entries[n].func = func;
+        name_copy = NULL;
+
+        while (table->index[i])
+            i = (i + 1) & (table->index_size - 1);
+
+        table->index[i] = (uint32_t)(n + 1);
+        *handle = n + 1;
+    }
+
+    result = OE_OK;
+
+done:
+    free(name_copy);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _resolve_host_func()
+**
+**     Find the host function with the given name and return its handle. The
+**     first lookup of a name searches the host module (_find_host_func());
+**     later lookups are served from the host function table.
+**
+**==============================================================================
+*/
+
+static oe_result_t _resolve_host_func(
+    oe_enclave_t* enclave,
+    const char* name,
+    uint64_t* handle,
+    oe_host_func_t* func)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_host_func_table_t* table = &enclave->host_funcs;
+    uint64_t hash = oe_hash_str(name, strlen(name));
+    uint64_t n;
+
+    oe_mutex_lock(&enclave->lock);
+
+    if ((n = _find_host_func_entry(table, name, hash)) == 0)
+    {
+        oe_host_func_t found;
+
+        if (!(found = _find_host_func(name)))
+            OE_RAISE_NO_TRACE(OE_NOT_FOUND);
+
+        OE_CHECK(_add_host_func_entry(table, name, hash, found, &n));
+    }
+
+    *handle = n;
+    *func = table->entries[n - 1].func;
+    result = OE_OK;
+
+done:
+    oe_mutex_unlock(&enclave->lock);
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _get_host_func()
+**
+**     Return the host function with the given handle (or null if the handle
+**     is not valid).
+**
+**==============================================================================
+*/
+
+static oe_host_func_t _get_host_func(oe_enclave_t* enclave, uint64_t handle)
+{
+    oe_host_func_t func = NULL;
+
+    oe_mutex_lock(&enclave->lock);
+
+    if (handle != 0 && handle <= enclave->host_funcs.num_entries)
+        func = enclave->host_funcs.entries[handle - 1].func;
+
+    oe_mutex_unlock(&enclave->lock);
+
+    return func;
+}
+
+/*
+**==============================================================================
+**
+** oe_free_host_funcs()
+**
+**     Release the host function table. Called when the enclave terminates,
+**     which invalidates all handles.
+**
+**==============================================================================
+*/
+
+void oe_free_host_funcs(oe_enclave_t* enclave)
+{
+    oe_host_func_table_t* table = &enclave->host_funcs;
+
+    for (size_t n = 0; n < table->num_entries; n++)
+        free(table->entries[n].name);
+
+    free(table->entries);
+    free(table->index);
+    memset(table, 0, sizeof(*table));
+}
+
 /*
 **==============================================================================
 **
@@ -288,6 +513,7 @@ static void _handle_call_host(uint64_t arg, oe_enclave_t* enclave)
 {
     oe_call_host_args_t* args = (oe_call_host_args_t*)arg;
     oe_host_func_t func;
+    uint64_t handle;
 
     if (!args)
         return;
@@ -295,7 +521,64 @@ static void _handle_call_host(uint64_t arg, oe_enclave_t* enclave)
     args->result = OE_UNEXPECTED;
 
     /* Find the host function with this name */
-    if (!(func = _find_host_func(args->func)))
+    if (_resolve_host_func(enclave, args->func, &handle, &func) != OE_OK)
+    {
+        args->result = OE_NOT_FOUND;
+        return;
+    }
+
+    /* Invoke the function */
+    func(args->args, enclave);
+
+    args->result = OE_OK;
+}
+
+/*
+**==============================================================================
+**
+** _handle_get_host_function_handle()
+**
+**     Handle oe_get_host_function_handle() calls from the enclave
+**
+**==============================================================================
+*/
+
+static void _handle_get_host_function_handle(
+    uint64_t arg,
+    oe_enclave_t* enclave)
+{
+    oe_get_host_function_handle_args_t* args =
+        (oe_get_host_function_handle_args_t*)arg;
+    oe_host_func_t func;
+
+    if (!args)
+        return;
+
+    args->handle = 0;
+    args->result = _resolve_host_func(enclave, args->func, &args->handle, &func);
+}
+
+/*
+**==============================================================================
+**
+** _handle_call_host_by_handle()
+**
+**     Handle oe_call_host_by_handle() calls from the enclave
+**
+**==============================================================================
+*/
+
+static void _handle_call_host_by_handle(uint64_t arg, oe_enclave_t* enclave)
+{
+    oe_call_host_by_handle_args_t* args = (oe_call_host_by_handle_args_t*)arg;
+    oe_host_func_t func;
+
+    if (!args)
+        return;
+
+    args->result = OE_UNEXPECTED;
+
+    if (!(func = _get_host_func(enclave, args->handle)))
     {
         args->result = OE_NOT_FOUND;
         return;
@@ -342,14 +625,14 @@ done:
 /*
 **==============================================================================
 **
-** _handle_call_host_function()
+** oe_handle_call_host_function()
 **
-** Handle calls from the enclave.
+** Handle calls from the enclave. Also used by the switchless host workers.
 **
 **==============================================================================
 */
 
-static oe_result_t _handle_call_host_function(
+oe_result_t oe_handle_call_host_function(
     uint64_t arg,
     oe_enclave_t* enclave)
 {
@@ -440,8 +723,21 @@ static oe_result_t _handle_ocall(
             _handle_call_host_by_address(arg_in, enclave);
             break;
 
+        case OE_OCALL_GET_HOST_FUNCTION_HANDLE:
+            _handle_get_host_function_handle(arg_in, enclave);
+            break;
+
+        case OE_OCALL_CALL_HOST_BY_HANDLE:
+            _handle_call_host_by_handle(arg_in, enclave);
+            break;
+
         case OE_OCALL_CALL_HOST_FUNCTION:
-            _handle_call_host_function(arg_in, enclave);
+            oe_handle_call_host_function(arg_in, enclave);
+
+            /* The enclave may have fallen back here because the switchless
+             * workers were asleep */
+            if (enclave->switchless)
+                oe_wake_switchless_host_workers(enclave->switchless);
             break;
 
         case OE_OCALL_MALLOC:
@@ -498,6 +794,10 @@ static oe_result_t _handle_ocall(
             oe_handle_get_time(arg_in, arg_out);
             break;
 
+        case OE_OCALL_GET_CLOCK:
+            oe_handle_get_clock(arg_in, arg_out);
+            break;
+
         case OE_OCALL_BACKTRACE_SYMBOLS:
             oe_handle_backtrace_symbols(enclave, arg_in);
             break;
@@ -615,6 +915,83 @@ int __oe_dispatch_ocall(
     return 1;
 }
 
+/*
+**==============================================================================
+**
+** _pop_free_binding()
+** _push_free_binding()
+**
+**     The bindings that are not busy form a lock-free stack. Its head
+**     (oe_enclave_t.free_bindings) packs the index of the top binding plus
+**     one (zero when empty) in the low 32 bits and a tag in the high 32
+**     bits. The tag is incremented by every update to defeat ABA. The links
+**     live in oe_enclave_t.free_binding_next[] so that the ThreadBinding
+**     layout seen by the debugger is unchanged.
+**
+**==============================================================================
+*/
+
+#define _BINDING_TOP(head) ((uint32_t)(head))
+#define _BINDING_HEAD(head, top) (((((head) >> 32) + 1) << 32) | (top))
+
+static ThreadBinding* _pop_free_binding(oe_enclave_t* enclave)
+{
+    for (;;)
+    {
+        uint64_t head = enclave->free_bindings;
+        uint32_t top = _BINDING_TOP(head);
+        uint32_t next;
+
+        if (top == 0)
+            return NULL;
+
+        next = enclave->free_binding_next[top - 1];
+
+        if (oe_atomic_compare_and_swap(
+                &enclave->free_bindings, head, _BINDING_HEAD(head, next)))
+        {
+            return &enclave->bindings[top - 1];
+        }
+    }
+}
+
+static void _push_free_binding(oe_enclave_t* enclave, ThreadBinding* binding)
+{
+    uint32_t index = (uint32_t)(binding - enclave->bindings);
+
+    for (;;)
+    {
+        uint64_t head = enclave->free_bindings;
+
+        enclave->free_binding_next[index] = _BINDING_TOP(head);
+
+        if (oe_atomic_compare_and_swap(
+                &enclave->free_bindings, head, _BINDING_HEAD(head, index + 1)))
+        {
+            return;
+        }
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_initialize_thread_bindings()
+**
+**     Put all bindings on the free stack (bindings[0] on top). Called once
+**     the enclave image has been loaded and before the first ECALL.
+**
+**==============================================================================
+*/
+
+void oe_initialize_thread_bindings(oe_enclave_t* enclave)
+{
+    enclave->free_bindings = 0;
+
+    for (size_t i = enclave->num_bindings; i > 0; i--)
+        _push_free_binding(enclave, &enclave->bindings[i - 1]);
+}
+
 /*
 **==============================================================================
 **
@@ -628,58 +1005,60 @@ int __oe_dispatch_ocall(
 **     Else, the calling host thread is bound to the first available enclave
 **     thread context.
 **
-**     Returns the address of the thread control structure (TCS) corresponding
-**     to the enclave thread context.
+**     The binding of the calling thread is cached in thread-specific data,
+**     so a nested ECALL into the same enclave needs a single lookup. Only a
+**     thread that is in an OCALL of another enclave has to scan for a
+**     binding it may still hold in this enclave (cross-enclave nesting).
+**     Other ECALLs pop a free binding. No lock is taken. The binding is set
+**     in thread-specific data for the duration of the ECALL, and oe_ecall()
+**     restores the binding of the enclosing call when it returns.
+**
+**     Returns the binding corresponding to the enclave thread context.
 **
 **==============================================================================
 */
 
-static void* _assign_tcs(oe_enclave_t* enclave)
+static ThreadBinding* _assign_tcs(oe_enclave_t* enclave)
 {
-    void* tcs = NULL;
-    size_t i;
+    ThreadBinding* binding = GetThreadBinding();
     oe_thread thread = oe_thread_self();
 
-    oe_mutex_lock(&enclave->lock);
+    if (binding)
     {
-        /* First attempt to find a busy td_t owned by this thread */
-        for (i = 0; i < enclave->num_bindings; i++)
+        /* Nested ECALL into the enclave this thread is bound to */
+        if (binding >= enclave->bindings &&
+            binding < enclave->bindings + enclave->num_bindings)
         {
-            ThreadBinding* binding = &enclave->bindings[i];
+            binding->count++;
+            return binding;
+        }
+
+        /* Only this thread can have set a binding's thread to itself */
+        for (size_t i = 0; i < enclave->num_bindings; i++)
+        {
+            binding = &enclave->bindings[i];
 
             if ((binding->flags & _OE_THREAD_BUSY) && binding->thread == thread)
             {
                 binding->count++;
-                tcs = (void*)binding->tcs;
-                break;
+                _set_thread_binding(binding);
+                return binding;
             }
         }
+    }
 
-        /* If binding not found above, look for an available ThreadBinding */
-        if (!tcs)
-        {
-            for (i = 0; i < enclave->num_bindings; i++)
-            {
-                ThreadBinding* binding = &enclave->bindings[i];
+    if (!(binding = _pop_free_binding(enclave)))
+        return NULL;
 
-                if (!(binding->flags & _OE_THREAD_BUSY))
-                {
-                    binding->flags |= _OE_THREAD_BUSY;
-                    binding->thread = thread;
-                    binding->count = 1;
-                    tcs = (void*)binding->tcs;
-
-                    /* Set into TSD so asynchronous exceptions can get it */
-                    _set_thread_binding(binding);
-                    assert(GetThreadBinding() == binding);
-                    break;
-                }
-            }
-        }
-    }
-    oe_mutex_unlock(&enclave->lock);
+    binding->flags |= _OE_THREAD_BUSY;
+    binding->thread = thread;
+    binding->count = 1;
+
+    /* Set into TSD so asynchronous exceptions can get it */
+    _set_thread_binding(binding);
+    assert(GetThreadBinding() == binding);
 
-    return tcs;
+    return binding;
 }
 
 /*
@@ -687,40 +1066,25 @@ static void* _assign_tcs(oe_enclave_t* enclave)
 **
 ** _release_tcs()
 **
-**     Decrement the ThreadBinding.count field of the binding associated with
-**     the given TCS. If the field becomes zero, the binding is dissolved.
+**     Decrement the ThreadBinding.count field of the given binding. If the
+**     field becomes zero, the binding is dissolved and returned to the free
+**     stack. The thread-specific binding is restored by oe_ecall().
 **
 **==============================================================================
 */
 
-static void _release_tcs(oe_enclave_t* enclave, void* tcs)
+static void _release_tcs(oe_enclave_t* enclave, ThreadBinding* binding)
 {
-    size_t i;
+    binding->count--;
 
-    oe_mutex_lock(&enclave->lock);
+    if (binding->count == 0)
     {
-        for (i = 0; i < enclave->num_bindings; i++)
-        {
-            ThreadBinding* binding = &enclave->bindings[i];
+        binding->flags &= (~_OE_THREAD_BUSY);
+        binding->thread = 0;
+        memset(&binding->event, 0, sizeof(binding->event));
 
-            if ((binding->flags & _OE_THREAD_BUSY) &&
-                (void*)binding->tcs == tcs)
-            {
-                binding->count--;
-
-                if (binding->count == 0)
-                {
-                    binding->flags &= (~_OE_THREAD_BUSY);
-                    binding->thread = 0;
-                    memset(&binding->event, 0, sizeof(binding->event));
-                    _set_thread_binding(NULL);
-                    assert(GetThreadBinding() == NULL);
-                }
-                break;
-            }
-        }
+        _push_free_binding(enclave, binding);
     }
-    oe_mutex_unlock(&enclave->lock);
 }
 
 /*
@@ -740,6 +1104,8 @@ oe_result_t oe_ecall(
     uint64_t* arg_out_ptr)
 {
     oe_result_t result = OE_UNEXPECTED;
+    ThreadBinding* binding = NULL;
+    ThreadBinding* previous = GetThreadBinding();
     void* tcs = NULL;
     oe_code_t code = OE_CODE_ECALL;
     oe_code_t code_out = 0;
@@ -751,9 +1117,11 @@ oe_result_t oe_ecall(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Assign a td_t for this operation */
-    if (!(tcs = _assign_tcs(enclave)))
+    if (!(binding = _assign_tcs(enclave)))
         OE_RAISE(OE_OUT_OF_THREADS);
 
+    tcs = (void*)binding->tcs;
+
     /* Perform ECALL or ORET */
     OE_CHECK(_do_eenter(
         enclave,
@@ -778,8 +1146,15 @@ oe_result_t oe_ecall(
 
 done:
 
-    if (enclave && tcs)
-        _release_tcs(enclave, tcs);
+    if (binding)
+    {
+        _release_tcs(enclave, binding);
+
+        /* Restore the binding of the call this ECALL is nested in (if any),
+         * which may belong to another enclave, so that the next ECALL from
+         * the same OCALL handler finds it */
+        _set_thread_binding(previous);
+    }
 
     /* ATTN: this causes an assertion with call nesting. */
     /* ATTN: make enclave argument a cookie. */
@@ -794,70 +1169,59 @@ done:
 **
 ** _find_enclave_func()
 **
-**     Find the enclave function with the given name
+**     Find the enclave function with the given name through the index built
+**     by _build_ecall_index(). Returns its position in enclave->ecalls[]
+**     plus one, or zero if not found.
 **
 **==============================================================================
 */
 
-static uint64_t _find_enclave_func(
-    oe_enclave_t* enclave,
-    const char* func,
-    uint64_t* index)
+static uint64_t _find_enclave_func(oe_enclave_t* enclave, const char* func)
 {
-    size_t i;
-
-    if (index)
-        *index = 0;
-
-    /* Reject null parameters and empty string funcs (checked by !*func). */
-    if (!enclave || !func || !*func || !index)
-        return 0;
-
     size_t len = strlen(func);
     uint64_t code = StrCode(func, len);
+    size_t mask = enclave->ecall_index_size - 1;
 
-    for (i = 0; i < enclave->num_ecalls; i++)
+    if (enclave->ecall_index_size == 0)
+        return 0;
+
+    for (size_t i = oe_hash_str(func, len) & mask;; i = (i + 1) & mask)
     {
-        const ECallNameAddr* p = &enclave->ecalls[i];
+        uint32_t n = enclave->ecall_index[i];
+
+        if (n == 0)
+            return 0;
 
-        if (p->code == code && memcmp(p->name, func, len) == 0)
+        if (enclave->ecalls[n - 1].code == code &&
+            strcmp(enclave->ecalls[n - 1].name, func) == 0)
         {
-            *index = i;
-            return enclave->ecalls[i].vaddr;
+            return n;
         }
     }
-
-    /* Not found! */
-    return 0;
 }
 
 /*
 **==============================================================================
 **
-** oe_call_enclave()
+** _call_enclave()
 **
-**     Call the named function in the enclave.
+**     Call the enclave function at the given position in enclave->ecalls[].
 **
 **==============================================================================
 */
 
-oe_result_t oe_call_enclave(oe_enclave_t* enclave, const char* func, void* args)
+static oe_result_t _call_enclave(
+    oe_enclave_t* enclave,
+    uint64_t index,
+    void* args)
 {
     oe_result_t result = OE_UNEXPECTED;
     oe_call_enclave_args_t call_enclave_args;
 
-    /* Reject invalid parameters */
-    if (!enclave || !func)
-        OE_RAISE(OE_INVALID_PARAMETER);
-
     /* Initialize the call_enclave_args structure */
     {
-        if (!(call_enclave_args.vaddr =
-                  _find_enclave_func(enclave, func, &call_enclave_args.func)))
-        {
-            OE_RAISE(OE_NOT_FOUND);
-        }
-
+        call_enclave_args.func = index;
+        call_enclave_args.vaddr = enclave->ecalls[index].vaddr;
         call_enclave_args.args = args;
         call_enclave_args.result = OE_UNEXPECTED;
     }
@@ -884,6 +1248,103 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** oe_call_enclave()
+**
+**     Call the named function in the enclave.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave(oe_enclave_t* enclave, const char* func, void* args)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t handle;
+
+    /* Reject invalid parameters */
+    if (!enclave || !func)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Find the function (empty names are never found) */
+    if (!(handle = _find_enclave_func(enclave, func)))
+        OE_RAISE(OE_NOT_FOUND);
+
+    OE_CHECK(_call_enclave(enclave, handle - 1, args));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_enclave_function_handle()
+**
+**     Resolve the name of an enclave function to a handle for
+**     oe_call_enclave_by_handle().
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_enclave_function_handle(
+    oe_enclave_t* enclave,
+    const char* func,
+    uint64_t* handle)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (handle)
+        *handle = 0;
+
+    /* Reject invalid parameters */
+    if (!enclave || !func || !handle)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(*handle = _find_enclave_func(enclave, func)))
+        OE_RAISE(OE_NOT_FOUND);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_by_handle()
+**
+**     Call the enclave function with the given handle.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave_by_handle(
+    oe_enclave_t* enclave,
+    uint64_t handle,
+    void* args)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    /* Reject invalid parameters */
+    if (!enclave)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (handle == 0 || handle > enclave->num_ecalls)
+        OE_RAISE(OE_NOT_FOUND);
+
+    OE_CHECK(_call_enclave(enclave, handle - 1, args));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 /*
 **==============================================================================
 **
@@ -945,6 +1406,128 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** oe_call_enclave_function_batch()
+**
+**     Call the enclave functions described by calls[] with a single ECALL.
+**     The descriptors are passed to the enclave as they are, so their layout
+**     must match oe_call_enclave_function_args_t.
+**
+**==============================================================================
+*/
+
+OE_STATIC_ASSERT(
+    sizeof(oe_enclave_function_call_t) ==
+    sizeof(oe_call_enclave_function_args_t));
+OE_STATIC_ASSERT(
+    OE_OFFSETOF(oe_enclave_function_call_t, input_buffer) ==
+    OE_OFFSETOF(oe_call_enclave_function_args_t, input_buffer));
+OE_STATIC_ASSERT(
+    OE_OFFSETOF(oe_enclave_function_call_t, output_buffer) ==
+    OE_OFFSETOF(oe_call_enclave_function_args_t, output_buffer));
+OE_STATIC_ASSERT(
+    OE_OFFSETOF(oe_enclave_function_call_t, result) ==
+    OE_OFFSETOF(oe_call_enclave_function_args_t, result));
+
+oe_result_t oe_call_enclave_function_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_enclave_function_batch_args_t args;
+
+    /* Reject invalid parameters */
+    if (!enclave || (!calls && num_calls))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (num_calls == 0)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    /* Initialize the call_enclave_function_batch_args structure */
+    {
+        for (size_t i = 0; i < num_calls; i++)
+        {
+            calls[i].output_bytes_written = 0;
+            calls[i].result = OE_UNEXPECTED;
+        }
+
+        args.calls = (oe_call_enclave_function_args_t*)calls;
+        args.num_calls = num_calls;
+        args.result = OE_UNEXPECTED;
+    }
+
+    /* Perform the ECALL */
+    {
+        uint64_t arg_out = 0;
+
+        OE_CHECK(oe_ecall(
+            enclave,
+            OE_ECALL_CALL_ENCLAVE_FUNCTION_BATCH,
+            (uint64_t)&args,
+            &arg_out));
+        OE_CHECK((oe_result_t)arg_out);
+    }
+
+    /* Check the result */
+    OE_CHECK(args.result);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_register_shared_region()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_register_shared_region(
+    oe_enclave_t* enclave,
+    void* data,
+    size_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_register_shared_region_args_t args;
+
+    /* Reject invalid parameters */
+    if (!enclave || !data || size == 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    args.data = data;
+    args.size = size;
+    args.result = OE_UNEXPECTED;
+
+    /* Perform the ECALL */
+    {
+        uint64_t arg_out = 0;
+
+        OE_CHECK(oe_ecall(
+            enclave,
+            OE_ECALL_REGISTER_SHARED_REGION,
+            (uint64_t)&args,
+            &arg_out));
+        OE_CHECK((oe_result_t)arg_out);
+    }
+
+    /* Check the result */
+    OE_CHECK(args.result);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 /*
 ** These two functions are needed to notify the debugger. They should not be
 ** optimized out even though they don't do anything in here.
@@ -51,7 +51,10 @@ static const char* get_fullpath(const char* path)
 #include "cpuid.h"
 #include "enclave.h"
 #include "exception.h"
+#include "imagecache.h"
+#include "logring.h"
 #include "sgxload.h"
+#include "switchless.h"
 
 static oe_once_type _enclave_init_once;
 
@@ -73,6 +76,9 @@ static void _initialize_enclave_host()
     oe_once(&_enclave_init_once, _initialize_exception_handling);
 }
 
+/* Number of pages of the buffer that _add_filled_pages() adds at a time */
+#define FILLED_PAGES_BATCH 256
+
 static oe_result_t _add_filled_pages(
     oe_sgx_load_context_t* context,
     uint64_t enclave_addr,
@@ -81,41 +87,59 @@ static oe_result_t _add_filled_pages(
     uint32_t filler,
     bool extend)
 {
-    oe_page_t page;
+    oe_page_t* pages = NULL;
+    size_t batch;
     oe_result_t result = OE_UNEXPECTED;
-    size_t i;
 
     /* Reject invalid parameters */
     if (!context || !enclave_addr || !vaddr)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Fill or clear the page */
+    if (npages == 0)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    /* Fill or clear enough pages to add a batch of them at a time */
+    batch = npages < FILLED_PAGES_BATCH ? npages : FILLED_PAGES_BATCH;
+
+    if (!(pages = (oe_page_t*)oe_memalign(
+              OE_PAGE_SIZE, batch * sizeof(oe_page_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
     if (filler)
     {
-        size_t n = OE_PAGE_SIZE / sizeof(uint32_t);
-        uint32_t* p = (uint32_t*)&page;
+        size_t n = batch * OE_PAGE_SIZE / sizeof(uint32_t);
+        uint32_t* p = (uint32_t*)pages;
 
         while (n--)
             *p++ = filler;
     }
     else
-        memset(&page, 0, sizeof(page));
+        memset(pages, 0, batch * sizeof(oe_page_t));
 
     /* Add the pages */
-    for (i = 0; i < npages; i++)
+    while (npages)
     {
         uint64_t addr = enclave_addr + *vaddr;
-        uint64_t src = (uint64_t)&page;
+        uint64_t src = (uint64_t)pages;
         uint64_t flags = SGX_SECINFO_REG | SGX_SECINFO_R | SGX_SECINFO_W;
+        size_t n = npages < batch ? npages : batch;
 
-        OE_CHECK(oe_sgx_load_enclave_data(
-            context, enclave_addr, addr, src, flags, extend));
-        (*vaddr) += OE_PAGE_SIZE;
+        OE_CHECK(oe_sgx_load_enclave_pages(
+            context, enclave_addr, addr, src, n, flags, extend));
+        (*vaddr) += n * OE_PAGE_SIZE;
+        npages -= n;
     }
 
     result = OE_OK;
 
 done:
+
+    if (pages)
+        oe_memalign_free(pages);
+
     return result;
 }
 
@@ -303,20 +327,15 @@ static oe_result_t _add_ecall_pages(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     {
-        const oe_page_t* pages = (const oe_page_t*)ecall_data;
+        uint64_t addr = enclave_addr + *vaddr;
+        uint64_t src = (uint64_t)ecall_data;
         size_t npages = ecall_size / sizeof(oe_page_t);
+        uint64_t flags = SGX_SECINFO_REG | SGX_SECINFO_R;
+        bool extend = true;
 
-        for (size_t i = 0; i < npages; i++)
-        {
-            uint64_t addr = enclave_addr + *vaddr;
-            uint64_t src = (uint64_t)&pages[i];
-            uint64_t flags = SGX_SECINFO_REG | SGX_SECINFO_R;
-            bool extend = true;
-
-            OE_CHECK(oe_sgx_load_enclave_data(
-                context, enclave_addr, addr, src, flags, extend));
-            (*vaddr) += sizeof(oe_page_t);
-        }
+        OE_CHECK(oe_sgx_load_enclave_pages(
+            context, enclave_addr, addr, src, npages, flags, extend));
+        (*vaddr) += npages * sizeof(oe_page_t);
     }
 
     result = OE_OK;
@@ -456,6 +475,10 @@ static oe_result_t _initialize_enclave(oe_enclave_t* enclave)
     // Pass the enclave handle to the enclave.
     args.enclave = enclave;
 
+    // Pass the ring serviced by the switchless host workers (if any).
+    args.host_worker_ring =
+        enclave->switchless ? enclave->switchless->host_worker_ring : NULL;
+
     {
         uint64_t arg_out = 0;
         OE_CHECK(oe_ecall(
@@ -560,6 +583,187 @@ done:
     return result;
 }
 
+/* Whether the properties hold the sigstruct of a signed enclave */
+static bool _is_signed(const oe_sgx_enclave_properties_t* properties)
+{
+    const sgx_sigstruct_t* sigstruct =
+        (const sgx_sigstruct_t*)properties->sigstruct;
+
+    return memcmp(
+               sigstruct->header,
+               SGX_SIGSTRUCT_HEADER,
+               SGX_SIGSTRUCT_HEADER_SIZE) == 0;
+}
+
+/*
+**==============================================================================
+**
+** _build_ecall_index()
+**
+**     Build the open-addressing index of enclave->ecalls[] used to find
+**     ECALL functions by name (see oe_get_enclave_function_handle()). Each
+**     slot holds a position in enclave->ecalls[] plus one, or zero if empty.
+**     The index size is a power of two at least twice the number of ECALLs.
+**
+**==============================================================================
+*/
+
+static oe_result_t _build_ecall_index(oe_enclave_t* enclave)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    size_t index_size = 16;
+
+    if (enclave->num_ecalls >= OE_UINT32_MAX / 2)
+        OE_RAISE(OE_FAILURE);
+
+    while (index_size < enclave->num_ecalls * 2)
+        index_size *= 2;
+
+    if (!(enclave->ecall_index = calloc(index_size, sizeof(uint32_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    enclave->ecall_index_size = index_size;
+
+    for (size_t n = 0; n < enclave->num_ecalls; n++)
+    {
+        const char* name = enclave->ecalls[n].name;
+        size_t i = oe_hash_str(name, strlen(name)) & (index_size - 1);
+
+        while (enclave->ecall_index[i])
+            i = (i + 1) & (index_size - 1);
+
+        enclave->ecall_index[i] = (uint32_t)(n + 1);
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/* Copy an array of ECALL functions, including their names */
+static oe_result_t _copy_ecalls(
+    const ECallNameAddr* ecalls,
+    size_t num_ecalls,
+    ECallNameAddr** copy_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    ECallNameAddr* copy = NULL;
+    size_t i = 0;
+
+    *copy_out = NULL;
+
+    if (num_ecalls == 0)
+        OE_RAISE(OE_FAILURE);
+
+    if (!(copy = (ECallNameAddr*)calloc(num_ecalls, sizeof(ECallNameAddr))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (i = 0; i < num_ecalls; i++)
+    {
+        copy[i] = ecalls[i];
+
+        if (!(copy[i].name = oe_strdup(ecalls[i].name)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+    }
+
+    *copy_out = copy;
+    copy = NULL;
+
+    result = OE_OK;
+
+done:
+
+    if (copy)
+    {
+        while (i--)
+            free(copy[i].name);
+
+        free(copy);
+    }
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _load_image()
+**
+**     Load the enclave image at PATH with the given properties (or those of
+**     the image if null), patch it and compute the layout of the enclave.
+**     The ECALL functions of the image are added to ENCLAVE. Nothing here
+**     depends on the address of the enclave, so oe_sgx_build_enclave() can
+**     share the result between enclaves (see imagecache.h).
+**
+**==============================================================================
+*/
+
+static oe_result_t _load_image(
+    const char* path,
+    const oe_sgx_enclave_properties_t* properties,
+    oe_enclave_t* enclave,
+    oe_cached_image_t* image)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_enclave_image_t* oeimage = &image->image;
+    oe_sgx_enclave_properties_t* props = &image->properties;
+
+    /* Load the elf object */
+    if (oe_load_enclave_image(path, oeimage) != OE_OK)
+        OE_RAISE(OE_FAILURE);
+
+    // If the **properties** parameter is non-null, use those properties.
+    // Else use the properties stored in the .oeinfo section.
+    if (properties)
+    {
+        *props = *properties;
+
+        /* Update image to the properties passed in */
+        memcpy(
+            oeimage->image_base + oeimage->oeinfo_rva, props, sizeof(*props));
+    }
+    else
+    {
+        /* Copy the properties from the image */
+        memcpy(
+            props, oeimage->image_base + oeimage->oeinfo_rva, sizeof(*props));
+    }
+
+    /* Validate the enclave prop_override structure */
+    OE_CHECK(oe_sgx_validate_enclave_properties(props, NULL));
+
+    /* Calculate the size of image */
+    OE_CHECK(oeimage->calculate_size(oeimage, &image->image_size));
+
+    /* Build an array of all the ECALL functions in the .ecalls section */
+    OE_CHECK(oeimage->build_ecall_array(oeimage, enclave));
+
+    /* Build ECALL pages for enclave (list of addresses) */
+    OE_CHECK(
+        _build_ecall_data(enclave, &image->ecall_data, &image->ecall_size));
+
+    /* Calculate the size of this enclave in memory */
+    OE_CHECK(_calculate_enclave_size(
+        image->image_size,
+        image->ecall_size,
+        props,
+        &image->enclave_end,
+        &image->enclave_size));
+
+    /* Patch image */
+    OE_CHECK(oeimage->patch(oeimage, image->ecall_size, image->enclave_end));
+
+    /* Enclaves are built from the patched image alone: do not keep the file
+     * mapped while the image is cached (see elf64_load()) */
+    OE_CHECK(oe_release_enclave_image_file(oeimage));
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
 oe_result_t oe_sgx_build_enclave(
     oe_sgx_load_context_t* context,
     const char* path,
@@ -567,17 +771,16 @@ oe_result_t oe_sgx_build_enclave(
     oe_enclave_t* enclave)
 {
     oe_result_t result = OE_UNEXPECTED;
-    size_t enclave_end = 0;
-    size_t enclave_size = 0;
     uint64_t enclave_addr = 0;
-    oe_enclave_image_t oeimage;
-    void* ecall_data = NULL;
-    size_t ecall_size;
-    size_t image_size;
+    oe_cached_image_t loaded;
+    oe_cached_image_t* cached = NULL;
+    oe_cached_image_t* image;
+    oe_image_cache_key_t key;
     uint64_t vaddr = 0;
     oe_sgx_enclave_properties_t props;
 
-    memset(&oeimage, 0, sizeof(oeimage));
+    memset(&loaded, 0, sizeof(loaded));
+    memset(&key, 0, sizeof(key));
 
     /* Clear and initialize enclave structure */
     {
@@ -596,27 +799,27 @@ oe_result_t oe_sgx_build_enclave(
     if (!context || !path || !enclave)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Load the elf object */
-    if (oe_load_enclave_image(path, &oeimage) != OE_OK)
-        OE_RAISE(OE_FAILURE);
+    /* The enclaves created by oe_create_enclave() from the same file share
+     * its image. Building an enclave for oesign (OE_SGX_LOAD_TYPE_MEASURE)
+     * always loads the file, which oesign then updates. */
+    if (context->type == OE_SGX_LOAD_TYPE_CREATE && !properties)
+        cached = oe_find_cached_image(path, &key);
 
-    // If the **properties** parameter is non-null, use those properties.
-    // Else use the properties stored in the .oeinfo section.
-    if (properties)
+    if (cached)
     {
-        props = *properties;
+        image = cached;
 
-        /* Update image to the properties passed in */
-        memcpy(oeimage.image_base + oeimage.oeinfo_rva, &props, sizeof(props));
+        OE_CHECK(_copy_ecalls(
+            cached->ecalls, cached->num_ecalls, &enclave->ecalls));
+        enclave->num_ecalls = cached->num_ecalls;
     }
     else
     {
-        /* Copy the properties from the image */
-        memcpy(&props, oeimage.image_base + oeimage.oeinfo_rva, sizeof(props));
+        image = &loaded;
+        OE_CHECK(_load_image(path, properties, enclave, &loaded));
     }
 
-    /* Validate the enclave prop_override structure */
-    OE_CHECK(oe_sgx_validate_enclave_properties(&props, NULL));
+    props = image->properties;
 
     /* Consolidate enclave-debug-flag with create-debug-flag */
     if (props.config.attributes & OE_SGX_FLAGS_DEBUG)
@@ -641,40 +844,45 @@ oe_result_t oe_sgx_build_enclave(
         }
     }
 
-    /* Calculate the size of image */
-    OE_CHECK(oeimage.calculate_size(&oeimage, &image_size));
-
-    /* Build an array of all the ECALL functions in the .ecalls section */
-    OE_CHECK(oeimage.build_ecall_array(&oeimage, enclave));
-
-    /* Build ECALL pages for enclave (list of addresses) */
-    OE_CHECK(_build_ecall_data(enclave, &ecall_data, &ecall_size));
+    /* EINIT checks the MRENCLAVE in the sigstruct of a signed enclave against
+     * the measurement taken by the platform, and simulation mode does not use
+     * the MRENCLAVE, so the enclave need not be measured on the host. Only
+     * building an enclave for oesign (OE_SGX_LOAD_TYPE_MEASURE) or loading
+     * an unsigned enclave (to debug-sign it) measures it. */
+    if (context->type == OE_SGX_LOAD_TYPE_CREATE && _is_signed(&props))
+    {
+        const sgx_sigstruct_t* sigstruct =
+            (const sgx_sigstruct_t*)props.sigstruct;
+
+        context->skip_measurement = true;
+        memcpy(
+            context->mrenclave.buf,
+            sigstruct->enclavehash,
+            sizeof(context->mrenclave.buf));
+    }
 
-    /* Calculate the size of this enclave in memory */
-    OE_CHECK(_calculate_enclave_size(
-        image_size, ecall_size, &props, &enclave_end, &enclave_size));
+    /* Index the ECALL functions by name for oe_call_enclave() */
+    OE_CHECK(_build_ecall_index(enclave));
 
     /* Perform the ECREATE operation */
-    OE_CHECK(oe_sgx_create_enclave(context, enclave_size, &enclave_addr));
+    OE_CHECK(
+        oe_sgx_create_enclave(context, image->enclave_size, &enclave_addr));
 
     /* Save the enclave base address, size, and text address */
     enclave->addr = enclave_addr;
-    enclave->size = enclave_size;
-    enclave->text = enclave_addr + oeimage.text_rva;
-
-    /* Patch image */
-    OE_CHECK(oeimage.patch(&oeimage, ecall_size, enclave_end));
+    enclave->size = image->enclave_size;
+    enclave->text = enclave_addr + image->image.text_rva;
 
     /* Add image to enclave */
-    OE_CHECK(oeimage.add_pages(&oeimage, context, enclave, &vaddr));
+    OE_CHECK(image->image.add_pages(&image->image, context, enclave, &vaddr));
 
     /* Add ecall pages */
     OE_CHECK(_add_ecall_pages(
-        context, enclave->addr, ecall_data, ecall_size, &vaddr));
+        context, enclave->addr, image->ecall_data, image->ecall_size, &vaddr));
 
     /* Add data pages */
     OE_CHECK(_oe_add_data_pages(
-        context, enclave, &props, oeimage.entry_rva, &vaddr));
+        context, enclave, &props, image->image.entry_rva, &vaddr));
 
     /* Ask the platform to initialize the enclave and finalize the hash */
     OE_CHECK(oe_sgx_initialize_enclave(
@@ -690,14 +898,21 @@ oe_result_t oe_sgx_build_enclave(
     if (context->type == OE_SGX_LOAD_TYPE_CREATE)
         enclave->magic = ENCLAVE_MAGIC;
 
+    /* Cache the image loaded for this enclave for the next ones */
+    if (!cached && key.path &&
+        _copy_ecalls(enclave->ecalls, enclave->num_ecalls, &loaded.ecalls) ==
+            OE_OK)
+    {
+        loaded.num_ecalls = enclave->num_ecalls;
+        oe_add_cached_image(&key, &loaded);
+    }
+
     result = OE_OK;
 
 done:
 
-    if (ecall_data)
-        free(ecall_data);
-
-    oe_unload_enclave_image(&oeimage);
+    oe_release_cached_image(cached);
+    oe_free_cached_image(&loaded);
 
     return result;
 }
@@ -711,6 +926,10 @@ void oe_free_enclave_ecalls(oe_enclave_t* enclave)
 
         free(enclave->ecalls);
     }
+
+    free(enclave->ecall_index);
+    enclave->ecall_index = NULL;
+    enclave->ecall_index_size = 0;
 }
 
 /*
@@ -751,7 +970,12 @@ oe_result_t oe_create_enclave(
     if (!enclave_path || !enclave_out ||
         ((enclave_type != OE_ENCLAVE_TYPE_SGX) &&
          (enclave_type != OE_ENCLAVE_TYPE_AUTO)) ||
-        (flags & OE_ENCLAVE_FLAG_RESERVED) || config || config_size > 0)
+        (flags & OE_ENCLAVE_FLAG_RESERVED))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* The optional config must be an oe_enclave_config_t */
+    if ((config && config_size != sizeof(oe_enclave_config_t)) ||
+        (!config && config_size > 0))
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Allocate and zero-fill the enclave structure */
@@ -789,6 +1013,14 @@ oe_result_t oe_create_enclave(
     /* Build the enclave */
     OE_CHECK(oe_sgx_build_enclave(&context, enclave_path, NULL, enclave));
 
+    /* Make the thread bindings created by the build available to ECALLs */
+    oe_initialize_thread_bindings(enclave);
+
+    /* Start the switchless host workers before initialization passes their
+     * ring to the enclave. */
+    OE_CHECK(oe_start_switchless_manager(
+        enclave, (const oe_enclave_config_t*)config));
+
     /* Push the new created enclave to the global list. */
     if (oe_push_enclave_instance(enclave) != 0)
     {
@@ -810,6 +1042,10 @@ oe_result_t oe_create_enclave(
     /* Invoke enclave initialization. */
     OE_CHECK(_initialize_enclave(enclave));
 
+    /* Enclave workers may only enter an initialized enclave */
+    OE_CHECK(oe_start_switchless_enclave_workers(
+        enclave, (const oe_enclave_config_t*)config));
+
     /* Setup logging configuration */
     oe_log_enclave_init(enclave);
 
@@ -820,7 +1056,9 @@ done:
 
     if (result != OE_OK && enclave)
     {
+        oe_stop_switchless_manager(enclave);
         oe_free_enclave_ecalls(enclave);
+        oe_free_host_funcs(enclave);
         free(enclave);
     }
 
@@ -837,9 +1075,18 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
     if (!enclave || enclave->magic != ENCLAVE_MAGIC)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Enclave workers must leave the enclave before it is destructed */
+    oe_stop_switchless_enclave_workers(enclave);
+
     /* Call the enclave destructor */
     OE_CHECK(oe_ecall(enclave, OE_ECALL_DESTRUCTOR, 0, NULL));
 
+    /* The enclave can no longer make switchless calls */
+    oe_stop_switchless_manager(enclave);
+
+    /* Write the messages the enclave left in its log ring */
+    oe_stop_log_flusher(enclave);
+
 #if defined(__linux__)
 
     /* Notify GDB that this enclave is terminated */
@@ -866,6 +1113,9 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
         /* Release the enclave->ecalls[] array */
         oe_free_enclave_ecalls(enclave);
 
+        /* Release the host functions resolved by name */
+        oe_free_host_funcs(enclave);
+
 #if defined(_WIN32)
 
         /* Release Windows events created during enclave creation */
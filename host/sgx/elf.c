@@ -16,6 +16,10 @@
 #include "../fopen.h"
 #include "../strings.h"
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 #define GOTO(LABEL)                                            \
     do                                                         \
     {                                                          \
@@ -258,6 +262,97 @@ static int _reset_buffer(
     return 0;
 }
 
+/* Free the file image, which is either mapped or on the heap */
+static void _free_data(elf64_t* elf)
+{
+#if defined(__linux__)
+    if (elf->map_size)
+    {
+        munmap(elf->data, elf->map_size);
+        return;
+    }
+#endif
+
+    free(elf->data);
+}
+
+/* Move a mapped file image to the heap so that it can be reallocated */
+static int _copy_data_to_heap(elf64_t* elf)
+{
+#if defined(__linux__)
+    void* data;
+
+    if (!elf->map_size)
+        return 0;
+
+    if (!(data = malloc(elf->size)))
+        return -1;
+
+    memcpy(data, elf->data, elf->size);
+    munmap(elf->data, elf->map_size);
+
+    elf->data = data;
+    elf->map_size = 0;
+#else
+    OE_UNUSED(elf);
+#endif
+
+    return 0;
+}
+
+#if defined(__linux__)
+
+/* Map the regular file open as FD whose status is ST, or leave elf->data
+ * unset if it cannot be mapped or has changed since it was opened */
+static void _map_file(int fd, const struct stat* st, elf64_t* elf)
+{
+    struct stat after;
+    void* data;
+
+    data = mmap(NULL, elf->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED)
+        return;
+
+    /* A file being rewritten is read instead, like other files */
+    if (fstat(fd, &after) != 0 || after.st_size != st->st_size ||
+        after.st_mtim.tv_sec != st->st_mtim.tv_sec ||
+        after.st_mtim.tv_nsec != st->st_mtim.tv_nsec)
+    {
+        munmap(data, elf->size);
+        return;
+    }
+
+    elf->data = data;
+    elf->map_size = elf->size;
+}
+
+#endif
+
+/*
+**==============================================================================
+**
+** elf64_load()
+**
+**     Load the ELF-64 file at PATH. On Linux the file is mapped instead of
+**     read: only the pages that are used (not the debug information, for
+**     instance) are read, and they are shared through the page cache. The
+**     mapping is private and writable, so the few pages that are modified
+**     (the .oeinfo section updated by oesign) are copied on write and the
+**     file itself never changes.
+**
+**     A private mapping does not protect against the file being changed in
+**     place, though: pages not read yet come from the new contents, and the
+**     host gets SIGBUS when it reads a page beyond the end of a truncated
+**     file. Files replaced by a new file (as linkers and install do) are not
+**     affected. The file is read instead of mapped if it changes while it is
+**     being mapped, and enclave creation drops the mapping as soon as the
+**     image is loaded (see oe_release_enclave_image_file()), so it is only
+**     exposed while the ELF file is being parsed.
+**
+**==============================================================================
+*/
+
 int elf64_load(const char* path, elf64_t* elf)
 {
     int rc = -1;
@@ -299,13 +394,24 @@ int elf64_load(const char* path, elf64_t* elf)
     /* Store the size of this file */
     elf->size = (size_t)statbuf.st_size;
 
-    /* Allocate the data to hold this image */
-    if (!(elf->data = malloc(elf->size)))
+    /* An empty file cannot be mapped (nor be an ELF file) */
+    if (elf->size < sizeof(elf64_ehdr_t))
         goto done;
 
-    /* Read the file into memory */
-    if (fread(elf->data, 1, elf->size, is) != elf->size)
-        goto done;
+#if defined(__linux__)
+    _map_file(fd, &statbuf, elf);
+#endif
+
+    if (!elf->data)
+    {
+        /* Allocate the data to hold this image */
+        if (!(elf->data = malloc(elf->size)))
+            goto done;
+
+        /* Read the file into memory */
+        if (fread(elf->data, 1, elf->size, is) != elf->size)
+            goto done;
+    }
 
     /* Validate the ELF file. */
     if (!_is_valid_elf64(elf))
@@ -323,7 +429,7 @@ done:
 
     if (rc != 0)
     {
-        free(elf->data);
+        _free_data(elf);
         memset(elf, 0, sizeof(elf64_t));
     }
 
@@ -340,7 +446,7 @@ int elf64_unload(elf64_t* elf)
     if (!_is_valid_elf64(elf))
         goto done;
 
-    free(elf->data);
+    _free_data(elf);
 
     rc = 0;
 
@@ -1594,7 +1700,10 @@ int elf64_add_section(
         sh.sh_offset = shdr->sh_offset;
     }
 
-    /* Initialize the memory buffer */
+    /* Initialize the memory buffer, which mem_insert() reallocates */
+    if (_copy_data_to_heap(elf) != 0)
+        GOTO(done);
+
     if (mem_dynamic(&mem, elf->data, elf->size, elf->size) != 0)
         GOTO(done);
 
@@ -7,6 +7,7 @@
 #include <openenclave/bits/properties.h>
 #include <openenclave/edger8r/host.h>
 #include <openenclave/host.h>
+#include <openenclave/internal/calls.h>
 #include <openenclave/internal/load.h>
 #include <openenclave/internal/sgxcreate.h>
 #include <stdbool.h>
@@ -85,6 +86,40 @@ typedef struct _thread_binding
 
 OE_STATIC_ASSERT(OE_OFFSETOF(ThreadBinding, tcs) == ThreadBinding_tcs);
 
+/*
+**==============================================================================
+**
+** oe_host_func_table_t:
+**
+**     The host functions that the enclave has called by name (oe_call_host())
+**     or resolved to a handle (oe_get_host_function_handle()). Entries are
+**     added on first use and are only released when the enclave terminates,
+**     so the position of an entry plus one serves as a stable handle. Names
+**     are found through an open-addressing index that holds entry positions
+**     plus one (zero marks an empty slot). The table is protected by
+**     oe_enclave_t.lock.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_host_func_entry
+{
+    char* name;
+    uint64_t hash;
+    oe_host_func_t func;
+} oe_host_func_entry_t;
+
+typedef struct _oe_host_func_table
+{
+    oe_host_func_entry_t* entries;
+    size_t num_entries;
+    size_t max_entries;
+
+    /* Size is zero or a power of two */
+    uint32_t* index;
+    size_t index_size;
+} oe_host_func_table_t;
+
 /* Whether this binding is busy */
 #define _OE_THREAD_BUSY 0X1UL
 
@@ -136,6 +171,23 @@ struct _oe_enclave
 
     /* Simulation mode */
     bool simulate;
+
+    /* Switchless call workers (null if none were requested) */
+    struct _oe_switchless_manager* switchless;
+
+    /* Lock-free stack of bindings that are not busy (see _assign_tcs()) */
+    volatile uint64_t free_bindings;
+    uint32_t free_binding_next[OE_SGX_MAX_TCS];
+
+    /* Host functions resolved by name */
+    oe_host_func_table_t host_funcs;
+
+    /* Open-addressing index of ecalls[] by name (see _build_ecall_index()) */
+    uint32_t* ecall_index;
+    size_t ecall_index_size;
+
+    /* Drains the log ring of the enclave (null if it logs with OCALLs) */
+    struct _oe_log_flusher* log_flusher;
 };
 
 // Static asserts for consistency with
@@ -158,7 +210,13 @@ OE_STATIC_ASSERT(
 /* Get the event for the given TCS */
 EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs);
 
+/* Make all thread bindings available to ECALLs */
+void oe_initialize_thread_bindings(oe_enclave_t* enclave);
+
 /* Free enclave ecall allocation */
 void oe_free_enclave_ecalls(oe_enclave_t* enclave);
 
+/* Free the host functions resolved by name */
+void oe_free_host_funcs(oe_enclave_t* enclave);
+
 #endif /* _OE_HOST_ENCLAVE_H */
@@ -0,0 +1,219 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <openenclave/host.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include "enclave.h"
+
+/* Initial size of the entries[] array passed to the enclave */
+#define HEAP_PROFILE_INITIAL_ENTRIES 256
+
+/*
+**==============================================================================
+**
+** oe_set_heap_profile_rate()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_set_heap_profile_rate(oe_enclave_t* enclave, size_t sample_rate)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t arg_out = 0;
+
+    if (!enclave)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(oe_ecall(
+        enclave, OE_ECALL_SET_HEAP_PROFILE_RATE, sample_rate, &arg_out));
+    OE_CHECK((oe_result_t)arg_out);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _get_heap_profile()
+**
+**     Fetch the heap profile, growing the entries[] array until it fits.
+**
+**==============================================================================
+*/
+
+static oe_result_t _get_heap_profile(
+    oe_enclave_t* enclave,
+    oe_get_heap_profile_args_t* args)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t max_entries = HEAP_PROFILE_INITIAL_ENTRIES;
+
+    args->entries = NULL;
+
+    for (;;)
+    {
+        uint64_t arg_out = 0;
+
+        free(args->entries);
+
+        if (!(args->entries = (oe_heap_profile_entry_t*)calloc(
+                  max_entries, sizeof(oe_heap_profile_entry_t))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        args->max_entries = max_entries;
+        args->num_entries = 0;
+        args->result = OE_UNEXPECTED;
+
+        OE_CHECK(oe_ecall(
+            enclave, OE_ECALL_GET_HEAP_PROFILE, (uint64_t)args, &arg_out));
+        OE_CHECK((oe_result_t)arg_out);
+
+        if (args->result != OE_BUFFER_TOO_SMALL)
+            break;
+
+        /* Stacks may be added in the meantime: leave some room */
+        max_entries = args->num_entries * 2;
+    }
+
+    OE_CHECK(args->result);
+
+    result = OE_OK;
+
+done:
+
+    if (result != OE_OK)
+    {
+        free(args->entries);
+        args->entries = NULL;
+    }
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_write_heap_profile()
+**
+**     Write the profile in the legacy text format of the gperftools heap
+**     profiler, which pprof reads:
+**
+**         heap profile: <in use>: <bytes> [<allocs>: <bytes>] @ heap_v2/<rate>
+**         <in use>: <bytes> [<allocs>: <bytes>] @ <address> <address> ...
+**         ...
+**
+**         MAPPED_LIBRARIES:
+**         <start>-<end> r-xp 00000000 00:00 0 <enclave path>
+**
+**     The heap statistics of the enclave are written as comments.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_write_heap_profile(oe_enclave_t* enclave, const char* path)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_get_heap_profile_args_t args = {0};
+    oe_heap_profile_entry_t total = {0};
+    const oe_heap_stats_t* stats = &args.stats;
+    FILE* stream = NULL;
+
+    if (!enclave || !path)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_get_heap_profile(enclave, &args));
+
+    for (uint64_t i = 0; i < args.num_entries; i++)
+    {
+        total.in_use_count += args.entries[i].in_use_count;
+        total.in_use_bytes += args.entries[i].in_use_bytes;
+        total.alloc_count += args.entries[i].alloc_count;
+        total.alloc_bytes += args.entries[i].alloc_bytes;
+    }
+
+#if defined(_WIN32)
+    if (fopen_s(&stream, path, "w") != 0)
+        stream = NULL;
+#else
+    stream = fopen(path, "w");
+#endif
+
+    if (!stream)
+        OE_RAISE(OE_FAILURE);
+
+    fprintf(
+        stream,
+        "heap profile: %llu: %llu [%llu: %llu] @ heap_v2/%llu\n",
+        (unsigned long long)total.in_use_count,
+        (unsigned long long)total.in_use_bytes,
+        (unsigned long long)total.alloc_count,
+        (unsigned long long)total.alloc_bytes,
+        (unsigned long long)args.sample_rate);
+
+    fprintf(
+        stream,
+        "# heap_size: %llu\n"
+        "# sbrk_bytes: %llu\n"
+        "# peak_sbrk_bytes: %llu\n"
+        "# system_bytes: %llu\n"
+        "# peak_system_bytes: %llu\n"
+        "# in_use_bytes: %llu\n"
+        "# free_bytes: %llu\n"
+        "# fragmented_bytes: %llu\n",
+        (unsigned long long)stats->heap_size,
+        (unsigned long long)stats->sbrk_bytes,
+        (unsigned long long)stats->peak_sbrk_bytes,
+        (unsigned long long)stats->system_bytes,
+        (unsigned long long)stats->peak_system_bytes,
+        (unsigned long long)stats->in_use_bytes,
+        (unsigned long long)stats->free_bytes,
+        (unsigned long long)stats->fragmented_bytes);
+
+    for (uint64_t i = 0; i < args.num_entries; i++)
+    {
+        const oe_heap_profile_entry_t* entry = &args.entries[i];
+
+        fprintf(
+            stream,
+            "%llu: %llu [%llu: %llu] @",
+            (unsigned long long)entry->in_use_count,
+            (unsigned long long)entry->in_use_bytes,
+            (unsigned long long)entry->alloc_count,
+            (unsigned long long)entry->alloc_bytes);
+
+        for (uint64_t j = 0;
+             j < entry->num_frames && j < OE_HEAP_PROFILE_MAX_FRAMES;
+             j++)
+            fprintf(stream, " 0x%llx", (unsigned long long)entry->frames[j]);
+
+        fprintf(stream, "\n");
+    }
+
+    /* The enclave image is loaded at the start of the enclave */
+    fprintf(
+        stream,
+        "\nMAPPED_LIBRARIES:\n%llx-%llx r-xp 00000000 00:00 0 %s\n",
+        (unsigned long long)enclave->addr,
+        (unsigned long long)(enclave->addr + enclave->size),
+        enclave->path);
+
+    if (ferror(stream))
+        OE_RAISE(OE_FAILURE);
+
+    result = OE_OK;
+
+done:
+
+    if (stream)
+        fclose(stream);
+
+    free(args.entries);
+
+    return result;
+}
@@ -0,0 +1,228 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "imagecache.h"
+#include <openenclave/internal/queue.h>
+#include <openenclave/internal/trace.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "../strings.h"
+
+typedef struct _image_entry
+{
+    /* Must be first: oe_release_cached_image() casts the image back */
+    oe_cached_image_t image;
+
+    OE_LIST_ENTRY(_image_entry) next_entry;
+
+    /* Identity of the file (key.path is owned by the entry) */
+    oe_image_cache_key_t key;
+
+    /* Number of enclaves being created from the image */
+    size_t refs;
+} ImageEntry;
+
+/* Most recently used entries first */
+static OE_LIST_HEAD(ImageListHead, _image_entry) _image_list_head;
+static oe_mutex _image_list_lock = OE_H_MUTEX_INITIALIZER;
+
+static bool _same_file(
+    const oe_image_cache_key_t* key1,
+    const oe_image_cache_key_t* key2)
+{
+    return key1->dev == key2->dev && key1->ino == key2->ino &&
+           key1->size == key2->size && key1->mtime_sec == key2->mtime_sec &&
+           key1->mtime_nsec == key2->mtime_nsec &&
+           strcmp(key1->path, key2->path) == 0;
+}
+
+static void _free_entry(ImageEntry* entry)
+{
+    oe_free_cached_image(&entry->image);
+    free((char*)entry->key.path);
+    free(entry);
+}
+
+/*
+**==============================================================================
+**
+** _trim_cache()
+**
+**     Free the least recently used entries that are not referenced beyond
+**     the first OE_IMAGE_CACHE_MAX_UNUSED, and the unreferenced entries of
+**     files that changed since they were cached (**stale**). Called with
+**     the lock held.
+**
+**==============================================================================
+*/
+
+static void _trim_cache(const oe_image_cache_key_t* stale)
+{
+    ImageEntry* entry;
+    ImageEntry* next;
+    size_t unused = 0;
+
+    OE_LIST_FOREACH_SAFE(entry, &_image_list_head, next_entry, next)
+    {
+        if (entry->refs)
+            continue;
+
+        if ((stale && strcmp(entry->key.path, stale->path) == 0 &&
+             !_same_file(&entry->key, stale)) ||
+            ++unused > OE_IMAGE_CACHE_MAX_UNUSED)
+        {
+            OE_LIST_REMOVE(entry, next_entry);
+            _free_entry(entry);
+        }
+    }
+}
+
+oe_cached_image_t* oe_find_cached_image(
+    const char* path,
+    oe_image_cache_key_t* key)
+{
+    ImageEntry* entry;
+    ImageEntry* found = NULL;
+    struct stat st;
+
+    memset(key, 0, sizeof(*key));
+
+    if (!path || stat(path, &st) != 0)
+        return NULL;
+
+    key->path = path;
+    key->dev = (uint64_t)st.st_dev;
+    key->ino = (uint64_t)st.st_ino;
+    key->size = (uint64_t)st.st_size;
+    key->mtime_sec = (uint64_t)st.st_mtime;
+#if defined(__linux__)
+    key->mtime_nsec = (uint64_t)st.st_mtim.tv_nsec;
+#endif
+
+    if (oe_mutex_lock(&_image_list_lock) != 0)
+        abort();
+
+    OE_LIST_FOREACH(entry, &_image_list_head, next_entry)
+    {
+        if (_same_file(&entry->key, key))
+        {
+            found = entry;
+            break;
+        }
+    }
+
+    if (found)
+    {
+        found->refs++;
+
+        /* Keep the list in most recently used order */
+        OE_LIST_REMOVE(found, next_entry);
+        OE_LIST_INSERT_HEAD(&_image_list_head, found, next_entry);
+    }
+    else
+    {
+        /* The file was rebuilt or replaced: drop its old images */
+        _trim_cache(key);
+    }
+
+    if (oe_mutex_unlock(&_image_list_lock) != 0)
+        abort();
+
+    return found ? &found->image : NULL;
+}
+
+void oe_add_cached_image(
+    const oe_image_cache_key_t* key,
+    oe_cached_image_t* image)
+{
+    ImageEntry* entry = NULL;
+    ImageEntry* tmp;
+
+    if (!key->path)
+        goto fail;
+
+    if (!(entry = (ImageEntry*)calloc(1, sizeof(ImageEntry))))
+        goto fail;
+
+    entry->key = *key;
+
+    if (!(entry->key.path = oe_strdup(key->path)))
+        goto fail;
+
+    entry->image = *image;
+    memset(image, 0, sizeof(*image));
+
+    if (oe_mutex_lock(&_image_list_lock) != 0)
+        abort();
+
+    /* Another thread may have cached the same file in the meantime */
+    OE_LIST_FOREACH(tmp, &_image_list_head, next_entry)
+    {
+        if (_same_file(&tmp->key, &entry->key))
+            break;
+    }
+
+    if (!tmp)
+    {
+        OE_LIST_INSERT_HEAD(&_image_list_head, entry, next_entry);
+        _trim_cache(NULL);
+        entry = NULL;
+    }
+
+    if (oe_mutex_unlock(&_image_list_lock) != 0)
+        abort();
+
+    if (entry)
+        _free_entry(entry);
+
+    return;
+
+fail:
+    OE_TRACE_WARNING("Failed to cache enclave image\n");
+
+    if (entry)
+    {
+        free((char*)entry->key.path);
+        free(entry);
+    }
+
+    oe_free_cached_image(image);
+}
+
+void oe_release_cached_image(oe_cached_image_t* image)
+{
+    ImageEntry* entry = (ImageEntry*)image;
+
+    if (!image)
+        return;
+
+    if (oe_mutex_lock(&_image_list_lock) != 0)
+        abort();
+
+    if (--entry->refs == 0)
+        _trim_cache(NULL);
+
+    if (oe_mutex_unlock(&_image_list_lock) != 0)
+        abort();
+}
+
+void oe_free_cached_image(oe_cached_image_t* image)
+{
+    if (!image)
+        return;
+
+    oe_unload_enclave_image(&image->image);
+
+    if (image->ecalls)
+    {
+        for (size_t i = 0; i < image->num_ecalls; i++)
+            free(image->ecalls[i].name);
+
+        free(image->ecalls);
+    }
+
+    free(image->ecall_data);
+    memset(image, 0, sizeof(*image));
+}
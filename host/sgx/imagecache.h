@@ -0,0 +1,101 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_IMAGECACHE_H
+#define _OE_HOST_SGX_IMAGECACHE_H
+
+#include <openenclave/host.h>
+#include <openenclave/internal/load.h>
+#include <openenclave/internal/properties.h>
+#include "enclave.h"
+
+OE_EXTERNC_BEGIN
+
+/* Maximum number of images kept in the cache while no enclave is being
+ * created from them */
+#define OE_IMAGE_CACHE_MAX_UNUSED 16
+
+/*
+**==============================================================================
+**
+** oe_cached_image_t
+**
+**     An enclave image loaded and patched by oe_sgx_build_enclave() together
+**     with the layout computed from it. None of it depends on the address of
+**     the enclave, so one cached image is shared by all the enclaves created
+**     from the same file. It is not modified once it is in the cache.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_cached_image
+{
+    /* Image loaded from the file and patched for the layout below */
+    oe_enclave_image_t image;
+
+    /* Properties of the image, as read before patching */
+    oe_sgx_enclave_properties_t properties;
+
+    /* ECALL functions of the image, copied into each enclave */
+    ECallNameAddr* ecalls;
+    size_t num_ecalls;
+
+    /* ECALL pages added after the relocation pages */
+    void* ecall_data;
+    size_t ecall_size;
+
+    /* Layout of the enclave */
+    size_t image_size;
+    size_t enclave_end;
+    size_t enclave_size;
+} oe_cached_image_t;
+
+/* Identity of an enclave file when it was looked up in the cache */
+typedef struct _oe_image_cache_key
+{
+    const char* path;
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    uint64_t mtime_sec;
+    uint64_t mtime_nsec;
+} oe_image_cache_key_t;
+
+/**
+ * Find the cached image of an enclave file.
+ *
+ * The file is identified by its path, device, inode, size and modification
+ * time, so an image is never reused once its file has been rebuilt or
+ * replaced. The returned image is referenced until it is passed to
+ * oe_release_cached_image().
+ *
+ * @param path path of the enclave file
+ * @param key set to the identity of the file, to be passed to
+ *        oe_add_cached_image() if the image is not cached
+ *
+ * @returns the cached image or NULL if it is not cached (or the file cannot
+ *          be found, in which case **key->path** is NULL)
+ */
+oe_cached_image_t* oe_find_cached_image(
+    const char* path,
+    oe_image_cache_key_t* key);
+
+/**
+ * Add an image loaded from the file identified by **key** to the cache.
+ *
+ * The cache takes over the contents of **image** and clears it. They are
+ * freed right away if another thread cached the same file first.
+ */
+void oe_add_cached_image(
+    const oe_image_cache_key_t* key,
+    oe_cached_image_t* image);
+
+/* Drop the reference returned by oe_find_cached_image() */
+void oe_release_cached_image(oe_cached_image_t* image);
+
+/* Free the contents of an image that is not in the cache */
+void oe_free_cached_image(oe_cached_image_t* image);
+
+OE_EXTERNC_END
+
+#endif /* _OE_HOST_SGX_IMAGECACHE_H */
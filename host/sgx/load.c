@@ -98,6 +98,18 @@ oe_result_t oe_unload_enclave_image(oe_enclave_image_t* oeimage)
     return oeimage->unload(oeimage);
 }
 
+oe_result_t oe_release_enclave_image_file(oe_enclave_image_t* oeimage)
+{
+    if (!oeimage)
+        return OE_INVALID_PARAMETER;
+
+    /* Loaders that keep no file data do not set release_file */
+    if (!oeimage->release_file)
+        return OE_OK;
+
+    return oeimage->release_file(oeimage);
+}
+
 oe_result_t oe_sgx_load_enclave_properties(
     const oe_enclave_image_t* oeimage,
     const char* section_name,
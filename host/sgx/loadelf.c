@@ -28,7 +28,7 @@ static oe_result_t _oe_free_elf_image(oe_enclave_image_t* image)
 {
     if (image->u.elf.elf.data)
     {
-        free(image->u.elf.elf.data);
+        elf64_unload(&image->u.elf.elf);
     }
 
     if (image->image_base)
@@ -429,6 +429,22 @@ static oe_result_t _unload(oe_enclave_image_t* image)
     return _oe_free_elf_image(image);
 }
 
+/* Enclave pages come from image_base and reloc_data alone, so the ELF file
+ * is only needed to look up symbols and to write the signed file */
+static oe_result_t _release_file(oe_enclave_image_t* image)
+{
+    if (image->u.elf.elf.data)
+    {
+        elf64_unload(&image->u.elf.elf);
+        memset(&image->u.elf.elf, 0, sizeof(image->u.elf.elf));
+    }
+
+    for (size_t i = 0; i < image->u.elf.num_segments; i++)
+        image->u.elf.segments[i].filedata = NULL;
+
+    return OE_OK;
+}
+
 // ------------------------------------------------------------------
 
 /*
@@ -496,22 +512,17 @@ static oe_result_t _add_relocation_pages(
     if (!context || !vaddr)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    if (reloc_data && reloc_size)
+    if (reloc_data && reloc_size >= sizeof(oe_page_t))
     {
-        const oe_page_t* pages = (const oe_page_t*)reloc_data;
+        uint64_t addr = enclave_addr + *vaddr;
+        uint64_t src = (uint64_t)reloc_data;
         size_t npages = reloc_size / sizeof(oe_page_t);
+        uint64_t flags = SGX_SECINFO_REG | SGX_SECINFO_R;
+        bool extend = true;
 
-        for (size_t i = 0; i < npages; i++)
-        {
-            uint64_t addr = enclave_addr + *vaddr;
-            uint64_t src = (uint64_t)&pages[i];
-            uint64_t flags = SGX_SECINFO_REG | SGX_SECINFO_R;
-            bool extend = true;
-
-            OE_CHECK(oe_sgx_load_enclave_data(
-                context, enclave_addr, addr, src, flags, extend));
-            (*vaddr) += sizeof(oe_page_t);
-        }
+        OE_CHECK(oe_sgx_load_enclave_pages(
+            context, enclave_addr, addr, src, npages, flags, extend));
+        (*vaddr) += npages * sizeof(oe_page_t);
     }
 
     result = OE_OK;
@@ -549,13 +560,15 @@ static oe_result_t _add_segment_pages(
 
     flags |= SGX_SECINFO_REG;
 
-    for (; page_rva < segment_end; page_rva += OE_PAGE_SIZE)
+    /* Add all the pages of the segment at once */
+    if (page_rva < segment_end)
     {
-        OE_CHECK(oe_sgx_load_enclave_data(
+        OE_CHECK(oe_sgx_load_enclave_pages(
             context,
             enclave_addr,
             enclave_addr + page_rva,
             (uint64_t)image + page_rva,
+            (segment_end - page_rva + OE_PAGE_SIZE - 1) / OE_PAGE_SIZE,
             flags,
             true));
     }
@@ -867,6 +880,9 @@ static oe_result_t _sgx_update_enclave_properties(
     oe_result_t result = OE_UNEXPECTED;
     OE_UNUSED(section_name);
 
+    if (!image->u.elf.elf.data)
+        OE_RAISE(OE_UNSUPPORTED);
+
     /* Copy to both the image and ELF file*/
     OE_CHECK(oe_memcpy_s(
         (uint8_t*)image->u.elf.elf.data + image->oeinfo_file_pos,
@@ -914,6 +930,7 @@ oe_result_t oe_load_elf_enclave_image(
     image->sgx_load_enclave_properties = _sgx_load_enclave_properties;
     image->sgx_update_enclave_properties = _sgx_update_enclave_properties;
     image->unload = _unload;
+    image->release_file = _release_file;
 
     result = OE_OK;
 
@@ -0,0 +1,275 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "logring.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+#include <openenclave/internal/raise.h>
+#include "../memalign.h"
+#include "enclave.h"
+
+/* Time between two drains of the ring by the flusher thread */
+#define LOG_FLUSH_INTERVAL_MSEC 10
+
+#if defined(__linux__)
+#define _compiler_barrier() asm volatile("" ::: "memory")
+#elif defined(_WIN32)
+#define _compiler_barrier() _ReadWriteBarrier()
+#endif
+
+/*
+**==============================================================================
+**
+** _drain_ring()
+**
+**     Write the complete records at the tail of the ring to the log with a
+**     single flush, zero them and advance the tail.
+**
+**==============================================================================
+*/
+
+static void _drain_ring(oe_log_flusher_t* flusher)
+{
+    oe_log_ring_t* ring = flusher->ring;
+    uint64_t head = ring->head;
+    uint64_t tail = ring->tail;
+    uint64_t dropped = ring->dropped;
+    FILE* stream;
+
+    if (tail == head && dropped == flusher->dropped)
+        return;
+
+    stream = log_begin_batch();
+
+    while (tail != head)
+    {
+        uint64_t offset = tail & (OE_LOG_RING_SIZE - 1);
+        oe_log_record_t* record = (oe_log_record_t*)(ring->data + offset);
+        uint32_t size = record->size;
+
+        /* Stop at the first record that is not complete yet */
+        if (size == 0)
+            break;
+
+        _compiler_barrier();
+
+        /* A record the enclave did not write properly ends the batch */
+        if (size % sizeof(oe_log_record_t) ||
+            size > OE_LOG_RING_SIZE - offset || size > head - tail)
+        {
+            memset(ring->data + offset, 0, OE_LOG_RING_SIZE - offset);
+            memset(ring->data, 0, offset);
+            tail = head;
+            break;
+        }
+
+        if (stream && record->level < OE_LOG_LEVEL_MAX &&
+            size > sizeof(oe_log_record_t))
+        {
+            /* The enclave terminates the message within the record */
+            ((char*)record)[size - 1] = '\0';
+
+            log_batch_message(
+                stream,
+                record->thread,
+                (log_level_t)record->level,
+                (const char*)(record + 1));
+        }
+
+        memset(record, 0, size);
+        tail += size;
+    }
+
+    if (stream && dropped != flusher->dropped)
+    {
+        char message[64];
+
+        snprintf(
+            message,
+            sizeof(message),
+            "%llu log messages dropped (log ring full)\n",
+            (unsigned long long)(dropped - flusher->dropped));
+        log_batch_message(stream, 0, OE_LOG_LEVEL_WARNING, message);
+    }
+
+    flusher->dropped = dropped;
+
+    if (stream)
+        log_end_batch(stream);
+
+    /* Release the consumed records to the enclave */
+    _compiler_barrier();
+    ring->tail = tail;
+}
+
+#if defined(__linux__)
+static void* _flusher_thread(void* arg)
+#elif defined(_WIN32)
+static DWORD WINAPI _flusher_thread(LPVOID arg)
+#endif
+{
+    oe_log_flusher_t* flusher = (oe_log_flusher_t*)arg;
+
+#if defined(__linux__)
+
+    pthread_mutex_lock(&flusher->mutex);
+
+    while (!flusher->stop)
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += LOG_FLUSH_INTERVAL_MSEC * 1000000L;
+
+        if (ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+
+        pthread_cond_timedwait(&flusher->cond, &flusher->mutex, &ts);
+
+        pthread_mutex_unlock(&flusher->mutex);
+        _drain_ring(flusher);
+        pthread_mutex_lock(&flusher->mutex);
+    }
+
+    pthread_mutex_unlock(&flusher->mutex);
+
+    return NULL;
+
+#elif defined(_WIN32)
+
+    while (!flusher->stop)
+    {
+        WaitForSingleObject(flusher->event, LOG_FLUSH_INTERVAL_MSEC);
+        _drain_ring(flusher);
+    }
+
+    return 0;
+
+#endif
+}
+
+/*
+**==============================================================================
+**
+** oe_start_log_flusher()
+**
+**     Create the log ring of the enclave and start the thread that drains
+**     it. The ring is passed to the enclave by oe_log_enclave_init().
+**
+**==============================================================================
+*/
+
+oe_result_t oe_start_log_flusher(oe_enclave_t* enclave)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_log_flusher_t* flusher = NULL;
+
+    if (!enclave || enclave->log_flusher)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(flusher = (oe_log_flusher_t*)calloc(1, sizeof(*flusher))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    flusher->ring = (oe_log_ring_t*)oe_memalign(64, sizeof(oe_log_ring_t));
+
+    if (!flusher->ring)
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(flusher->ring, 0, sizeof(*flusher->ring));
+
+#if defined(__linux__)
+
+    pthread_mutex_init(&flusher->mutex, NULL);
+    pthread_cond_init(&flusher->cond, NULL);
+
+    if (pthread_create(&flusher->thread, NULL, _flusher_thread, flusher))
+    {
+        pthread_cond_destroy(&flusher->cond);
+        pthread_mutex_destroy(&flusher->mutex);
+        OE_RAISE_MSG(OE_FAILURE, "pthread_create failed", NULL);
+    }
+
+#elif defined(_WIN32)
+
+    if (!(flusher->event = CreateEvent(0, FALSE, FALSE, 0)))
+        OE_RAISE_MSG(OE_FAILURE, "CreateEvent failed", NULL);
+
+    if (!(flusher->thread =
+              CreateThread(NULL, 0, _flusher_thread, flusher, 0, NULL)))
+    {
+        CloseHandle(flusher->event);
+        OE_RAISE_MSG(OE_FAILURE, "CreateThread failed", NULL);
+    }
+
+#endif
+
+    enclave->log_flusher = flusher;
+    flusher = NULL;
+
+    result = OE_OK;
+
+done:
+
+    if (flusher)
+    {
+        oe_memalign_free(flusher->ring);
+        free(flusher);
+    }
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_stop_log_flusher()
+**
+**     Stop the flusher thread, write the records left in the ring and free
+**     it. The enclave must no longer log.
+**
+**==============================================================================
+*/
+
+void oe_stop_log_flusher(oe_enclave_t* enclave)
+{
+    oe_log_flusher_t* flusher;
+
+    if (!enclave || !(flusher = enclave->log_flusher))
+        return;
+
+#if defined(__linux__)
+
+    pthread_mutex_lock(&flusher->mutex);
+    flusher->stop = true;
+    pthread_cond_signal(&flusher->cond);
+    pthread_mutex_unlock(&flusher->mutex);
+
+    pthread_join(flusher->thread, NULL);
+    pthread_cond_destroy(&flusher->cond);
+    pthread_mutex_destroy(&flusher->mutex);
+
+#elif defined(_WIN32)
+
+    flusher->stop = true;
+    SetEvent(flusher->event);
+
+    WaitForSingleObject(flusher->thread, INFINITE);
+    CloseHandle(flusher->thread);
+    CloseHandle(flusher->event);
+
+#endif
+
+    _drain_ring(flusher);
+
+    enclave->log_flusher = NULL;
+    oe_memalign_free(flusher->ring);
+    free(flusher);
+}
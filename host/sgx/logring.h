@@ -0,0 +1,51 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_LOGRING_H
+#define _OE_HOST_SGX_LOGRING_H
+
+#include <openenclave/host.h>
+#include <openenclave/internal/trace.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+/*
+**==============================================================================
+**
+** oe_log_flusher_t
+**
+**     The log ring of an enclave (oe_enclave_t.log_flusher) and the host
+**     thread that drains it into the log every LOG_FLUSH_INTERVAL_MSEC.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_log_flusher
+{
+    oe_log_ring_t* ring;
+
+    /* Dropped records already reported in the log */
+    uint64_t dropped;
+
+    /* Set to stop the thread */
+    volatile bool stop;
+
+#if defined(__linux__)
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+#elif defined(_WIN32)
+    HANDLE event;
+    HANDLE thread;
+#endif
+} oe_log_flusher_t;
+
+oe_result_t oe_start_log_flusher(oe_enclave_t* enclave);
+
+void oe_stop_log_flusher(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_SGX_LOGRING_H */
@@ -6,6 +6,8 @@
 
 #include "enclave.h"
 
+oe_result_t oe_handle_call_host_function(uint64_t arg, oe_enclave_t* enclave);
+
 void HandleMalloc(uint64_t arg_in, uint64_t* arg_out);
 void HandleRealloc(uint64_t arg_in, uint64_t* arg_out);
 void HandleFree(uint64_t arg);
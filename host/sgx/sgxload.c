@@ -483,7 +483,8 @@ oe_result_t oe_sgx_create_enclave(
         OE_RAISE(OE_OUT_OF_MEMORY);
 
     /* Measure this operation */
-    OE_CHECK(oe_sgx_measure_create_enclave(&context->hash_context, secs));
+    if (!context->skip_measurement)
+        OE_CHECK(oe_sgx_measure_create_enclave(&context->hash_context, secs));
 
     if (context->type == OE_SGX_LOAD_TYPE_MEASURE)
     {
@@ -674,17 +675,19 @@ static void _dump_load_enclave_data(
 
 #endif /* defined(OE_TRACE_MEASURE) */
 
-oe_result_t oe_sgx_load_enclave_data(
+oe_result_t oe_sgx_load_enclave_pages(
     oe_sgx_load_context_t* context,
     uint64_t base,
     uint64_t addr,
     uint64_t src,
+    size_t npages,
     uint64_t flags,
     bool extend)
 {
     oe_result_t result = OE_UNEXPECTED;
+    uint64_t size;
 
-    if (!context || !base || !addr || !src || !flags)
+    if (!context || !base || !addr || !src || !npages || !flags)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     if (context->state != OE_SGX_LOAD_STATE_ENCLAVE_CREATED)
@@ -694,15 +697,24 @@ oe_result_t oe_sgx_load_enclave_data(
     if (addr % OE_PAGE_SIZE)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    OE_CHECK(oe_safe_mul_u64(npages, OE_PAGE_SIZE, &size));
+
 #if defined(OE_TRACE_MEASURE)
 
-    _dump_load_enclave_data(addr - base, flags, src, extend);
+    for (uint64_t offset = 0; offset < size; offset += OE_PAGE_SIZE)
+    {
+        _dump_load_enclave_data(
+            addr + offset - base, flags, src + offset, extend);
+    }
 
 #endif /* defined(OE_TRACE_MEASURE) */
 
     /* Measure this operation */
-    OE_CHECK(oe_sgx_measure_load_enclave_data(
-        &context->hash_context, base, addr, src, flags, extend));
+    if (!context->skip_measurement)
+    {
+        OE_CHECK(oe_sgx_measure_load_enclave_pages(
+            &context->hash_context, base, addr, src, npages, flags, extend));
+    }
 
     if (context->type == OE_SGX_LOAD_TYPE_MEASURE)
     {
@@ -713,16 +725,16 @@ oe_result_t oe_sgx_load_enclave_data(
     else if (oe_sgx_is_simulation_load_context(context))
     {
         /* Simulate enclave add page */
-        /* Verify that page is within enclave boundaries */
+        /* Verify that the pages are within enclave boundaries */
         if ((void*)addr < context->sim.addr ||
+            size > context->sim.size ||
             (uint8_t*)addr >
-                (uint8_t*)context->sim.addr + context->sim.size - OE_PAGE_SIZE)
+                (uint8_t*)context->sim.addr + context->sim.size - size)
             OE_RAISE_MSG(
                 OE_FAILURE, "Page is NOT within enclave boundaries", NULL);
 
         /* Copy page contents onto memory-mapped region */
-        OE_CHECK(oe_memcpy_s(
-            (uint8_t*)addr, OE_PAGE_SIZE, (uint8_t*)src, OE_PAGE_SIZE));
+        OE_CHECK(oe_memcpy_s((uint8_t*)addr, size, (uint8_t*)src, size));
 
         /* Set page access permissions */
         {
@@ -733,7 +745,7 @@ oe_result_t oe_sgx_load_enclave_data(
                     OE_FAILURE, "Unexpected page protections: %#x", prot);
 
 #if defined(__linux__)
-            if (mprotect((void*)addr, OE_PAGE_SIZE, prot) != 0)
+            if (mprotect((void*)addr, size, prot) != 0)
                 OE_RAISE_MSG(
                     OE_FAILURE,
                     "mprotect failed (addr=%#x, prot=%#x)",
@@ -741,7 +753,7 @@ oe_result_t oe_sgx_load_enclave_data(
                     prot);
 #elif defined(_WIN32)
             DWORD old;
-            if (!VirtualProtect((LPVOID)addr, OE_PAGE_SIZE, prot, &old))
+            if (!VirtualProtect((LPVOID)addr, size, prot, &old))
                 OE_RAISE_MSG(
                     OE_FAILURE,
                     "VirtualProtect failed (addr=%#x, prot=%#x)",
@@ -761,10 +773,10 @@ oe_result_t oe_sgx_load_enclave_data(
         uint32_t enclave_error;
         if (enclave_load_data(
                 (void*)addr,
-                OE_PAGE_SIZE,
+                size,
                 (const void*)src,
                 (uint32_t)protect,
-                &enclave_error) != OE_PAGE_SIZE)
+                &enclave_error) != size)
             OE_RAISE_MSG(
                 OE_PLATFORM_ERROR,
                 "enclave_load_data failed (addr=%#x, prot=%#x, err=%#x)",
@@ -774,15 +786,23 @@ oe_result_t oe_sgx_load_enclave_data(
 
 #elif defined(__linux__)
 
-        /* Ask the Linux SGX driver to add a page to the enclave
-           sgxioctl internally traces any driver returned error */
-        if (sgx_ioctl_enclave_add_page(
-                context->dev, addr, src, flags, extend) != 0)
-            OE_RAISE(OE_IOCTL_FAILED);
+        /* Ask the Linux SGX driver to add the pages to the enclave. The
+           driver adds one page per ioctl. sgxioctl internally traces any
+           driver returned error */
+        for (uint64_t offset = 0; offset < size; offset += OE_PAGE_SIZE)
+        {
+            if (sgx_ioctl_enclave_add_page(
+                    context->dev,
+                    addr + offset,
+                    src + offset,
+                    flags,
+                    extend) != 0)
+                OE_RAISE(OE_IOCTL_FAILED);
+        }
 
 #elif defined(_WIN32)
 
-        /* Ask the OS to add a page to the enclave */
+        /* Ask the OS to add the pages to the enclave */
         SIZE_T num_bytes = 0;
         DWORD enclave_error;
 
@@ -795,7 +815,7 @@ oe_result_t oe_sgx_load_enclave_data(
                 GetCurrentProcess(),
                 (LPVOID)addr,
                 (LPCVOID)src,
-                OE_PAGE_SIZE,
+                size,
                 protect,
                 NULL,
                 0,
@@ -819,6 +839,18 @@ done:
     return result;
 }
 
+oe_result_t oe_sgx_load_enclave_data(
+    oe_sgx_load_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    uint64_t src,
+    uint64_t flags,
+    bool extend)
+{
+    return oe_sgx_load_enclave_pages(
+        context, base, addr, src, 1, flags, extend);
+}
+
 oe_result_t oe_sgx_initialize_enclave(
     oe_sgx_load_context_t* context,
     uint64_t addr,
@@ -837,8 +869,11 @@ oe_result_t oe_sgx_initialize_enclave(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Measure this operation */
-    OE_CHECK(
-        oe_sgx_measure_initialize_enclave(&context->hash_context, mrenclave));
+    if (context->skip_measurement)
+        *mrenclave = context->mrenclave;
+    else
+        OE_CHECK(oe_sgx_measure_initialize_enclave(
+            &context->hash_context, mrenclave));
 
     /* EINIT has no further action in measurement/simulation mode */
     if (context->type == OE_SGX_LOAD_TYPE_CREATE &&
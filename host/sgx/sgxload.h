@@ -37,6 +37,19 @@ oe_result_t oe_sgx_load_enclave_data(
     uint64_t flags,
     bool extend);
 
+/* Add NPAGES pages at ADDR from the contiguous pages at SRC, all with the
+ * same FLAGS. The pages are measured one by one, but the platform is asked
+ * to add them with one call where it supports it (simulation mode, libsgx
+ * and Windows), instead of one call per page. */
+oe_result_t oe_sgx_load_enclave_pages(
+    oe_sgx_load_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    uint64_t src,
+    size_t npages,
+    uint64_t flags,
+    bool extend);
+
 oe_result_t oe_sgx_initialize_enclave(
     oe_sgx_load_context_t* context,
     uint64_t addr,
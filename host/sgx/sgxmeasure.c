@@ -6,6 +6,7 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/trace.h>
+#include <string.h>
 
 static void _measure_zeros(oe_sha256_context_t* context, size_t size)
 {
@@ -26,26 +27,60 @@ static void _measure_zeros(oe_sha256_context_t* context, size_t size)
     }
 }
 
-static void _measure_eextend(
+/* Size of the record of an EADD or an EEXTEND in the measurement */
+#define MEASURE_RECORD_SIZE 64
+
+/* Size of the data measured by one EEXTEND */
+#define EEXTEND_CHUNK_SIZE 256
+
+/* Number of EADD records hashed at once for pages that are not extended */
+#define EADD_BATCH 64
+
+/* Size of the measurement of an extended page: its EADD record followed by
+ * the record and the data of each EEXTEND */
+#define EXTENDED_PAGE_MEASURE_SIZE                                    \
+    (MEASURE_RECORD_SIZE + (OE_PAGE_SIZE / EEXTEND_CHUNK_SIZE) *      \
+                               (MEASURE_RECORD_SIZE + EEXTEND_CHUNK_SIZE))
+
+static uint8_t* _write_eadd_record(
+    uint8_t* p,
+    uint64_t vaddr,
+    uint64_t flags)
+{
+    memset(p, 0, MEASURE_RECORD_SIZE);
+    memcpy(p, "EADD\0\0\0", 8);
+    memcpy(p + 8, &vaddr, sizeof(vaddr));
+    memcpy(p + 16, &flags, sizeof(flags));
+
+    return p + MEASURE_RECORD_SIZE;
+}
+
+/* Measure the EADD and the EEXTENDs of a page with a single update */
+static void _measure_extended_page(
     oe_sha256_context_t* context,
     uint64_t vaddr,
     uint64_t flags,
     const void* page)
 {
-    uint64_t pgoff = 0;
-    const uint64_t CHUNK_SIZE = 256;
-    OE_UNUSED(flags);
+    uint8_t buffer[EXTENDED_PAGE_MEASURE_SIZE];
+    uint8_t* p = _write_eadd_record(buffer, vaddr, flags);
+    uint64_t pgoff;
 
     /* Write this page one chunk at a time */
-    for (pgoff = 0; pgoff < OE_PAGE_SIZE; pgoff += CHUNK_SIZE)
+    for (pgoff = 0; pgoff < OE_PAGE_SIZE; pgoff += EEXTEND_CHUNK_SIZE)
     {
         const uint64_t moffset = vaddr + pgoff;
 
-        oe_sha256_update(context, "EEXTEND", 8);
-        oe_sha256_update(context, &moffset, sizeof(moffset));
-        _measure_zeros(context, 48);
-        oe_sha256_update(context, (const uint8_t*)page + pgoff, CHUNK_SIZE);
+        memset(p, 0, MEASURE_RECORD_SIZE);
+        memcpy(p, "EEXTEND", 8);
+        memcpy(p + 8, &moffset, sizeof(moffset));
+        p += MEASURE_RECORD_SIZE;
+
+        memcpy(p, (const uint8_t*)page + pgoff, EEXTEND_CHUNK_SIZE);
+        p += EEXTEND_CHUNK_SIZE;
     }
+
+    oe_sha256_update(context, buffer, sizeof(buffer));
 }
 
 oe_result_t oe_sgx_measure_create_enclave(
@@ -72,11 +107,12 @@ done:
     return result;
 }
 
-oe_result_t oe_sgx_measure_load_enclave_data(
+oe_result_t oe_sgx_measure_load_enclave_pages(
     oe_sha256_context_t* context,
     uint64_t base,
     uint64_t addr,
     uint64_t src,
+    size_t npages,
     uint64_t flags,
     bool extend)
 {
@@ -86,15 +122,34 @@ oe_result_t oe_sgx_measure_load_enclave_data(
     if (!context || !base || !addr || !src || !flags || addr < base)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Measure EADD */
-    oe_sha256_update(context, "EADD\0\0\0", 8);
-    oe_sha256_update(context, &vaddr, sizeof(vaddr));
-    oe_sha256_update(context, &flags, sizeof(flags));
-    _measure_zeros(context, 40);
-
-    /* Measure EEXTEND if requested */
     if (extend)
-        _measure_eextend(context, vaddr, flags, (void*)src);
+    {
+        /* Measure EADD and EEXTEND */
+        for (size_t i = 0; i < npages; i++)
+        {
+            uint64_t offset = i * OE_PAGE_SIZE;
+
+            _measure_extended_page(
+                context, vaddr + offset, flags, (const void*)(src + offset));
+        }
+    }
+    else
+    {
+        /* Measure EADD only, for a batch of pages at a time */
+        uint8_t records[EADD_BATCH * MEASURE_RECORD_SIZE];
+
+        while (npages)
+        {
+            size_t n = npages < EADD_BATCH ? npages : EADD_BATCH;
+            uint8_t* p = records;
+
+            for (size_t i = 0; i < n; i++, vaddr += OE_PAGE_SIZE)
+                p = _write_eadd_record(p, vaddr, flags);
+
+            oe_sha256_update(context, records, n * MEASURE_RECORD_SIZE);
+            npages -= n;
+        }
+    }
 
     result = OE_OK;
 
@@ -102,6 +157,18 @@ done:
     return result;
 }
 
+oe_result_t oe_sgx_measure_load_enclave_data(
+    oe_sha256_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    uint64_t src,
+    uint64_t flags,
+    bool extend)
+{
+    return oe_sgx_measure_load_enclave_pages(
+        context, base, addr, src, 1, flags, extend);
+}
+
 oe_result_t oe_sgx_measure_initialize_enclave(
     oe_sha256_context_t* context,
     OE_SHA256* mrenclave)
@@ -21,6 +21,17 @@ oe_result_t oe_sgx_measure_load_enclave_data(
     uint64_t flags,
     bool extend);
 
+/* Measure the EADD (and EEXTEND) of NPAGES contiguous pages at ADDR, with
+ * the same FLAGS, like oe_sgx_measure_load_enclave_data() for each page */
+oe_result_t oe_sgx_measure_load_enclave_pages(
+    oe_sha256_context_t* context,
+    uint64_t base,
+    uint64_t addr,
+    uint64_t src,
+    size_t npages,
+    uint64_t flags,
+    bool extend);
+
 oe_result_t oe_sgx_measure_initialize_enclave(
     oe_sha256_context_t* context,
     OE_SHA256* mrenclave);
@@ -0,0 +1,707 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "switchless.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include "../memalign.h"
+#include "enclave.h"
+#include "ocalls.h"
+
+/* Number of empty polls after which an idle host worker goes to sleep, and
+ * after which a host caller waiting on an enclave worker starts yielding */
+#define SWITCHLESS_SPIN_COUNT 100000
+
+#if defined(__linux__)
+#define _compiler_barrier() asm volatile("" ::: "memory")
+#define _cpu_relax() __builtin_ia32_pause()
+#define _yield() sched_yield()
+#elif defined(_WIN32)
+#define _compiler_barrier() _ReadWriteBarrier()
+#define _cpu_relax() YieldProcessor()
+#define _yield() SwitchToThread()
+#endif
+
+/*
+**==============================================================================
+**
+** _wait_event()
+** _signal_event()
+**
+**     Counting wait/wake on a worker event; same scheme as the enclave
+**     thread events (see HandleThreadWait() and HandleThreadWake()).
+**
+**==============================================================================
+*/
+
+static void _wait_event(EnclaveEvent* event)
+{
+#if defined(__linux__)
+
+    if (__sync_fetch_and_add(&event->value, (uint32_t)-1) == 0)
+    {
+        do
+        {
+            syscall(
+                __NR_futex,
+                &event->value,
+                FUTEX_WAIT_PRIVATE,
+                -1,
+                NULL,
+                NULL,
+                0);
+        } while (event->value == (uint32_t)-1);
+    }
+
+#elif defined(_WIN32)
+
+    WaitForSingleObject(event->handle, INFINITE);
+
+#endif
+}
+
+static void _signal_event(EnclaveEvent* event)
+{
+#if defined(__linux__)
+
+    if (__sync_fetch_and_add(&event->value, 1) != 0)
+        syscall(
+            __NR_futex, &event->value, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+
+#elif defined(_WIN32)
+
+    SetEvent(event->handle);
+
+#endif
+}
+
+/* Move a sleeping worker back to IDLE and wake it up */
+static void _wake_worker(oe_switchless_worker_t* worker)
+{
+    if (oe_atomic_compare_and_swap(
+            &worker->slot->state,
+            OE_SWITCHLESS_SLOT_SLEEPING,
+            OE_SWITCHLESS_SLOT_IDLE))
+    {
+        _signal_event(&worker->event);
+    }
+}
+
+/*
+**==============================================================================
+**
+** _host_worker_thread()
+**
+**     Poll the worker's slot and dispatch posted host function calls. After
+**     SWITCHLESS_SPIN_COUNT empty polls, park in the SLEEPING state until an
+**     enclave thread that fell back to a regular OCALL asks for a wake-up.
+**     When an enclave thread sleeps in oe_ocall_wait_any() for the call just
+**     dispatched, wake it through its TCS event.
+**
+**==============================================================================
+*/
+
+static void _sleep_worker(oe_switchless_worker_t* worker)
+{
+    oe_switchless_slot_t* slot = worker->slot;
+
+    if (oe_atomic_compare_and_swap(
+            &slot->state, OE_SWITCHLESS_SLOT_IDLE, OE_SWITCHLESS_SLOT_SLEEPING))
+    {
+        /* Recheck after publishing SLEEPING so a concurrent stop is seen */
+        if (!worker->manager->stop)
+            _wait_event(&worker->event);
+
+        oe_atomic_compare_and_swap(
+            &slot->state, OE_SWITCHLESS_SLOT_SLEEPING, OE_SWITCHLESS_SLOT_IDLE);
+    }
+}
+
+#if defined(__linux__)
+static void* _host_worker_thread(void* arg)
+#elif defined(_WIN32)
+static DWORD WINAPI _host_worker_thread(LPVOID arg)
+#endif
+{
+    oe_switchless_worker_t* worker = (oe_switchless_worker_t*)arg;
+    oe_switchless_manager_t* manager = worker->manager;
+    oe_switchless_slot_t* slot = worker->slot;
+    size_t spins = 0;
+
+    while (!manager->stop)
+    {
+        uint64_t state = slot->state;
+
+        if (state == OE_SWITCHLESS_SLOT_POSTED)
+        {
+            _compiler_barrier();
+
+            oe_handle_call_host_function(
+                (uint64_t)&slot->args.host_function, manager->enclave);
+            worker->calls++;
+
+            /* Hand the results back to the enclave (full barrier) */
+            oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_POSTED,
+                OE_SWITCHLESS_SLOT_DONE);
+
+            /* Wake an enclave thread waiting for this asynchronous call */
+            {
+                uint64_t tcs = *worker->waiter;
+
+                if (tcs && oe_atomic_compare_and_swap(worker->waiter, tcs, 0))
+                    HandleThreadWake(manager->enclave, tcs);
+            }
+
+            spins = 0;
+        }
+        else if (state == OE_SWITCHLESS_SLOT_IDLE &&
+                 ++spins >= SWITCHLESS_SPIN_COUNT)
+        {
+            _sleep_worker(worker);
+            spins = 0;
+        }
+        else
+        {
+            _cpu_relax();
+        }
+    }
+
+#if defined(__linux__)
+    return NULL;
+#elif defined(_WIN32)
+    return 0;
+#endif
+}
+
+#if defined(__linux__)
+static void* _enclave_worker_thread(void* arg)
+#elif defined(_WIN32)
+static DWORD WINAPI _enclave_worker_thread(LPVOID arg)
+#endif
+{
+    oe_switchless_worker_t* worker = (oe_switchless_worker_t*)arg;
+    uint64_t arg_out = 0;
+
+    /* Returns once the ring is stopped. If no TCS is available the ecall
+     * fails and the slot stays OFFLINE, so callers never wait on it. */
+    oe_ecall(
+        worker->manager->enclave,
+        OE_ECALL_SWITCHLESS_WORKER,
+        (uint64_t)&worker->args,
+        &arg_out);
+
+#if defined(__linux__)
+    return NULL;
+#elif defined(_WIN32)
+    return 0;
+#endif
+}
+
+#if defined(__linux__)
+typedef void* (*_thread_proc_t)(void*);
+#elif defined(_WIN32)
+typedef LPTHREAD_START_ROUTINE _thread_proc_t;
+#endif
+
+static oe_result_t _create_worker_thread(
+    oe_switchless_worker_t* worker,
+    _thread_proc_t proc)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+#if defined(__linux__)
+
+    if (pthread_create(&worker->thread, NULL, proc, worker))
+        OE_RAISE_MSG(OE_FAILURE, "pthread_create failed", NULL);
+
+#elif defined(_WIN32)
+
+    if (!(worker->thread = CreateThread(NULL, 0, proc, worker, 0, NULL)))
+        OE_RAISE_MSG(OE_FAILURE, "CreateThread failed", NULL);
+
+#endif
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+static void _join_worker_thread(oe_switchless_worker_t* worker)
+{
+#if defined(__linux__)
+
+    pthread_join(worker->thread, NULL);
+
+#elif defined(_WIN32)
+
+    WaitForSingleObject(worker->thread, INFINITE);
+    CloseHandle(worker->thread);
+
+#endif
+}
+
+/* Allocate a ring in host memory on a cache-line boundary */
+static oe_switchless_ring_t* _create_ring(size_t num_slots, uint64_t state)
+{
+    oe_switchless_ring_t* ring;
+
+    if (!(ring = (oe_switchless_ring_t*)oe_memalign(64, sizeof(*ring))))
+        return NULL;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->num_slots = num_slots;
+
+    for (size_t i = 0; i < OE_SWITCHLESS_MAX_WORKERS; i++)
+        ring->slots[i].state = state;
+
+    return ring;
+}
+
+/*
+**==============================================================================
+**
+** oe_start_switchless_manager()
+**
+**     Validate the switchless settings of the enclave configuration (if
+**     any), create the manager and start the host workers. Enclave workers
+**     are started after initialization (oe_start_switchless_enclave_workers).
+**
+**==============================================================================
+*/
+
+oe_result_t oe_start_switchless_manager(
+    oe_enclave_t* enclave,
+    const oe_enclave_config_t* config)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_manager_t* manager = NULL;
+    size_t num_workers;
+
+    if (!enclave)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Nothing to do if no switchless workers were requested */
+    if (!config ||
+        (config->num_host_workers == 0 && config->num_enclave_workers == 0))
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    /* Enclave workers keep their TCS; leave at least one for regular ecalls */
+    if (config->num_host_workers > OE_SWITCHLESS_MAX_WORKERS ||
+        config->num_enclave_workers > OE_SWITCHLESS_MAX_WORKERS ||
+        config->num_enclave_workers >= enclave->num_bindings)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(manager = (oe_switchless_manager_t*)calloc(1, sizeof(*manager))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    manager->enclave = enclave;
+    enclave->switchless = manager;
+
+    if ((num_workers = config->num_host_workers) == 0)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    if (!(manager->host_worker_ring =
+              _create_ring(num_workers, OE_SWITCHLESS_SLOT_IDLE)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < num_workers; i++)
+    {
+        oe_switchless_worker_t* worker = &manager->host_workers[i];
+
+        worker->manager = manager;
+        worker->slot = &manager->host_worker_ring->slots[i];
+        worker->waiter = &manager->host_worker_ring->waiters[i];
+
+#if defined(_WIN32)
+
+        if (!(worker->event.handle = CreateEvent(0, FALSE, FALSE, 0)))
+            OE_RAISE_MSG(OE_FAILURE, "CreateEvent failed", NULL);
+
+#endif
+
+        if (_create_worker_thread(worker, _host_worker_thread) != OE_OK)
+        {
+#if defined(_WIN32)
+            CloseHandle(worker->event.handle);
+#endif
+            OE_RAISE(OE_FAILURE);
+        }
+
+        manager->num_host_workers++;
+    }
+
+    result = OE_OK;
+
+done:
+
+    if (result != OE_OK && enclave)
+        oe_stop_switchless_manager(enclave);
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_start_switchless_enclave_workers()
+**
+**     Start the enclave workers. Each one enters the enclave and keeps its
+**     TCS until oe_stop_switchless_enclave_workers() is called.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_start_switchless_enclave_workers(
+    oe_enclave_t* enclave,
+    const oe_enclave_config_t* config)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_manager_t* manager = enclave->switchless;
+    oe_switchless_ring_t* ring;
+    size_t num_workers;
+
+    if (!manager || !config || config->num_enclave_workers == 0)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    num_workers = config->num_enclave_workers;
+
+    /* Slots become IDLE once their worker is running inside the enclave */
+    if (!(ring = _create_ring(num_workers, OE_SWITCHLESS_SLOT_OFFLINE)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    manager->enclave_worker_ring = ring;
+
+    for (size_t i = 0; i < num_workers; i++)
+    {
+        oe_switchless_worker_t* worker = &manager->enclave_workers[i];
+
+        worker->manager = manager;
+        worker->slot = &ring->slots[i];
+        worker->args.ring = ring;
+        worker->args.slot = i;
+
+        OE_CHECK(_create_worker_thread(worker, _enclave_worker_thread));
+        manager->num_enclave_workers++;
+    }
+
+    result = OE_OK;
+
+done:
+
+    if (result != OE_OK)
+        oe_stop_switchless_enclave_workers(enclave);
+
+    return result;
+}
+
+/* Move a parked enclave worker back to IDLE and signal its TCS event */
+static void _wake_enclave_worker(
+    oe_enclave_t* enclave,
+    oe_switchless_worker_t* worker)
+{
+    if (oe_atomic_compare_and_swap(
+            &worker->slot->state,
+            OE_SWITCHLESS_SLOT_SLEEPING,
+            OE_SWITCHLESS_SLOT_IDLE))
+    {
+        HandleThreadWake(enclave, worker->args.tcs);
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_stop_switchless_enclave_workers()
+**
+**     Make the enclave workers return from the enclave and join them. Must
+**     be called before the enclave destructor runs.
+**
+**==============================================================================
+*/
+
+void oe_stop_switchless_enclave_workers(oe_enclave_t* enclave)
+{
+    oe_switchless_manager_t* manager = enclave->switchless;
+    oe_switchless_ring_t* ring;
+
+    if (!manager || !(ring = manager->enclave_worker_ring) || ring->stop)
+        return;
+
+    ring->stop = 1;
+
+    for (size_t i = 0; i < manager->num_enclave_workers; i++)
+        _wake_enclave_worker(enclave, &manager->enclave_workers[i]);
+
+    for (size_t i = 0; i < manager->num_enclave_workers; i++)
+        _join_worker_thread(&manager->enclave_workers[i]);
+}
+
+/*
+**==============================================================================
+**
+** oe_stop_switchless_manager()
+**
+**     Stop and join all workers and release the shared rings. Must only be
+**     called once the enclave can no longer make switchless calls.
+**
+**==============================================================================
+*/
+
+void oe_stop_switchless_manager(oe_enclave_t* enclave)
+{
+    oe_switchless_manager_t* manager = enclave->switchless;
+
+    if (!manager)
+        return;
+
+    oe_stop_switchless_enclave_workers(enclave);
+
+    manager->stop = true;
+
+    for (size_t i = 0; i < manager->num_host_workers; i++)
+        _wake_worker(&manager->host_workers[i]);
+
+    for (size_t i = 0; i < manager->num_host_workers; i++)
+    {
+        _join_worker_thread(&manager->host_workers[i]);
+
+#if defined(_WIN32)
+        CloseHandle(manager->host_workers[i].event.handle);
+#endif
+    }
+
+    if (manager->host_worker_ring)
+        oe_memalign_free(manager->host_worker_ring);
+
+    if (manager->enclave_worker_ring)
+        oe_memalign_free(manager->enclave_worker_ring);
+
+    free(manager);
+    enclave->switchless = NULL;
+}
+
+/*
+**==============================================================================
+**
+** oe_wake_switchless_host_workers()
+**
+**     Called after servicing a regular OCALL_CALL_HOST_FUNCTION. Wakes the
+**     sleeping workers if the enclave asked for it.
+**
+**==============================================================================
+*/
+
+void oe_wake_switchless_host_workers(oe_switchless_manager_t* manager)
+{
+    oe_switchless_ring_t* ring = manager->host_worker_ring;
+
+    if (!ring || !ring->wake_requested)
+        return;
+
+    if (!oe_atomic_compare_and_swap(&ring->wake_requested, 1, 0))
+        return;
+
+    for (size_t i = 0; i < manager->num_host_workers; i++)
+        _wake_worker(&manager->host_workers[i]);
+}
+
+/*
+**==============================================================================
+**
+** _post_to_enclave_worker()
+**
+**     Post the call to the slot of the given enclave worker (already claimed
+**     by the caller) and wait until the worker has dispatched it. Callers
+**     spin first and then yield the processor; waking them through a futex
+**     would cost the enclave worker an OCALL per request.
+**
+**==============================================================================
+*/
+
+static oe_result_t _post_to_enclave_worker(
+    oe_enclave_t* enclave,
+    oe_switchless_worker_t* worker,
+    bool sleeping,
+    const oe_call_enclave_function_args_t* call,
+    size_t* output_bytes_written)
+{
+    oe_switchless_slot_t* slot = worker->slot;
+    oe_result_t result;
+    size_t bytes_written;
+    size_t spins = 0;
+
+    slot->args.enclave_function = *call;
+
+    /* Publish the request (full barrier) */
+    oe_atomic_compare_and_swap(
+        &slot->state, OE_SWITCHLESS_SLOT_CLAIMED, OE_SWITCHLESS_SLOT_POSTED);
+
+    if (sleeping)
+        HandleThreadWake(enclave, worker->args.tcs);
+
+    while (slot->state != OE_SWITCHLESS_SLOT_DONE)
+    {
+        if (++spins < SWITCHLESS_SPIN_COUNT)
+            _cpu_relax();
+        else
+            _yield();
+    }
+
+    _compiler_barrier();
+
+    /* Collect the results before handing the slot back. The slot is owned
+     * by this caller so the counter needs no atomic update. */
+    result = slot->args.enclave_function.result;
+    bytes_written = slot->args.enclave_function.output_bytes_written;
+    worker->calls++;
+
+    oe_atomic_compare_and_swap(
+        &slot->state, OE_SWITCHLESS_SLOT_DONE, OE_SWITCHLESS_SLOT_IDLE);
+
+    if (result == OE_OK)
+        *output_bytes_written = bytes_written;
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_switchless_call_enclave_function()
+**
+**     Try each enclave worker slot in turn (waking a parked worker if its
+**     slot is the first one available); fall back to a regular ECALL when
+**     none is available.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    oe_switchless_manager_t* manager;
+
+    /* Reject invalid parameters */
+    if (!enclave)
+        return OE_INVALID_PARAMETER;
+
+    manager = enclave->switchless;
+
+    if (manager && manager->num_enclave_workers)
+    {
+        oe_switchless_ring_t* ring = manager->enclave_worker_ring;
+        oe_call_enclave_function_args_t call;
+
+        call.function_id = function_id;
+        call.input_buffer = input_buffer;
+        call.input_buffer_size = input_buffer_size;
+        call.output_buffer = output_buffer;
+        call.output_buffer_size = output_buffer_size;
+        call.output_bytes_written = 0;
+        call.result = OE_UNEXPECTED;
+
+        for (size_t i = 0; i < manager->num_enclave_workers; i++)
+        {
+            oe_switchless_worker_t* worker = &manager->enclave_workers[i];
+            uint64_t state = worker->slot->state;
+
+            if ((state == OE_SWITCHLESS_SLOT_IDLE ||
+                 state == OE_SWITCHLESS_SLOT_SLEEPING) &&
+                oe_atomic_compare_and_swap(
+                    &worker->slot->state, state, OE_SWITCHLESS_SLOT_CLAIMED))
+            {
+                return _post_to_enclave_worker(
+                    enclave,
+                    worker,
+                    state == OE_SWITCHLESS_SLOT_SLEEPING,
+                    &call,
+                    output_bytes_written);
+            }
+        }
+
+        oe_atomic_increment(&ring->fallbacks);
+    }
+
+    return oe_call_enclave_function(
+        enclave,
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written);
+}
+
+/*
+**==============================================================================
+**
+** oe_get_switchless_stats()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_switchless_stats(
+    oe_enclave_t* enclave,
+    oe_switchless_stats_t* stats)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_manager_t* manager;
+
+    if (!enclave || enclave->magic != ENCLAVE_MAGIC || !stats)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    memset(stats, 0, sizeof(*stats));
+
+    if ((manager = enclave->switchless))
+    {
+        for (size_t i = 0; i < manager->num_host_workers; i++)
+            stats->ocall_hits += manager->host_workers[i].calls;
+
+        for (size_t i = 0; i < manager->num_enclave_workers; i++)
+            stats->ecall_hits += manager->enclave_workers[i].calls;
+
+        if (manager->host_worker_ring)
+            stats->ocall_fallbacks = manager->host_worker_ring->fallbacks;
+
+        if (manager->enclave_worker_ring)
+            stats->ecall_fallbacks = manager->enclave_worker_ring->fallbacks;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_SWITCHLESS_H
+#define _OE_HOST_SGX_SWITCHLESS_H
+
+#include <openenclave/host.h>
+#include <openenclave/internal/switchless.h>
+#include "enclave.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+typedef struct _oe_switchless_manager oe_switchless_manager_t;
+
+/*
+**==============================================================================
+**
+** oe_switchless_worker_t
+**
+**     A host thread that services one slot of a switchless ring. Host workers
+**     dispatch host functions themselves; enclave workers enter the enclave
+**     (OE_ECALL_SWITCHLESS_WORKER) and poll from inside.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_switchless_worker
+{
+    oe_switchless_manager_t* manager;
+
+    /* The slot this worker polls */
+    oe_switchless_slot_t* slot;
+
+    /* Waiter of the slot (host workers only; see oe_switchless_ring_t) */
+    volatile uint64_t* waiter;
+
+    /* Number of calls dispatched by this worker */
+    volatile uint64_t calls;
+
+    /* Signaled to wake a host worker from the SLEEPING state */
+    EnclaveEvent event;
+
+    /* Argument of the worker ecall (enclave workers only) */
+    oe_switchless_worker_args_t args;
+
+#if defined(__linux__)
+    pthread_t thread;
+#elif defined(_WIN32)
+    HANDLE thread;
+#endif
+} oe_switchless_worker_t;
+
+/*
+**==============================================================================
+**
+** oe_switchless_manager_t
+**
+**     The switchless state of an enclave (oe_enclave_t.switchless).
+**
+**==============================================================================
+*/
+
+struct _oe_switchless_manager
+{
+    oe_enclave_t* enclave;
+
+    /* Set to stop the host workers */
+    volatile bool stop;
+
+    /* Ring shared with the enclave, serviced by host workers */
+    oe_switchless_ring_t* host_worker_ring;
+    size_t num_host_workers;
+    oe_switchless_worker_t host_workers[OE_SWITCHLESS_MAX_WORKERS];
+
+    /* Ring shared with the enclave, serviced by enclave workers */
+    oe_switchless_ring_t* enclave_worker_ring;
+    size_t num_enclave_workers;
+    oe_switchless_worker_t enclave_workers[OE_SWITCHLESS_MAX_WORKERS];
+};
+
+oe_result_t oe_start_switchless_manager(
+    oe_enclave_t* enclave,
+    const oe_enclave_config_t* config);
+
+oe_result_t oe_start_switchless_enclave_workers(
+    oe_enclave_t* enclave,
+    const oe_enclave_config_t* config);
+
+void oe_stop_switchless_enclave_workers(oe_enclave_t* enclave);
+
+void oe_stop_switchless_manager(oe_enclave_t* enclave);
+
+void oe_wake_switchless_host_workers(oe_switchless_manager_t* manager);
+
+#endif /* _OE_HOST_SGX_SWITCHLESS_H */
@@ -14,12 +14,14 @@
 #include <time.h>
 #include "../hostthread.h"
 #include "enclave.h"
+#include "logring.h"
 
 #define LOGGING_FORMAT_STRING "%02d:%02d:%02d:%06ld tid(0x%lx) (%s)[%s]%s"
 static char* _log_level_strings[OE_LOG_LEVEL_MAX] =
     {"NONE", "FATAL", "ERROR", "WARN", "INFO", "VERBOSE"};
 static oe_mutex _log_lock = OE_H_MUTEX_INITIALIZER;
 static const char* _log_file_name = NULL;
+static FILE* _log_file = NULL;
 static bool _log_creation_failed_before = false;
 static log_level_t _log_level = OE_LOG_LEVEL_ERROR;
 static bool _initialized = false;
@@ -90,7 +92,9 @@ static void _write_header_info_to_stream(FILE* stream)
 static void _write_message_to_stream(
     FILE* stream,
     bool is_enclave,
-    oe_log_args_t* args)
+    unsigned long thread_id,
+    log_level_t level,
+    const char* message)
 {
 #if defined(__linux__)
     struct timeval time_now;
@@ -101,8 +105,6 @@ static void _write_message_to_stream(
     struct tm* t = localtime(&lt);
 #endif
 
-    oe_thread thread_id = oe_thread_self();
-
     fprintf(
         stream,
         LOGGING_FORMAT_STRING,
@@ -116,8 +118,28 @@ static void _write_message_to_stream(
 #endif
         thread_id,
         (is_enclave ? "E" : "H"),
-        _log_level_strings[args->level],
-        args->message);
+        _log_level_strings[level],
+        message);
+}
+
+// Return the stream to log to, opening the log file on first use. The file
+// stays open so that each message costs a write and a flush only. Must be
+// called with the log file lock held.
+static FILE* _get_log_stream(void)
+{
+    if (!_log_file_name)
+        return stdout;
+
+    if (_log_creation_failed_before)
+        return NULL;
+
+    if (!_log_file && !(_log_file = fopen(_log_file_name, "a")))
+    {
+        fprintf(stderr, "Failed to create logfile %s\n", _log_file_name);
+        _log_creation_failed_before = true;
+    }
+
+    return _log_file;
 }
 
 static void _log_session_header()
@@ -128,53 +150,61 @@ static void _log_session_header()
     }
 
     // Take the log file lock.
-    if (!_log_creation_failed_before)
+    if (oe_mutex_lock(&_log_lock) == OE_OK)
     {
-        if (oe_mutex_lock(&_log_lock) == OE_OK)
-        {
-            FILE* log_file = NULL;
-            log_file = fopen(_log_file_name, "a");
-            if (log_file == NULL)
-            {
-                fprintf(
-                    stderr, "Failed to create logfile %s\n", _log_file_name);
-                oe_mutex_unlock(&_log_lock);
-                _log_creation_failed_before = true;
-                return;
-            }
+        FILE* log_file = _get_log_stream();
 
+        if (log_file)
+        {
             _write_header_info_to_stream(log_file);
             fflush(log_file);
-            fclose(log_file);
-            oe_mutex_unlock(&_log_lock);
         }
+
+        oe_mutex_unlock(&_log_lock);
+    }
+}
+
+static void _initialize_log()
+{
+    if (!_initialized)
+    {
+        _initialize_log_config();
+        _log_session_header();
     }
 }
 
 oe_result_t oe_log_enclave_init(oe_enclave_t* enclave)
 {
     oe_result_t result = OE_UNEXPECTED;
-    log_level_t level = _log_level;
+    oe_log_filter_t arg;
 
-    _initialize_log_config();
+    _initialize_log();
 
     // Populate arg fields.
-    oe_log_filter_t* arg = calloc(1, sizeof(oe_log_filter_t));
-    if (arg == NULL)
+    memset(&arg, 0, sizeof(arg));
+    arg.path = enclave->path;
+    arg.path_len = strlen(enclave->path);
+    arg.level = _log_level;
+
+    // Debug enclaves logging INFO or more log through a ring
+    if ((enclave->debug || enclave->simulate) &&
+        _log_level >= OE_LOG_LEVEL_INFO)
     {
-        result = OE_OUT_OF_MEMORY;
-        goto done;
+        if (oe_start_log_flusher(enclave) == OE_OK)
+            arg.ring = enclave->log_flusher->ring;
     }
-    arg->path = enclave->path;
-    arg->path_len = strlen(enclave->path);
-    arg->level = level;
+
     // Call enclave
-    result = oe_ecall(enclave, OE_ECALL_LOG_INIT, (uint64_t)arg, NULL);
+    result = oe_ecall(enclave, OE_ECALL_LOG_INIT, (uint64_t)&arg, NULL);
     if (result != OE_OK)
         goto done;
 
     result = OE_OK;
 done:
+
+    if (result != OE_OK)
+        oe_stop_log_flusher(enclave);
+
     return result;
 }
 
@@ -198,49 +228,74 @@ void oe_log(log_level_t level, const char* fmt, ...)
     log_message(false, &args);
 }
 
-// This is an expensive operation, it involves acquiring lock
-// and file operation.
+// This involves acquiring a lock and writing to the log file.
 void log_message(bool is_enclave, oe_log_args_t* args)
 {
-    if (!_initialized)
-    {
-        _initialize_log_config();
-        _log_session_header();
-    }
-    if (_initialized)
-    {
-        if (args->level > _log_level)
-            return;
-    }
+    _initialize_log();
+
+    if (args->level > _log_level)
+        return;
 
     // Take the log file lock.
     if (oe_mutex_lock(&_log_lock) == OE_OK)
     {
-        if (!_log_file_name)
-        {
-            _write_message_to_stream(stdout, is_enclave, args);
-        }
-        else if (!_log_creation_failed_before)
+        FILE* stream = _get_log_stream();
+
+        if (stream)
         {
-            FILE* log_file = NULL;
-            log_file = fopen(_log_file_name, "a");
-            if (log_file == NULL)
-            {
-                fprintf(
-                    stderr, "Failed to create logfile %s\n", _log_file_name);
-                oe_mutex_unlock(&_log_lock);
-                _log_creation_failed_before = true;
-                return;
-            }
-            _write_message_to_stream(log_file, is_enclave, args);
-            fflush(log_file);
-            fclose(log_file);
+            _write_message_to_stream(
+                stream,
+                is_enclave,
+                (unsigned long)oe_thread_self(),
+                args->level,
+                args->message);
+
+            if (stream != stdout)
+                fflush(stream);
         }
+
         // Release the log file lock.
         oe_mutex_unlock(&_log_lock);
     }
 }
 
+// Take the log file lock for a batch of enclave messages and return the
+// stream to write them to, or null if they cannot be logged.
+FILE* log_begin_batch(void)
+{
+    FILE* stream;
+
+    _initialize_log();
+
+    if (oe_mutex_lock(&_log_lock) != OE_OK)
+        return NULL;
+
+    if (!(stream = _get_log_stream()))
+        oe_mutex_unlock(&_log_lock);
+
+    return stream;
+}
+
+void log_batch_message(
+    FILE* stream,
+    uint64_t thread,
+    log_level_t level,
+    const char* message)
+{
+    if (level > _log_level || level >= OE_LOG_LEVEL_MAX)
+        return;
+
+    _write_message_to_stream(
+        stream, true, (unsigned long)thread, level, message);
+}
+
+// Flush the batch and release the log file lock.
+void log_end_batch(FILE* stream)
+{
+    fflush(stream);
+    oe_mutex_unlock(&_log_lock);
+}
+
 log_level_t get_current_logging_level(void)
 {
     return _log_level;
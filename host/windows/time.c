@@ -65,3 +65,53 @@ void oe_handle_get_time(uint64_t arg_in, uint64_t* arg_out)
     if (arg_out)
         *arg_out = _time();
 }
+
+/* Return nanoseconds elapsed since the Epoch. */
+static uint64_t _realtime()
+{
+    FILETIME ft;
+    ULARGE_INTEGER x;
+    const uint64_t NSEC_PER_TICK = 100UL;
+
+    GetSystemTimePreciseAsFileTime(&ft);
+    x.u.LowPart = ft.dwLowDateTime;
+    x.u.HighPart = ft.dwHighDateTime;
+    x.QuadPart -= POSIX_TO_WINDOWS_EPOCH_TICKS;
+
+    return (x.QuadPart * NSEC_PER_TICK);
+}
+
+/* Return nanoseconds elapsed since the system started. */
+static uint64_t _monotonic()
+{
+    LARGE_INTEGER count;
+    LARGE_INTEGER frequency;
+    const uint64_t SEC_TO_NSEC = 1000000000UL;
+
+    if (!QueryPerformanceCounter(&count) ||
+        !QueryPerformanceFrequency(&frequency))
+        return (uint64_t)-1;
+
+    return ((uint64_t)count.QuadPart / frequency.QuadPart) * SEC_TO_NSEC +
+           ((uint64_t)count.QuadPart % frequency.QuadPart) * SEC_TO_NSEC /
+               frequency.QuadPart;
+}
+
+void oe_handle_get_clock(uint64_t arg_in, uint64_t* arg_out)
+{
+    if (!arg_out)
+        return;
+
+    switch ((oe_clock_t)arg_in)
+    {
+        case OE_CLOCK_REALTIME:
+            *arg_out = _realtime();
+            break;
+        case OE_CLOCK_MONOTONIC:
+            *arg_out = _monotonic();
+            break;
+        default:
+            *arg_out = (uint64_t)-1;
+            break;
+    }
+}
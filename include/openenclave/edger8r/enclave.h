@@ -73,12 +73,139 @@ oe_result_t oe_call_host_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Perform a switchless high-level host function call (OCALL).
+ *
+ * This function has the same semantics as oe_call_host_function() but
+ * attempts to hand the call to a host worker thread through a shared request
+ * ring instead of exiting the enclave. If the host did not start any
+ * switchless workers, or if all workers are busy, the call falls back to a
+ * regular OCALL.
+ *
+ * Edger8r emits calls to this function for untrusted functions marked with
+ * the **transition_using_threads** attribute.
+ *
+ * @param function_id The id of the host function that will be called.
+ * @param input_buffer Buffer containing inputs data.
+ * @param input_buffer_size Size of the input data buffer.
+ * @param output_buffer Buffer where the outputs of the host function are
+ * written to.
+ * @param output_buffer_size Size of the output buffer.
+ * @param output_bytes_written Number of bytes written in the output buffer.
+ *
+ * @return See oe_call_host_function().
+ */
+oe_result_t oe_switchless_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written);
+
+/**
+ * Completion token of an asynchronous host function call.
+ *
+ * The fields are internal. A token must be zero-initialized before its first
+ * use; it can be reused once the call it tracks has been reaped by
+ * oe_ocall_poll() or oe_ocall_wait_any().
+ */
+typedef struct _oe_ocall_token
+{
+    uint64_t state;
+    uint64_t slot;
+    oe_result_t result;
+    size_t output_bytes_written;
+} oe_ocall_token_t;
+
+/**
+ * Start a high-level host function call (OCALL) without waiting for it.
+ *
+ * This function has the same semantics as oe_call_host_function() but hands
+ * the call to a host worker thread and returns immediately, so that the
+ * calling thread can keep several host calls in flight. The outcome of the
+ * call is collected with oe_ocall_poll() or oe_ocall_wait_any().
+ *
+ * Each call in flight occupies one host worker (see the
+ * **num_host_workers** field of oe_enclave_config_t) until it is reaped. If
+ * no host worker is free, the call is made synchronously with a regular
+ * OCALL and the token is already complete when this function returns.
+ *
+ * Since the host accesses them after this function returns, the input and
+ * output buffers must lie in host memory (for example, allocated with
+ * oe_host_malloc()) and remain valid until the call is reaped.
+ *
+ * @param function_id The id of the host function that will be called.
+ * @param input_buffer Buffer containing inputs data (in host memory).
+ * @param input_buffer_size Size of the input data buffer.
+ * @param output_buffer Buffer where the outputs of the host function are
+ * written to (in host memory).
+ * @param output_buffer_size Size of the output buffer.
+ * @param token The token that tracks the call.
+ *
+ * @return OE_OK the call was started (or made).
+ * @return OE_INVALID_PARAMETER a parameter is invalid or the token is
+ * still in use.
+ */
+oe_result_t oe_call_host_function_async(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    oe_ocall_token_t* token);
+
+/**
+ * Reap an asynchronous host function call if it has completed.
+ *
+ * @param token The token passed to oe_call_host_function_async().
+ * @param output_bytes_written Number of bytes written in the output buffer.
+ *
+ * @return OE_BUSY the call has not completed yet.
+ * @return OE_NOT_FOUND the token does not track a call.
+ * @return Otherwise the result of the call (see oe_call_host_function()).
+ * The token is released.
+ */
+oe_result_t oe_ocall_poll(
+    oe_ocall_token_t* token,
+    size_t* output_bytes_written);
+
+/**
+ * Wait for any of several asynchronous host function calls to complete.
+ *
+ * Reap the first completed call among **tokens**, blocking the calling
+ * thread until one completes. Tokens that do not track a call are skipped.
+ * The calling thread spins for a while and then sleeps until a host worker
+ * wakes it.
+ *
+ * @param tokens Array of tokens passed to oe_call_host_function_async().
+ * @param num_tokens Number of elements in the **tokens** array.
+ * @param index Index of the reaped token.
+ * @param output_bytes_written Number of bytes written in the output buffer
+ * of the reaped call.
+ *
+ * @return OE_NOT_FOUND none of the tokens tracks a call.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return Otherwise the result of the reaped call (see
+ * oe_call_host_function()). Its token is released.
+ */
+oe_result_t oe_ocall_wait_any(
+    oe_ocall_token_t* tokens,
+    size_t num_tokens,
+    size_t* index,
+    size_t* output_bytes_written);
+
 /**
  * Allocate a buffer of given size for doing an ocall.
  *
  * The buffer may or may not be allocated in host memory.
  * The buffer should be treated as untrusted.
  *
+ * Buffers are carved from a per-thread stack of host memory and should be
+ * freed in the reverse order of their allocation (last in, first out). A
+ * buffer freed out of order stays intact, as do the buffers allocated after
+ * it, but its memory is only reclaimed once those buffers are freed too.
+ *
  * @param size The size in bytes of the buffer.
  * @returns pointer to the allocated buffer.
  * @return NULL if allocation failed.
@@ -88,10 +215,52 @@ void* oe_allocate_ocall_buffer(size_t size);
 /**
  * Free the buffer allocated for ocalls.
  *
+ * Buffers should be freed in the reverse order of their allocation (see
+ * oe_allocate_ocall_buffer()).
+ *
  * @param buffer The buffer allocated via oe_allocate_ocall_buffer.
  */
 void oe_free_ocall_buffer(void* buffer);
 
+/**
+ * Copy a [shared] ecall parameter into enclave memory.
+ *
+ * Called by the generated ecall wrappers for parameters that the host passes
+ * by address within the region registered with oe_register_shared_region().
+ *
+ * @param host_ptr The parameter as passed by the host (may be null).
+ * @param size The size in bytes of the parameter.
+ * @param copy_in Copy the parameter (in and in-out parameters) rather than
+ * zero-fill it (out parameters).
+ * @param buffer The enclave buffer, to be released with
+ * oe_put_shared_buffer(). Set to null if **host_ptr** is null.
+ *
+ * @return OE_OK the buffer was set up.
+ * @return OE_INVALID_PARAMETER the parameter does not lie within the
+ * registered region.
+ * @return OE_OUT_OF_MEMORY the buffer could not be allocated.
+ */
+oe_result_t oe_get_shared_buffer(
+    const void* host_ptr,
+    size_t size,
+    bool copy_in,
+    void** buffer);
+
+/**
+ * Release a buffer set up by oe_get_shared_buffer().
+ *
+ * @param host_ptr The parameter as passed by the host.
+ * @param buffer The buffer returned by oe_get_shared_buffer().
+ * @param size The size in bytes of the parameter.
+ * @param copy_out Copy the buffer back to **host_ptr** (out and in-out
+ * parameters).
+ */
+void oe_put_shared_buffer(
+    void* host_ptr,
+    void* buffer,
+    size_t size,
+    bool copy_out);
+
 /**
  * For hand-written enclaves, that use the older calling mechanism, define empty
  * ecall tables.
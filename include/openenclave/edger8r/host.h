@@ -66,6 +66,93 @@ oe_result_t oe_call_enclave_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Perform a switchless high-level enclave function call (ECALL).
+ *
+ * This function has the same semantics as oe_call_enclave_function() but
+ * attempts to hand the call to an enclave worker thread through a shared
+ * request ring instead of entering the enclave. If the enclave was created
+ * without switchless enclave workers, or if all workers are busy, the call
+ * falls back to a regular ECALL.
+ *
+ * Edger8r emits calls to this function for trusted functions marked with the
+ * **transition_using_threads** attribute.
+ *
+ * @param enclave The instance of the enclave.
+ * @param function_id The id of the enclave function that will be called.
+ * @param input_buffer Buffer containing inputs data.
+ * @param input_buffer_size Size of the input data buffer.
+ * @param output_buffer Buffer where the outputs of the enclave function are
+ * written to.
+ * @param output_buffer_size Size of the output buffer.
+ * @param output_bytes_written Number of bytes written in the output buffer.
+ *
+ * @return See oe_call_enclave_function().
+ */
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written);
+
+/**
+ * Descriptor of one call made by oe_call_enclave_function_batch().
+ *
+ * The caller fills in the function id and the buffers; the batch stores the
+ * outcome of the call in **result** and **output_bytes_written**.
+ */
+typedef struct _oe_enclave_function_call
+{
+    /** The id of the enclave function to call */
+    uint64_t function_id;
+
+    /** Buffer containing inputs data */
+    const void* input_buffer;
+
+    /** Size of the input data buffer */
+    size_t input_buffer_size;
+
+    /** Buffer where the outputs of the enclave function are written to */
+    void* output_buffer;
+
+    /** Size of the output buffer */
+    size_t output_buffer_size;
+
+    /** Set by the batch: number of bytes written in the output buffer */
+    size_t output_bytes_written;
+
+    /** Set by the batch: result of this call (see oe_call_enclave_function) */
+    oe_result_t result;
+} oe_enclave_function_call_t;
+
+/**
+ * Perform several high-level enclave function calls (ECALLs) at once.
+ *
+ * Enter the enclave once and call the enclave functions described by the
+ * **calls** array in order. Each call has the same semantics as
+ * oe_call_enclave_function(); its outcome is stored in the **result** and
+ * **output_bytes_written** fields of its descriptor. A failed call does not
+ * stop the batch.
+ *
+ * Edger8r emits a **_batch** wrapper that calls this function for trusted
+ * functions marked with the **batchable** attribute.
+ *
+ * @param enclave The instance of the enclave.
+ * @param calls Array of call descriptors.
+ * @param num_calls Number of elements in the **calls** array.
+ *
+ * @return OE_OK the batch was dispatched (see the result of each call).
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_FAILURE the batch could not be dispatched.
+ */
+oe_result_t oe_call_enclave_function_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls);
+
 OE_EXTERNC_END
 
 #endif // _OE_EDGER8R_HOST_H
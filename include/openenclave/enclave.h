@@ -122,6 +122,42 @@ oe_result_t oe_call_host_by_address(
     void (*func)(void*, oe_enclave_t*),
     void* args);
 
+/**
+ * Resolve the name of a host function to a handle.
+ *
+ * Look up the host function whose name is given by the **func** parameter
+ * (see oe_call_host()) and return a handle that can be passed to
+ * oe_call_host_by_handle(). The handle remains valid until the enclave is
+ * terminated. Resolving the same name again yields the same handle.
+ *
+ * Enclaves that call the same host function repeatedly should resolve it
+ * once: calls by handle neither hash the name nor allocate host memory.
+ *
+ * @param func The name of the host function.
+ * @param handle The handle of the host function.
+ *
+ * @return OE_OK the function was found.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_NOT_FOUND the host does not define the function.
+ */
+oe_result_t oe_get_host_function_handle(const char* func, uint64_t* handle);
+
+/**
+ * Perform a high-level host function call (OCALL) by handle.
+ *
+ * Call the host function whose handle is given by the **handle** parameter,
+ * as obtained from oe_get_host_function_handle(). The call has the same
+ * semantics as oe_call_host().
+ *
+ * @param handle The handle of the host function that will be called.
+ * @param args The arguments to be passed to the host function.
+ *
+ * @return OE_OK the call was successful.
+ * @return OE_NOT_FOUND the handle is not valid.
+ * @return OE_FAILURE the call failed.
+ */
+oe_result_t oe_call_host_by_handle(uint64_t handle, void* args);
+
 /**
  * Check whether the given buffer is strictly within the enclave.
  *
@@ -240,6 +276,89 @@ void oe_host_free(void* ptr);
  */
 char* oe_host_strndup(const char* str, size_t n);
 
+/**
+ * Whether the enclave heap is split into per-thread arenas.
+ *
+ * With arenas, threads do not serialize on a single allocator lock: each
+ * thread allocates from the arena it is bound to on its first allocation,
+ * and memory may be freed or reallocated by any thread. The default (false)
+ * uses a single heap. Arenas are not used when oecore is built with
+ * USE_DEBUG_MALLOC.
+ *
+ * The variable is true when the enclave is linked with
+ * OE_USE_THREAD_ARENAS().
+ */
+extern const bool oe_use_thread_arenas;
+
+/**
+ * Split the enclave heap into per-thread arenas.
+ *
+ * The allocator is selected when the enclave is linked: this macro links
+ * the arena allocator of oecore in place of the default single heap, which
+ * has a smaller per-chunk overhead. To use arenas, use this macro at file
+ * scope in one source file of the enclave:
+ *
+ *     OE_USE_THREAD_ARENAS();
+ */
+#define OE_USE_THREAD_ARENAS()                               \
+    OE_EXTERNC_BEGIN                                         \
+    extern const bool oe_link_thread_arenas;                 \
+    OE_EXTERNC_END                                           \
+    OE_EXTERNC const bool* const oe_link_thread_arenas_ref = \
+        &oe_link_thread_arenas
+
+/**
+ * A pool of fixed-size objects in enclave memory.
+ *
+ * Pools serve objects of a single size and alignment from slabs of enclave
+ * heap pages. Each thread keeps a small cache (magazine) of free objects per
+ * pool, so most allocations and releases take no lock.
+ */
+typedef struct _oe_pool oe_pool_t;
+
+/**
+ * Create a pool of fixed-size objects.
+ *
+ * @param object_size The size in bytes of the objects (at most 64 KB).
+ * @param alignment The alignment of the objects: a power of two that does
+ * not exceed the page size, or zero for the alignment of oe_malloc().
+ *
+ * @returns The new pool or NULL if the parameters are invalid or the pool
+ * could not be allocated.
+ */
+oe_pool_t* oe_pool_create(size_t object_size, size_t alignment);
+
+/**
+ * Allocate an object from a pool.
+ *
+ * The contents of the object are undefined.
+ *
+ * @param pool The pool created by oe_pool_create().
+ *
+ * @returns The object or NULL if out of memory.
+ */
+void* oe_pool_alloc(oe_pool_t* pool);
+
+/**
+ * Return an object to its pool.
+ *
+ * Any thread may release an object, not only the one that allocated it.
+ *
+ * @param pool The pool from which the object was allocated.
+ * @param object The object to be released or null.
+ */
+void oe_pool_free(oe_pool_t* pool, void* object);
+
+/**
+ * Destroy a pool and release its memory to the enclave heap.
+ *
+ * All the objects allocated from the pool are released, so none of them may
+ * be used after this call. No other thread may use the pool concurrently.
+ *
+ * @param pool The pool to be destroyed or null.
+ */
+void oe_pool_destroy(oe_pool_t* pool);
+
 /**
  * Abort execution of the enclave.
  *
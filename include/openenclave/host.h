@@ -63,6 +63,52 @@ typedef void (*oe_ocall_func_t)(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Enclave creation settings that may be passed to oe_create_enclave() through
+ * its **config** parameter (with **config_size** set to
+ * sizeof(oe_enclave_config_t)).
+ */
+typedef struct _oe_enclave_config
+{
+    /**
+     * Number of host worker threads that service switchless OCALLs, i.e.
+     * untrusted functions marked with the **transition_using_threads** EDL
+     * attribute. Each worker polls for requests and therefore keeps a CPU
+     * busy while the enclave is making calls. Zero (the default) disables
+     * switchless OCALLs, which then use regular enclave transitions. At most
+     * 32 workers are supported.
+     */
+    uint32_t num_host_workers;
+
+    /**
+     * Number of enclave worker threads that service switchless ECALLs, i.e.
+     * trusted functions marked with the **transition_using_threads** EDL
+     * attribute. Each worker permanently occupies one TCS of the enclave, so
+     * this must be smaller than the enclave's TCS count. Idle workers back
+     * off and eventually park until the next switchless ECALL. Zero (the
+     * default) disables switchless ECALLs. At most 32 workers are supported.
+     */
+    uint32_t num_enclave_workers;
+} oe_enclave_config_t;
+
+/**
+ * Counters describing how switchless calls were serviced.
+ */
+typedef struct _oe_switchless_stats
+{
+    /** Switchless OCALLs that were dispatched by a host worker thread. */
+    uint64_t ocall_hits;
+
+    /** Switchless OCALLs that found no free worker and exited the enclave. */
+    uint64_t ocall_fallbacks;
+
+    /** Switchless ECALLs that were dispatched by an enclave worker thread. */
+    uint64_t ecall_hits;
+
+    /** Switchless ECALLs that found no free worker and entered the enclave. */
+    uint64_t ecall_fallbacks;
+} oe_switchless_stats_t;
+
 /**
  * Create an enclave from an enclave image file.
  *
@@ -82,8 +128,8 @@ typedef void (*oe_ocall_func_t)(
  *     - OE_ENCLAVE_FLAG_DEBUG - runs the enclave in debug mode.
  *                               DO NOT SHIP CODE with this flag
  *
- * @param config Additional enclave creation configuration data for the specific
- * enclave type. This parameter is reserved and must be NULL.
+ * @param config Additional enclave creation configuration data. This is
+ * either NULL or a pointer to an **oe_enclave_config_t** structure.
  *
  * @param config_size The size of the **config** data buffer in bytes.
  *
@@ -121,6 +167,23 @@ oe_result_t oe_create_enclave(
  */
 oe_result_t oe_terminate_enclave(oe_enclave_t* enclave);
 
+/**
+ * Get the switchless call counters of an enclave.
+ *
+ * This function reports how many switchless calls were serviced by worker
+ * threads and how many fell back to regular enclave transitions since the
+ * enclave was created.
+ *
+ * @param enclave The instance of the enclave.
+ * @param stats The structure that receives the counters.
+ *
+ * @returns Returns OE_OK on success.
+ *
+ */
+oe_result_t oe_get_switchless_stats(
+    oe_enclave_t* enclave,
+    oe_switchless_stats_t* stats);
+
 /**
  * Perform a high-level enclave function call (ECALL).
  *
@@ -154,6 +217,124 @@ oe_result_t oe_call_enclave(
     const char* func,
     void* args);
 
+/**
+ * Resolve the name of an enclave function to a handle.
+ *
+ * Look up the enclave function whose name is given by the **func**
+ * parameter (see oe_call_enclave()) and return a handle that can be passed to
+ * oe_call_enclave_by_handle(). The handle remains valid until the enclave is
+ * terminated.
+ *
+ * Callers that call the same enclave function repeatedly should resolve it
+ * once and call it by handle to skip the name lookup.
+ *
+ * @param enclave The instance of the enclave.
+ * @param func The name of the enclave function.
+ * @param handle The handle of the enclave function.
+ *
+ * @return OE_OK the function was found.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_NOT_FOUND the enclave does not define the function.
+ */
+oe_result_t oe_get_enclave_function_handle(
+    oe_enclave_t* enclave,
+    const char* func,
+    uint64_t* handle);
+
+/**
+ * Perform a high-level enclave function call (ECALL) by handle.
+ *
+ * Call the enclave function whose handle is given by the **handle**
+ * parameter, as obtained from oe_get_enclave_function_handle(). The call has
+ * the same semantics as oe_call_enclave().
+ *
+ * @param enclave The instance of the enclave to be called.
+ * @param handle The handle of the enclave function that will be called.
+ * @param args The arguments to be passed to the enclave function.
+ *
+ * @return OE_OK the call was successful.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_NOT_FOUND the handle is not valid.
+ */
+oe_result_t oe_call_enclave_by_handle(
+    oe_enclave_t* enclave,
+    uint64_t handle,
+    void* args);
+
+/**
+ * Register a host memory region for [shared] ecall parameters.
+ *
+ * The enclave checks once that the region lies outside the enclave and then
+ * accepts [shared] parameters (see the oeedger8r documentation) that lie
+ * within it. Such parameters are not copied by the host; the enclave copies
+ * them into (and out of) enclave memory directly.
+ *
+ * At most one region can be registered per enclave and it cannot be
+ * unregistered: the caller must keep it mapped until the enclave is
+ * terminated.
+ *
+ * @param enclave The instance of the enclave.
+ * @param data The start of the region.
+ * @param size The size in bytes of the region.
+ *
+ * @return OE_OK the region was registered.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_UNSUPPORTED a region is already registered.
+ */
+oe_result_t oe_register_shared_region(
+    oe_enclave_t* enclave,
+    void* data,
+    size_t size);
+
+/**
+ * Start or stop sampling the heap allocations of an enclave.
+ *
+ * While sampling is on, each enclave thread records the stack of one
+ * allocation every **sample_rate** bytes it allocates, and whether the
+ * allocation has been freed since. The samples are written by
+ * oe_write_heap_profile(). Stopping (or changing the rate) keeps the samples
+ * recorded so far.
+ *
+ * Stacks are complete only if the enclave is built with frame pointers and
+ * oecore with USE_DEBUG_MALLOC; otherwise only the caller of the allocation
+ * function is recorded.
+ *
+ * @param enclave The instance of the enclave.
+ * @param sample_rate The sampling interval in bytes, or zero to stop.
+ *
+ * @return OE_OK the sampling interval was set.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_OUT_OF_MEMORY the enclave could not allocate the profile.
+ * @return OE_UNSUPPORTED the enclave is not a debug enclave.
+ */
+oe_result_t oe_set_heap_profile_rate(oe_enclave_t* enclave, size_t sample_rate);
+
+/**
+ * Write the heap profile of an enclave to a file.
+ *
+ * Heap profiles are only available for debug enclaves (and in simulation
+ * mode).
+ *
+ * The file is in the text format of the gperftools heap profiler, which
+ * pprof reads along with the enclave image to symbolize the stacks:
+ *
+ *     pprof --text enclave.signed heap.prof
+ *
+ * Comments at the top of the file give the heap statistics of the enclave
+ * (see oe_get_heap_stats()): the size of its heap, the peak and current
+ * memory taken from it, and the bytes in use, free and fragmented. These
+ * are written even if sampling was never started.
+ *
+ * @param enclave The instance of the enclave.
+ * @param path The path of the file to be written.
+ *
+ * @return OE_OK the profile was written.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_FAILURE the file could not be written.
+ * @return OE_UNSUPPORTED the enclave is not a debug enclave.
+ */
+oe_result_t oe_write_heap_profile(oe_enclave_t* enclave, const char* path);
+
 #if (OE_API_VERSION < 2)
 #define oe_get_report oe_get_report_v1
 #else
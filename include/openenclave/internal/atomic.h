@@ -35,4 +35,22 @@ OE_INLINE uint64_t oe_atomic_decrement(volatile uint64_t* x)
 #endif
 }
 
+/* Atomically set **x** to **new_value** if it equals **old_value**. Returns
+ * true if the exchange took place */
+OE_INLINE bool oe_atomic_compare_and_swap(
+    volatile uint64_t* x,
+    uint64_t old_value,
+    uint64_t new_value)
+{
+#if defined(__GNUC__)
+    return __sync_bool_compare_and_swap(x, old_value, new_value);
+#elif defined(_MSC_VER)
+    return InterlockedCompareExchange64(
+               (volatile LONG64*)x, (LONG64)new_value, (LONG64)old_value) ==
+           (LONG64)old_value;
+#else
+#error "unsupported"
+#endif
+}
+
 #endif /* _OE_ATOMIC_H */
@@ -9,6 +9,7 @@
 #include <openenclave/internal/cpuid.h>
 #include <openenclave/internal/defs.h>
 #include "backtrace.h"
+#include "malloc.h"
 #include "sgxtypes.h"
 
 OE_EXTERNC_BEGIN
@@ -79,6 +80,11 @@ typedef enum _oe_func
     OE_ECALL_GET_SGX_REPORT,
     OE_ECALL_VIRTUAL_EXCEPTION_HANDLER,
     OE_ECALL_LOG_INIT,
+    OE_ECALL_SWITCHLESS_WORKER,
+    OE_ECALL_CALL_ENCLAVE_FUNCTION_BATCH,
+    OE_ECALL_REGISTER_SHARED_REGION,
+    OE_ECALL_SET_HEAP_PROFILE_RATE,
+    OE_ECALL_GET_HEAP_PROFILE,
     /* Caution: always add new ECALL function numbers here */
 
     OE_OCALL_CALL_HOST = OE_OCALL_BASE,
@@ -99,6 +105,9 @@ typedef enum _oe_func
     OE_OCALL_GET_TIME,
     OE_OCALL_BACKTRACE_SYMBOLS,
     OE_OCALL_LOG,
+    OE_OCALL_GET_HOST_FUNCTION_HANDLE,
+    OE_OCALL_CALL_HOST_BY_HANDLE,
+    OE_OCALL_GET_CLOCK,
     /* Caution: always add new OCALL function numbers here */
 
     __OE_FUNC_MAX = OE_ENUM_MAX,
@@ -225,6 +234,87 @@ typedef struct _oe_call_enclave_function_args
     oe_result_t result;
 } oe_call_enclave_function_args_t;
 
+/*
+**==============================================================================
+**
+** oe_call_enclave_function_batch_args_t
+**
+**     Argument of OE_ECALL_CALL_ENCLAVE_FUNCTION_BATCH. The enclave
+**     dispatches each of the calls[] in order and stores its result and
+**     output_bytes_written in the array.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_call_enclave_function_batch_args
+{
+    oe_call_enclave_function_args_t* calls;
+    uint64_t num_calls;
+    oe_result_t result;
+} oe_call_enclave_function_batch_args_t;
+
+/*
+**==============================================================================
+**
+** oe_register_shared_region_args_t
+**
+**     Argument of OE_ECALL_REGISTER_SHARED_REGION. The enclave validates the
+**     host memory region once and then accepts [shared] ecall parameters
+**     that lie within it.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_register_shared_region_args
+{
+    void* data;
+    uint64_t size;
+    oe_result_t result;
+} oe_register_shared_region_args_t;
+
+/*
+**==============================================================================
+**
+** oe_heap_profile_entry_t
+** oe_get_heap_profile_args_t
+**
+**     Argument of OE_ECALL_GET_HEAP_PROFILE. The enclave copies its heap
+**     statistics and one entry per sampled allocation stack into the
+**     entries[] array (in host memory). num_entries is set to the number of
+**     stacks even if max_entries is smaller (OE_BUFFER_TOO_SMALL), and
+**     sample_rate to the sampling interval of the entries.
+**
+**     OE_ECALL_SET_HEAP_PROFILE_RATE takes the sampling interval in bytes
+**     (zero stops sampling) as its argument.
+**
+**==============================================================================
+*/
+
+#define OE_HEAP_PROFILE_MAX_FRAMES 32
+
+typedef struct _oe_heap_profile_entry
+{
+    /* Sampled allocations (all of them and those not freed yet) */
+    uint64_t alloc_count;
+    uint64_t alloc_bytes;
+    uint64_t in_use_count;
+    uint64_t in_use_bytes;
+
+    /* Return addresses, innermost first */
+    uint64_t num_frames;
+    uint64_t frames[OE_HEAP_PROFILE_MAX_FRAMES];
+} oe_heap_profile_entry_t;
+
+typedef struct _oe_get_heap_profile_args
+{
+    oe_heap_profile_entry_t* entries;
+    uint64_t max_entries;
+    uint64_t num_entries;
+    uint64_t sample_rate;
+    oe_heap_stats_t stats;
+    oe_result_t result;
+} oe_get_heap_profile_args_t;
+
 /*
 **==============================================================================
 **
@@ -307,6 +397,36 @@ typedef struct _oe_call_host_by_address_args
     oe_result_t result;
 } oe_call_host_by_address_args_t;
 
+/*
+**==============================================================================
+**
+** oe_get_host_function_handle_args_t
+**
+**==============================================================================
+*/
+
+typedef struct _oe_get_host_function_handle_args
+{
+    uint64_t handle;
+    oe_result_t result;
+    OE_ZERO_SIZED_ARRAY char func[];
+} oe_get_host_function_handle_args_t;
+
+/*
+**==============================================================================
+**
+** oe_call_host_by_handle_args_t
+**
+**==============================================================================
+*/
+
+typedef struct _oe_call_host_by_handle_args
+{
+    void* args;
+    uint64_t handle;
+    oe_result_t result;
+} oe_call_host_by_handle_args_t;
+
 /*
 **==============================================================================
 **
@@ -347,6 +467,7 @@ typedef struct _oe_realloc_args
 **     Runtime state to initialize enclave state with, includes
 **     - First 8 leaves of CPUID for enclave emulation
 **     - Enclave handle obtained by oe_create_enclave()
+**     - Ring serviced by switchless host worker threads (may be null)
 **
 **==============================================================================
 */
@@ -355,6 +476,7 @@ typedef struct _oe_init_enclave_args
 {
     uint32_t cpuid_table[OE_CPUID_LEAF_COUNT][OE_CPUID_REG_COUNT];
     oe_enclave_t* enclave;
+    struct _oe_switchless_ring* host_worker_ring;
 } oe_init_enclave_args_t;
 
 /*
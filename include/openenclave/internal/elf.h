@@ -222,9 +222,9 @@ typedef struct
 } elf64_rela_t;
 
 #define ELF_MAGIC 0x7d7ad33b
-#define ELF64_INIT         \
-    {                      \
-        ELF_MAGIC, NULL, 0 \
+#define ELF64_INIT            \
+    {                         \
+        ELF_MAGIC, NULL, 0, 0 \
     }
 
 typedef struct
@@ -237,6 +237,10 @@ typedef struct
 
     /* File image size */
     size_t size;
+
+    /* Size of the private mapping of the file at data, or zero if the file
+     * image is on the heap (see elf64_load()) */
+    size_t map_size;
 } elf64_t;
 
 int elf64_test_header(const elf64_ehdr_t* header);
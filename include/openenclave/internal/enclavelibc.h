@@ -155,6 +155,15 @@ int oe_snprintf(char* str, size_t size, const char* fmt, ...);
  */
 void* oe_sbrk(ptrdiff_t increment);
 
+/**
+ * Return the highest end of the heap ever reached with oe_sbrk().
+ *
+ * The heap may have shrunk since (oe_sbrk() with a negative increment).
+ *
+ * @returns the high-water mark of the heap
+ */
+void* oe_sbrk_high_water_mark(void);
+
 /**
  * Enclave implementation of the standard malloc() function.
  *
@@ -24,6 +24,23 @@ const void* __oe_get_ecall_base(void);
 const void* __oe_get_ecall_end(void);
 size_t __oe_get_ecall_size(void);
 
+//
+// Each enclave thread keeps the scratch buffer used to marshal ECALL
+// arguments (input and output) between ECALLs unless it is larger than this
+// many bytes. To change it in an enclave:
+//
+//     #include <openenclave/internal/globals.h>
+//     .
+//     .
+//     .
+//     oe_ecall_buffer_high_water_mark = 256 * 1024;
+//
+// Zero disables caching altogether.
+//
+#define OE_ECALL_BUFFER_HIGH_WATER_MARK (64 * 1024)
+
+extern size_t oe_ecall_buffer_high_water_mark;
+
 /* Heap */
 const void* __oe_get_heap_base(void);
 const void* __oe_get_heap_end(void);
@@ -129,6 +129,9 @@ struct _oe_enclave_image
         const oe_sgx_enclave_properties_t* properties);
 
     oe_result_t (*unload)(oe_enclave_image_t* image);
+
+    /* Optional: release the data of the file once the image is loaded */
+    oe_result_t (*release_file)(oe_enclave_image_t* image);
 };
 
 oe_result_t oe_load_enclave_image(const char* path, oe_enclave_image_t* image);
@@ -143,6 +146,19 @@ oe_result_t oe_load_pe_enclave_image(
 
 oe_result_t oe_unload_enclave_image(oe_enclave_image_t* oeimage);
 
+/**
+ * Release the file data that an enclave image keeps once it is loaded.
+ *
+ * The image can still be patched and added to enclaves, but its symbols can
+ * no longer be looked up and its properties can no longer be updated.
+ *
+ * @param oeimage OE Enclave image
+ *
+ * @returns OE_OK
+ * @returns OE_INVALID_PARAMETER null parameter
+ */
+oe_result_t oe_release_enclave_image_file(oe_enclave_image_t* oeimage);
+
 /**
  * Find the oe_sgx_enclave_properties_t struct within the given section
  *
@@ -44,6 +44,48 @@ typedef struct _oe_malloc_stats
  */
 oe_result_t oe_get_malloc_stats(oe_malloc_stats_t* stats);
 
+typedef struct _oe_heap_stats
+{
+    /* Size of the enclave heap (HeapPageCount pages) */
+    uint64_t heap_size;
+
+    /* Heap memory obtained with oe_sbrk() and its high-water mark */
+    uint64_t sbrk_bytes;
+    uint64_t peak_sbrk_bytes;
+
+    /* Heap memory held by the allocator and its high-water mark */
+    uint64_t system_bytes;
+    uint64_t peak_system_bytes;
+
+    /* Bytes in allocated blocks (including allocator overhead) */
+    uint64_t in_use_bytes;
+
+    /* Bytes in free blocks held by the allocator */
+    uint64_t free_bytes;
+
+    /* Part of free_bytes that lies between allocated blocks (fragmentation)
+     * rather than at the top of the heap */
+    uint64_t fragmented_bytes;
+} oe_heap_stats_t;
+
+/**
+ * Obtains enclave heap statistics.
+ *
+ * Unlike oe_get_malloc_stats(), these statistics relate the allocator state
+ * to the heap of the enclave, so that an enclave can tell how much of its
+ * heap pages it actually uses:
+ *
+ *     - the size of the heap and how much of it oe_sbrk() handed out
+ *     - the current and peak memory held by the allocator
+ *     - the bytes in use and free, and how fragmented the free bytes are
+ *
+ * @param stats[output] the heap statistics
+ *
+ * @return OE_OK success
+ * @return OE_INVALID_PARAMETER **stats** is null
+ */
+oe_result_t oe_get_heap_stats(oe_heap_stats_t* stats);
+
 /* Dump the list of all in-use allocations */
 void oe_debug_malloc_dump(void);
 
@@ -9,8 +9,23 @@
 
 OE_EXTERNC_BEGIN
 
+/* Same layout as struct iovec */
+typedef struct _oe_host_iovec
+{
+    const void* base;
+    size_t len;
+} oe_host_iovec_t;
+
 int oe_host_write(int device, const char* str, size_t size);
 
+/* Write the buffers of the vector with a single OCALL */
+int oe_host_writev(int device, const oe_host_iovec_t* iov, size_t iovcnt);
+
+/* Write the output of oe_host_printf() and oe_host_fprintf() that the calling
+ * thread has buffered for the device (0 for stdout, 1 for stderr, which is
+ * never buffered) */
+int oe_host_flush(int device);
+
 int oe_host_vfprintf(int device, const char* fmt, oe_va_list ap_);
 
 /**
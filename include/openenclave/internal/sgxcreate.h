@@ -59,6 +59,13 @@ struct _oe_sgx_load_context
 
     /* Hash context used to measure enclave as it is loaded */
     oe_sha256_context_t hash_context;
+
+    /* Set when the MRENCLAVE is known before the enclave is loaded (from the
+     * sigstruct of a signed enclave), in which case the enclave is not
+     * measured on the host and this value is returned by
+     * oe_sgx_initialize_enclave() */
+    bool skip_measurement;
+    OE_SHA256 mrenclave;
 };
 
 oe_result_t oe_sgx_initialize_load_context(
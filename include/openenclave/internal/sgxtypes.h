@@ -592,7 +592,11 @@ typedef struct _td
 
     /* Linux error number: from <errno.h> */
     int linux_errno;
-    int padding1;
+
+    /* Small unique index of this thread plus one, or zero if not assigned yet
+     * (see td_get_index()). Other per-thread state of oecore is kept in a
+     * table indexed by it rather than here (see td_get_state()). */
+    uint32_t index;
 
     // The pthread implementation structure is overlaid here. This is only
     // used by oelibc to implement the pthread functions (see libc/pthread.c
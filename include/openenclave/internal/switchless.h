@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_SWITCHLESS_H
+#define _OE_SWITCHLESS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/defs.h>
+
+OE_EXTERNC_BEGIN
+
+/* Maximum number of worker threads servicing a switchless ring */
+#define OE_SWITCHLESS_MAX_WORKERS 32
+
+/* Slot states */
+#define OE_SWITCHLESS_SLOT_IDLE 0     /* Worker is polling; slot is claimable */
+#define OE_SWITCHLESS_SLOT_CLAIMED 1  /* Caller is filling in the request */
+#define OE_SWITCHLESS_SLOT_POSTED 2   /* Request is ready for the worker */
+#define OE_SWITCHLESS_SLOT_DONE 3     /* Worker finished; caller owns slot */
+#define OE_SWITCHLESS_SLOT_SLEEPING 4 /* Worker is parked */
+#define OE_SWITCHLESS_SLOT_OFFLINE 5  /* No worker attached; not claimable */
+
+/*
+**==============================================================================
+**
+** oe_switchless_slot_t
+**
+**     One request slot of a switchless ring. Each worker thread owns exactly
+**     one slot and polls its state. A caller claims an idle slot with a
+**     compare-and-swap (IDLE -> CLAIMED), copies the call arguments into the
+**     slot and posts it (CLAIMED -> POSTED). The worker dispatches the call
+**     and sets DONE. The caller collects the results and releases the slot
+**     (DONE -> IDLE).
+**
+**     The same slot layout serves both directions: host workers dispatch
+**     host functions (args.host_function) for the enclave and enclave
+**     workers dispatch enclave functions (args.enclave_function) for the
+**     host.
+**
+**     Each slot occupies a single cache line so that polling workers do not
+**     contend with each other.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_switchless_slot
+{
+    volatile uint64_t state;
+    union {
+        oe_call_host_function_args_t host_function;
+        oe_call_enclave_function_args_t enclave_function;
+    } args;
+} oe_switchless_slot_t;
+
+OE_CHECK_SIZE(sizeof(oe_switchless_slot_t), 64);
+
+/*
+**==============================================================================
+**
+** oe_switchless_ring_t
+**
+**     The ring of request slots shared between the enclave and the host. It
+**     is allocated by the host. The ring serviced by host workers is passed
+**     to the enclave during initialization (see oe_init_enclave_args_t). The
+**     ring serviced by enclave workers is passed to each worker through
+**     oe_switchless_worker_args_t.
+**
+**     waiters[i] holds the TCS of an enclave thread blocked in
+**     oe_ocall_wait_any() on the asynchronous call posted to slots[i], or
+**     zero. The host worker that completes the call takes the TCS (with a
+**     compare-and-swap to zero) and wakes the thread.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_switchless_ring
+{
+    /* Number of slots in use (one per worker) */
+    uint64_t num_slots;
+
+    /* Number of calls that found no free worker and made a regular call */
+    volatile uint64_t fallbacks;
+
+    /* Set by the enclave when it fell back while some workers were asleep */
+    volatile uint64_t wake_requested;
+
+    /* Set by the host to make the workers return */
+    volatile uint64_t stop;
+
+    uint64_t padding[4];
+
+    oe_switchless_slot_t slots[OE_SWITCHLESS_MAX_WORKERS];
+
+    volatile uint64_t waiters[OE_SWITCHLESS_MAX_WORKERS];
+} oe_switchless_ring_t;
+
+OE_CHECK_SIZE(OE_OFFSETOF(oe_switchless_ring_t, slots), 64);
+
+/*
+**==============================================================================
+**
+** oe_switchless_worker_args_t
+**
+**     Argument of the OE_ECALL_SWITCHLESS_WORKER ecall, which runs an
+**     enclave worker until the host stops the ring.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_switchless_worker_args
+{
+    /* Ring serviced by enclave workers */
+    oe_switchless_ring_t* ring;
+
+    /* Index of the slot this worker polls */
+    uint64_t slot;
+
+    /* Set by the enclave: TCS of the worker, signaled to wake it */
+    uint64_t tcs;
+} oe_switchless_worker_args_t;
+
+OE_EXTERNC_END
+
+#endif /* _OE_SWITCHLESS_H */
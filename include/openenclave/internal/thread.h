@@ -161,7 +161,8 @@ oe_result_t oe_spin_init(oe_spinlock_t* spinlock);
  * A thread calls this function to acquire a lock on a spin lock. If
  * another thread has already acquired a lock, the calling thread spins
  * until the lock is available. If more than one thread is waiting on the
- * spin lock, the selection of the next thread to obtain the lock is arbitrary.
+ * spin lock, the threads obtain the lock in the order in which they called
+ * this function.
  *
  * @param spinlock Lock this spin lock.
  *
@@ -171,6 +172,21 @@ oe_result_t oe_spin_init(oe_spinlock_t* spinlock);
  */
 oe_result_t oe_spin_lock(oe_spinlock_t* spinlock);
 
+/**
+ * Try to acquire a lock on a spin lock.
+ *
+ * This function acquires a lock on a spin lock if it is available, and
+ * returns immediately otherwise.
+ *
+ * @param spinlock Lock this spin lock.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_BUSY the lock was busy
+ *
+ */
+oe_result_t oe_spin_trylock(oe_spinlock_t* spinlock);
+
 /**
  * Release the lock on a spin lock.
  *
@@ -225,8 +241,9 @@ oe_result_t oe_mutex_init(oe_mutex_t* mutex);
  *
  * This function acquires a lock on a mutex.
  *
- * For enclaves, oe_mutex_lock() performs an OCALL to wait for the mutex to
- * be signaled.
+ * For enclaves, oe_mutex_lock() first spins for a while (see
+ * oe_mutex_spin_count) waiting for the owner to release the mutex, and then
+ * performs an OCALL to wait for the mutex to be signaled.
  *
  * @param mutex Acquire a lock on this mutex.
  *
@@ -259,7 +276,7 @@ oe_result_t oe_mutex_trylock(oe_mutex_t* mutex);
  * oe_mutex_lock() or oe_mutex_trylock().
  *
  * In enclaves, this function performs an OCALL, where it wakes the next
- * thread waiting on a mutex.
+ * thread waiting on a mutex, if any thread is waiting.
  *
  * @param mutex Release the lock on this mutex.
  *
@@ -284,6 +301,30 @@ oe_result_t oe_mutex_unlock(oe_mutex_t* mutex);
  */
 oe_result_t oe_mutex_destroy(oe_mutex_t* mutex);
 
+/**
+ * @cond DEV
+ */
+//
+// A thread that finds a mutex locked by another thread polls it up to this
+// many times before asking the host to put it to sleep, since two enclave
+// transitions cost more than most critical sections last. To change it in
+// an enclave:
+//
+//     #include <openenclave/internal/thread.h>
+//     .
+//     .
+//     .
+//     oe_mutex_spin_count = 4000;
+//
+// Zero makes contended threads sleep at once.
+//
+#define OE_MUTEX_SPIN_COUNT 1000
+
+extern uint32_t oe_mutex_spin_count;
+/**
+ * @endcond
+ */
+
 /**
  * Condition variable representation
  */
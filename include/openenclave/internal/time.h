@@ -35,6 +35,60 @@ int oe_sleep(uint64_t milliseconds);
 
 uint64_t oe_get_time(void);
 
+/*
+**==============================================================================
+**
+** oe_clock_t
+**
+**     OE_CLOCK_REALTIME counts from the Epoch and OE_CLOCK_MONOTONIC from an
+**     unspecified point in the past, like the POSIX clocks of the same names.
+**
+**==============================================================================
+*/
+
+typedef enum _oe_clock
+{
+    OE_CLOCK_REALTIME,
+    OE_CLOCK_MONOTONIC,
+    __OE_CLOCK_MAX = OE_ENUM_MAX,
+} oe_clock_t;
+
+/*
+**==============================================================================
+**
+** oe_get_clock_time()
+**
+**     Return the nanoseconds shown by the given clock or (uint64_t)-1 on
+**     error. OE_CLOCK_MONOTONIC never decreases. OE_CLOCK_REALTIME follows
+**     the host clock, so it goes back when the host clock is set back.
+**
+**     By default every call reads the host clock with an OCALL. Enclaves
+**     that use OE_USE_TSC_CLOCK() read the host clock at most once per
+**     interval and interpolate with RDTSC in between (SGX only).
+**
+**==============================================================================
+*/
+
+uint64_t oe_get_clock_time(oe_clock_t clock);
+
+//
+// Maximum age in milliseconds of the host time that oe_get_clock_time()
+// interpolates from, or zero to read the host clock on every call (the
+// default). Interpolation is only used if RDTSC is available in the enclave,
+// which rules out SGX1 hardware.
+//
+// The clock is selected when the enclave is linked. To interpolate, define
+// the variable at file scope in one source file of the enclave:
+//
+//     #include <openenclave/internal/time.h>
+//
+//     OE_USE_TSC_CLOCK(10);
+//
+extern const uint64_t oe_tsc_clock_max_staleness;
+
+#define OE_USE_TSC_CLOCK(MAX_STALENESS_MSEC) \
+    OE_EXTERNC const uint64_t oe_tsc_clock_max_staleness = (MAX_STALENESS_MSEC)
+
 OE_EXTERNC_END
 
 #endif /* _OE_INCLUDE_TIME_H */
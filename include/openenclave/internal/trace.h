@@ -23,11 +23,60 @@ typedef enum _log_level_
 #define OE_LOG_MESSAGE_LEN_MAX 2048U
 #define MAX_FILENAME_LEN 256U
 
+/* Size of the log ring in bytes (a power of two) */
+#define OE_LOG_RING_SIZE (256 * 1024)
+
+/*
+**==============================================================================
+**
+** oe_log_ring_t
+**
+**     A ring in host memory that enclave threads append log records to
+**     without leaving the enclave; a host thread drains it (see logring.c).
+**     Each record is an oe_log_record_t followed by the NUL-terminated
+**     message, padded to a multiple of sizeof(oe_log_record_t). Records do
+**     not wrap: a writer that reaches the end of the ring pads it with a
+**     record of level OE_LOG_LEVEL_MAX and continues at the start.
+**
+**     Writers reserve space by advancing head and complete a record by
+**     setting its size last. The host zeroes the records it consumes before
+**     advancing tail, so a record whose size is zero is not complete yet.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_log_record
+{
+    /* Size of the record, or zero until the record is complete */
+    volatile uint32_t size;
+    uint32_t level;
+
+    /* oe_thread_self() of the enclave thread */
+    uint64_t thread;
+} oe_log_record_t;
+
+typedef struct _oe_log_ring
+{
+    /* Bytes reserved by enclave threads */
+    volatile uint64_t head;
+
+    /* Bytes consumed by the host */
+    volatile uint64_t tail;
+
+    /* Records dropped because the ring was full */
+    volatile uint64_t dropped;
+
+    uint8_t data[OE_LOG_RING_SIZE];
+} oe_log_ring_t;
+
 typedef struct _oe_log_filter
 {
     const char* path;
     uint64_t path_len;
     log_level_t level;
+
+    /* The ring to log to, or null to log with an OCALL per message */
+    oe_log_ring_t* ring;
 } oe_log_filter_t;
 
 typedef struct _oe_log_args
@@ -42,6 +91,7 @@ OE_EXTERNC_BEGIN
 oe_result_t _handle_oelog_init(uint64_t arg);
 oe_result_t oe_log(log_level_t level, const char* fmt, ...);
 log_level_t get_current_logging_level(void);
+bool is_enclave_debug_allowed(void);
 OE_EXTERNC_END
 #else
 #include <stdio.h>
@@ -50,6 +100,13 @@ oe_result_t oe_log_enclave_init(oe_enclave_t* enclave);
 void oe_log(log_level_t level, const char* fmt, ...);
 log_level_t get_current_logging_level(void);
 void log_message(bool is_enclave, oe_log_args_t* args);
+FILE* log_begin_batch(void);
+void log_batch_message(
+    FILE* stream,
+    uint64_t thread,
+    log_level_t level,
+    const char* message);
+void log_end_batch(FILE* stream);
 OE_EXTERNC_END
 #endif
 
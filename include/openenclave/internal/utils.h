@@ -96,6 +96,20 @@ OE_INLINE uint64_t StrCode(const char* s, uint64_t n)
     return (uint64_t)s[0] | ((uint64_t)s[n - 1] << 8) | ((uint64_t)n << 16);
 }
 
+/* FNV-1a hash of the first n characters of s (for hash table lookups) */
+OE_INLINE uint64_t oe_hash_str(const char* s, uint64_t n)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+
+    for (uint64_t i = 0; i < n; i++)
+    {
+        hash ^= (uint8_t)s[i];
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
 /**
  * Acquire and Release memory barriers for open enclave.
  *
@@ -173,6 +173,11 @@ int pthread_spin_lock(pthread_spinlock_t* spinlock)
     return _to_errno(oe_spin_lock((oe_spinlock_t*)spinlock));
 }
 
+int pthread_spin_trylock(pthread_spinlock_t* spinlock)
+{
+    return _to_errno(oe_spin_trylock((oe_spinlock_t*)spinlock));
+}
+
 int pthread_spin_unlock(pthread_spinlock_t* spinlock)
 {
     return _to_errno(oe_spin_unlock((oe_spinlock_t*)spinlock));
@@ -257,11 +262,21 @@ int pthread_rwlock_rdlock(pthread_rwlock_t* rwlock)
     return _to_errno(oe_rwlock_rdlock((oe_rwlock_t*)rwlock));
 }
 
+int pthread_rwlock_tryrdlock(pthread_rwlock_t* rwlock)
+{
+    return _to_errno(oe_rwlock_tryrdlock((oe_rwlock_t*)rwlock));
+}
+
 int pthread_rwlock_wrlock(pthread_rwlock_t* rwlock)
 {
     return _to_errno(oe_rwlock_wrlock((oe_rwlock_t*)rwlock));
 }
 
+int pthread_rwlock_trywrlock(pthread_rwlock_t* rwlock)
+{
+    return _to_errno(oe_rwlock_trywrlock((oe_rwlock_t*)rwlock));
+}
+
 int pthread_rwlock_unlock(pthread_rwlock_t* rwlock)
 {
     return _to_errno(oe_rwlock_unlock((oe_rwlock_t*)rwlock));
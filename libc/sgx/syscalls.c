@@ -11,8 +11,8 @@
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/print.h>
 #include <openenclave/internal/syscall.h>
-#include <openenclave/internal/thread.h>
 #include <openenclave/internal/time.h>
+#include <openenclave/internal/utils.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,12 +23,12 @@
 #include <time.h>
 #include <unistd.h>
 
-static oe_syscall_hook_t _hook;
-static oe_spinlock_t _lock;
+/* __syscall() reads the hook without a lock: the handlers below keep no
+ * state, so MUSL syscalls from different threads never wait on each other */
+static oe_syscall_hook_t volatile _hook;
 
-static const uint64_t _SEC_TO_MSEC = 1000UL;
-static const uint64_t _MSEC_TO_USEC = 1000UL;
-static const uint64_t _MSEC_TO_NSEC = 1000000UL;
+static const uint64_t _SEC_TO_NSEC = 1000000000UL;
+static const uint64_t _USEC_TO_NSEC = 1000UL;
 
 static long
 _syscall_open(long n, long x1, long x2, long x3, long x4, long x5, long x6)
@@ -93,6 +93,12 @@ _syscall_ioctl(long n, long x1, long x2, long x3, long x4, long x5, long x6)
     return 0;
 }
 
+OE_STATIC_ASSERT(sizeof(oe_host_iovec_t) == sizeof(struct iovec));
+OE_STATIC_ASSERT(
+    OE_OFFSETOF(oe_host_iovec_t, base) == OE_OFFSETOF(struct iovec, iov_base));
+OE_STATIC_ASSERT(
+    OE_OFFSETOF(oe_host_iovec_t, len) == OE_OFFSETOF(struct iovec, iov_len));
+
 static long
 _syscall_writev(long n, long x1, long x2, long x3, long x4, long x5, long x6)
 {
@@ -126,11 +132,11 @@ _syscall_writev(long n, long x1, long x2, long x3, long x4, long x5, long x6)
         }
     }
 
+    /* Gather the vector into a single host write */
+    oe_host_writev(device, (const oe_host_iovec_t*)iov, iovcnt);
+
     for (unsigned long i = 0; i < iovcnt; i++)
-    {
-        oe_host_write(device, iov[i].iov_base, iov[i].iov_len);
         ret += iov[i].iov_len;
-    }
 
     return ret;
 }
@@ -140,25 +146,36 @@ static long _syscall_clock_gettime(long n, long x1, long x2)
     clockid_t clk_id = (clockid_t)x1;
     struct timespec* tp = (struct timespec*)x2;
     int ret = -1;
-    uint64_t msec;
+    oe_clock_t oe_clock;
+    uint64_t nsec;
 
     OE_UNUSED(n);
 
     if (!tp)
         goto done;
 
-    if (clk_id != CLOCK_REALTIME)
+    switch (clk_id)
     {
-        /* Only supporting CLOCK_REALTIME */
-        oe_assert("clock_gettime(): panic" == NULL);
-        goto done;
+        case CLOCK_REALTIME:
+        case CLOCK_REALTIME_COARSE:
+            oe_clock = OE_CLOCK_REALTIME;
+            break;
+        case CLOCK_MONOTONIC:
+        case CLOCK_MONOTONIC_RAW:
+        case CLOCK_MONOTONIC_COARSE:
+        case CLOCK_BOOTTIME:
+            oe_clock = OE_CLOCK_MONOTONIC;
+            break;
+        default:
+            ret = -EINVAL;
+            goto done;
     }
 
-    if ((msec = oe_get_time()) == (uint64_t)-1)
+    if ((nsec = oe_get_clock_time(oe_clock)) == (uint64_t)-1)
         goto done;
 
-    tp->tv_sec = msec / _SEC_TO_MSEC;
-    tp->tv_nsec = (msec % _SEC_TO_MSEC) * _MSEC_TO_NSEC;
+    tp->tv_sec = nsec / _SEC_TO_NSEC;
+    tp->tv_nsec = nsec % _SEC_TO_NSEC;
 
     ret = 0;
 
@@ -172,7 +189,7 @@ static long _syscall_gettimeofday(long n, long x1, long x2)
     struct timeval* tv = (struct timeval*)x1;
     void* tz = (void*)x2;
     int ret = -1;
-    uint64_t msec;
+    uint64_t nsec;
 
     OE_UNUSED(n);
 
@@ -185,11 +202,11 @@ static long _syscall_gettimeofday(long n, long x1, long x2)
     if (!tv)
         goto done;
 
-    if ((msec = oe_get_time()) == (uint64_t)-1)
+    if ((nsec = oe_get_clock_time(OE_CLOCK_REALTIME)) == (uint64_t)-1)
         goto done;
 
-    tv->tv_sec = msec / _SEC_TO_MSEC;
-    tv->tv_usec = msec % _MSEC_TO_USEC;
+    tv->tv_sec = nsec / _SEC_TO_NSEC;
+    tv->tv_usec = (nsec % _SEC_TO_NSEC) / _USEC_TO_NSEC;
 
     ret = 0;
 
@@ -227,9 +244,8 @@ done:
 /* Intercept __syscalls() from MUSL */
 long __syscall(long n, long x1, long x2, long x3, long x4, long x5, long x6)
 {
-    oe_spin_lock(&_lock);
     oe_syscall_hook_t hook = _hook;
-    oe_spin_unlock(&_lock);
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
 
     /* Invoke the syscall hook if any */
     if (hook)
@@ -302,7 +318,7 @@ long syscall(long number, ...)
 
 void oe_register_syscall_hook(oe_syscall_hook_t hook)
 {
-    oe_spin_lock(&_lock);
+    /* Publish the hook with a single (atomic) pointer store */
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
     _hook = hook;
-    oe_spin_unlock(&_lock);
 }
@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include <openenclave/internal/time.h>
+#include <sys/time.h>
+#include <time.h>
+#include "clock_t.h"
+
+#if defined(USE_TSC_CLOCK)
+OE_USE_TSC_CLOCK(10);
+#endif
+
+static const uint64_t SEC_TO_NSEC = 1000000000UL;
+static const uint64_t MSEC_TO_NSEC = 1000000UL;
+
+static uint64_t _clock_gettime(clockid_t clk_id)
+{
+    struct timespec ts;
+
+    OE_TEST(clock_gettime(clk_id, &ts) == 0);
+    OE_TEST(ts.tv_nsec >= 0 && (uint64_t)ts.tv_nsec < SEC_TO_NSEC);
+
+    return (uint64_t)ts.tv_sec * SEC_TO_NSEC + (uint64_t)ts.tv_nsec;
+}
+
+bool enc_uses_tsc_clock()
+{
+    return oe_tsc_clock_max_staleness != 0;
+}
+
+/* host_time is the host CLOCK_REALTIME in nanoseconds just before the call */
+oe_result_t enc_test_clocks(uint64_t host_time)
+{
+    /* CLOCK_REALTIME and gettimeofday() agree with the host */
+    {
+        uint64_t now = _clock_gettime(CLOCK_REALTIME);
+        struct timeval tv;
+
+        OE_TEST(now + MSEC_TO_NSEC >= host_time);
+        OE_TEST(now < host_time + SEC_TO_NSEC);
+
+        OE_TEST(gettimeofday(&tv, NULL) == 0);
+        OE_TEST(tv.tv_usec >= 0 && tv.tv_usec < 1000000);
+        OE_TEST((uint64_t)tv.tv_sec >= now / SEC_TO_NSEC);
+        OE_TEST((uint64_t)tv.tv_sec <= now / SEC_TO_NSEC + 1);
+    }
+
+    /* Unsupported clocks fail instead of asserting */
+    {
+        struct timespec ts;
+
+        errno = 0;
+        OE_TEST(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == -1);
+        OE_TEST(errno == EINVAL);
+        OE_TEST(oe_get_clock_time((oe_clock_t)2) == (uint64_t)-1);
+    }
+
+    /* CLOCK_MONOTONIC follows nanosleep(). The TSC clock is calibrated
+     * after this sleep. */
+    {
+        struct timespec req = {0, 20 * (long)MSEC_TO_NSEC};
+        uint64_t before = _clock_gettime(CLOCK_MONOTONIC);
+        uint64_t after;
+
+        OE_TEST(nanosleep(&req, NULL) == 0);
+        after = _clock_gettime(CLOCK_MONOTONIC);
+
+        OE_TEST(after >= before + 20 * MSEC_TO_NSEC);
+        OE_TEST(after < before + 10 * SEC_TO_NSEC);
+    }
+
+    /* Both clocks resolve less than a millisecond */
+    {
+        bool submsec[2] = {false, false};
+        const clockid_t clk_ids[2] = {CLOCK_REALTIME, CLOCK_MONOTONIC};
+
+        for (size_t i = 0; i < 2; i++)
+        {
+            for (size_t j = 0; j < 1000 && !submsec[i]; j++)
+            {
+                uint64_t t1 = _clock_gettime(clk_ids[i]);
+                uint64_t t2 = _clock_gettime(clk_ids[i]);
+
+                OE_TEST(t2 >= t1);
+                submsec[i] = t2 > t1 && t2 - t1 < MSEC_TO_NSEC;
+            }
+
+            OE_TEST(submsec[i]);
+        }
+    }
+
+    return OE_OK;
+}
+
+/* CLOCK_REALTIME in nanoseconds, checked against gettimeofday() */
+uint64_t enc_get_realtime()
+{
+    uint64_t now = _clock_gettime(CLOCK_REALTIME);
+    struct timeval tv;
+
+    OE_TEST(gettimeofday(&tv, NULL) == 0);
+    OE_TEST((uint64_t)tv.tv_sec >= now / SEC_TO_NSEC);
+    OE_TEST((uint64_t)tv.tv_sec <= now / SEC_TO_NSEC + 1);
+
+    return now;
+}
+
+/* Read both clocks, checking that CLOCK_MONOTONIC never goes back (the
+ * realtime clock follows the host clock, which may be set back) */
+oe_result_t enc_clock_loop(uint64_t iterations)
+{
+    uint64_t monotonic = 0;
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        uint64_t t;
+
+        OE_TEST(oe_get_clock_time(OE_CLOCK_REALTIME) != (uint64_t)-1);
+
+        OE_TEST((t = oe_get_clock_time(OE_CLOCK_MONOTONIC)) != (uint64_t)-1);
+        OE_TEST(t >= monotonic);
+        monotonic = t;
+    }
+
+    return OE_OK;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    8);   /* TCSCount */
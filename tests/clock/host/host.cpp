@@ -0,0 +1,157 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "clock_u.h"
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* Must not exceed the TCSCount of the enclave */
+const size_t NUM_THREADS = 8;
+
+const uint64_t ITERATIONS_PER_THREAD = 100000;
+
+#if defined(__linux__)
+
+const int64_t SEC_TO_NSEC = 1000000000;
+
+/* Nanoseconds added to CLOCK_REALTIME by the clock_gettime() below, which
+ * replaces the one of the C library in this program, including in the host
+ * side of the clock OCALL */
+static std::atomic<int64_t> _realtime_offset(0);
+
+extern "C" int clock_gettime(clockid_t clk_id, struct timespec* tp) noexcept
+{
+    if (syscall(SYS_clock_gettime, clk_id, tp) != 0)
+        return -1;
+
+    if (clk_id == CLOCK_REALTIME && _realtime_offset != 0)
+    {
+        int64_t nsec = tp->tv_sec * SEC_TO_NSEC + tp->tv_nsec +
+                       _realtime_offset;
+
+        tp->tv_sec = nsec / SEC_TO_NSEC;
+        tp->tv_nsec = nsec % SEC_TO_NSEC;
+    }
+
+    return 0;
+}
+
+/* Set the host clock back: the realtime clock of the enclave follows */
+static void _test_backward_step(oe_enclave_t* enclave)
+{
+    const int64_t step = 10 * SEC_TO_NSEC;
+    uint64_t before = 0;
+    uint64_t after = 0;
+
+    OE_TEST(enc_get_realtime(enclave, &before) == OE_OK);
+
+    _realtime_offset = -step;
+
+    /* Let the anchor of the TSC clock get stale */
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    OE_TEST(enc_get_realtime(enclave, &after) == OE_OK);
+
+    _realtime_offset = 0;
+
+    OE_TEST(after + static_cast<uint64_t>(step / 2) < before);
+    OE_TEST(after + static_cast<uint64_t>(step) > before);
+}
+
+#endif
+
+static void _loop_thread(oe_enclave_t* enclave)
+{
+    oe_result_t return_value = OE_UNEXPECTED;
+
+    OE_TEST(
+        enc_clock_loop(enclave, &return_value, ITERATIONS_PER_THREAD) ==
+        OE_OK);
+    OE_TEST(return_value == OE_OK);
+}
+
+/* Read the clocks ITERATIONS_PER_THREAD times on each of num_threads
+ * threads, and return the average nanoseconds per read */
+static double _run_threads(oe_enclave_t* enclave, size_t num_threads)
+{
+    std::thread threads[NUM_THREADS];
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < num_threads; i++)
+        threads[i] = std::thread(_loop_thread, enclave);
+
+    for (size_t i = 0; i < num_threads; i++)
+        threads[i].join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double elapsed =
+        std::chrono::duration<double, std::nano>(end - start).count();
+
+    /* enc_clock_loop() reads two clocks per iteration */
+    return elapsed / static_cast<double>(2 * ITERATIONS_PER_THREAD);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    bool tsc = false;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    result = oe_create_clock_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(enc_uses_tsc_clock(enclave, &tsc) == OE_OK);
+
+    {
+        oe_result_t return_value = OE_UNEXPECTED;
+        uint64_t host_time = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                .count());
+
+        OE_TEST(enc_test_clocks(enclave, &return_value, host_time) == OE_OK);
+        OE_TEST(return_value == OE_OK);
+    }
+
+#if defined(__linux__)
+    _test_backward_step(enclave);
+#endif
+
+    for (size_t num_threads = 1; num_threads <= NUM_THREADS; num_threads *= 2)
+    {
+        double nsec = _run_threads(enclave, num_threads);
+
+        printf(
+            "%s: %s: %zu threads: %.1f ns per clock read\n",
+            argv[0],
+            tsc ? "TSC clock" : "host clock",
+            num_threads,
+            nsec);
+    }
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (clock)\n");
+
+    return 0;
+}
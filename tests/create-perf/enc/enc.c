@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/malloc.h>
+#include "create_perf_t.h"
+
+uint64_t enc_heap_size()
+{
+    oe_heap_stats_t stats;
+
+    if (oe_get_heap_stats(&stats) != OE_OK)
+        return 0;
+
+    return stats.heap_size;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,               /* ProductID */
+    1,               /* SecurityVersion */
+    true,            /* AllowDebug */
+    HEAP_PAGE_COUNT, /* HeapPageCount */
+    16,              /* StackPageCount */
+    1);              /* TCSCount */
@@ -0,0 +1,153 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/defs.h>
+#include <openenclave/internal/sgxcreate.h>
+#include <openenclave/internal/tests.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "../../../host/sgx/enclave.h"
+#include "create_perf_u.h"
+
+#if defined(__linux__)
+#include <sys/sysinfo.h>
+#endif
+
+#define SKIP_RETURN_CODE 2
+
+const size_t NUM_RUNS = 3;
+
+const uint64_t MEGABYTE = 1024 * 1024;
+
+/* Get the free system memory (RAM plus swap) */
+static uint64_t _get_free_system_memory(void)
+{
+#if defined(__linux__)
+    struct sysinfo info;
+
+    if (sysinfo(&info) != 0)
+        return 0;
+
+    return (info.freeram + info.freeswap) * info.mem_unit;
+#else
+    return UINT64_MAX;
+#endif
+}
+
+/* Build the enclave for measurement only, as oesign does before signing it,
+ * and return the time taken in milliseconds */
+static double _measure_enclave(const char* path)
+{
+    static oe_enclave_t enclave;
+    oe_sgx_load_context_t context;
+    OE_SHA256 zero_hash = {{0}};
+
+    OE_TEST(
+        oe_sgx_initialize_load_context(
+            &context, OE_SGX_LOAD_TYPE_MEASURE, OE_ENCLAVE_FLAG_DEBUG) ==
+        OE_OK);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    OE_TEST(oe_sgx_build_enclave(&context, path, NULL, &enclave) == OE_OK);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    OE_TEST(memcmp(&enclave.hash, &zero_hash, sizeof(zero_hash)) != 0);
+
+    oe_sgx_cleanup_load_context(&context);
+    oe_free_enclave_ecalls(&enclave);
+    oe_mutex_destroy(&enclave.lock);
+    free(enclave.path);
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    uint64_t heap_size;
+    double first_msec = 0;
+    double total_msec = 0;
+    double min_msec = 0;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH HEAP_MEGABYTES\n", argv[0]);
+        return 1;
+    }
+
+    heap_size = strtoull(argv[2], NULL, 10) * MEGABYTE;
+
+    /* The heap pages are all written in simulation mode */
+    if (_get_free_system_memory() < 2 * heap_size)
+    {
+        fprintf(
+            stderr,
+            "%s: warning: insufficient memory for a %s MB heap\n",
+            argv[0],
+            argv[2]);
+
+        return SKIP_RETURN_CODE;
+    }
+
+    const uint32_t flags = oe_get_create_flags() | OE_ENCLAVE_FLAG_SIMULATE;
+
+    for (size_t i = 0; i < NUM_RUNS; i++)
+    {
+        oe_enclave_t* enclave = NULL;
+        uint64_t enclave_heap_size = 0;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        result = oe_create_create_perf_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+        OE_TEST(result == OE_OK);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        double msec =
+            std::chrono::duration<double, std::milli>(end - start).count();
+
+        /* Only the first creation loads the image, the next ones find it in
+         * the image cache */
+        if (i == 0)
+            first_msec = msec;
+        else
+            total_msec += msec;
+
+        min_msec = (i == 0 || msec < min_msec) ? msec : min_msec;
+
+        OE_TEST(enc_heap_size(enclave, &enclave_heap_size) == OE_OK);
+        OE_TEST(enclave_heap_size == heap_size);
+
+        OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+    }
+
+    printf(
+        "%s: %s MB heap: oe_create_enclave() %.1f ms, then %.1f ms "
+        "(min %.1f ms), %.0f heap pages per second\n",
+        argv[0],
+        argv[2],
+        first_msec,
+        total_msec / (NUM_RUNS - 1),
+        min_msec,
+        static_cast<double>(heap_size / OE_PAGE_SIZE) / (min_msec / 1000));
+
+    {
+        double measure_msec = 0;
+
+        for (size_t i = 0; i < NUM_RUNS; i++)
+            measure_msec += _measure_enclave(argv[1]);
+
+        printf(
+            "%s: %s MB heap: measurement for signing %.1f ms\n",
+            argv[0],
+            argv[2],
+            measure_msec / NUM_RUNS);
+    }
+
+    printf("=== passed all tests (create-perf)\n");
+
+    return 0;
+}
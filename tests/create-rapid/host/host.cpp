@@ -7,6 +7,8 @@
 #include <openenclave/internal/tests.h>
 #include <cstdio>
 #include <cstdlib>
+#include <fstream>
+#include <sstream>
 #include <thread>
 #include <vector>
 #include "create_rapid_u.h"
@@ -140,6 +142,48 @@ static void _test_multithreaded(
         thread.join();
 }
 
+static void _write_file(const char* path, const std::string& data)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+
+    OE_TEST(stream.write(data.data(), (std::streamsize)data.size()).good());
+}
+
+/* Enclaves created from the same file share its image (see
+ * host/sgx/imagecache.h), which must not be reused once the file changed */
+static void _test_modified_file(const char* path, uint32_t flags)
+{
+    const char copy[] = "create_rapid_enc.copy";
+    std::ostringstream data;
+    oe_enclave_t* enclave = NULL;
+
+    {
+        std::ifstream stream(path, std::ios::binary);
+        OE_TEST(stream.good());
+        data << stream.rdbuf();
+    }
+
+    _write_file(copy, data.str());
+    _launch_enclave(copy, flags, true);
+    _launch_enclave(copy, flags, true);
+
+    /* An enclave cannot be created from a truncated file */
+    _write_file(copy, data.str().substr(0, data.str().size() / 2));
+    OE_TEST(
+        oe_create_create_rapid_enclave(
+            copy, OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) != OE_OK);
+
+    /* Nor from a missing one */
+    remove(copy);
+    OE_TEST(
+        oe_create_create_rapid_enclave(
+            copy, OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) != OE_OK);
+
+    _write_file(copy, data.str());
+    _launch_enclave(copy, flags, true);
+    remove(copy);
+}
+
 int main(int argc, const char* argv[])
 {
     if (argc != 2)
@@ -162,5 +206,8 @@ int main(int argc, const char* argv[])
     _test_multithreaded(argv[1], flags, false);
     _test_multithreaded(argv[1], flags, true);
 
+    // Test creating enclaves from a file that changes.
+    _test_modified_file(argv[1], flags);
+
     return 0;
 }
@@ -53,3 +53,18 @@ struct CrossEnclaveCallArg
     uint32_t input;
     uint32_t output;
 };
+
+// Stand-in for a per-record MAC, computed by enc_batch_mac() in the enclave
+// and checked by the host.
+inline uint64_t BatchMac(uint64_t key, uint64_t record)
+{
+    uint64_t h = key ^ 0xcbf29ce484222325ULL;
+
+    for (int i = 0; i < 8; i++)
+    {
+        h ^= (record >> (i * 8)) & 0xff;
+        h *= 0x100000001b3ULL;
+    }
+
+    return h;
+}
@@ -3,14 +3,17 @@
 
 #include <openenclave/edger8r/enclave.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/calls.h>
 #include <openenclave/internal/globals.h> // for __oe_get_enclave_base()
 #include <openenclave/internal/tests.h>
 #include <openenclave/internal/thread.h>
 #include <openenclave/internal/trace.h>
 #include <stdio.h>
+#include <string.h>
 #include <mutex>
 #include <system_error>
 #include "../args.h"
+#include "ecall_ocall_t.h"
 #include "helpers.h"
 
 unsigned EnclaveId = ~0u;
@@ -166,6 +169,79 @@ OE_ECALL void EncSetFactor(void* arg)
     Factor = (size_t)arg;
 }
 
+// Ocall benchmark. Each iteration makes one EDL-generated ocall. With legacy
+// set, each iteration also makes the OE_OCALL_MALLOC/OE_OCALL_FREE pairs that
+// a generated ocall used to cost before the marshalling buffer and the
+// oe_call_host_function_args_t came from the per-thread host arena.
+void enc_benchmark_ocalls(uint64_t iterations, bool legacy)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        void* buffer = NULL;
+        void* args = NULL;
+        int value = static_cast<int>(i & 0xffff);
+        int result = 0;
+
+        if (legacy)
+        {
+            OE_TEST((buffer = oe_host_malloc(sizeof(int) * 2)) != NULL);
+            OE_TEST(
+                (args = oe_host_malloc(sizeof(oe_call_host_function_args_t))) !=
+                NULL);
+        }
+
+        OE_TEST(host_benchmark_ocall(&result, value) == OE_OK);
+        OE_TEST(result == value + 1);
+
+        if (legacy)
+        {
+            oe_host_free(args);
+            oe_host_free(buffer);
+        }
+    }
+}
+
+// Free ocall buffers out of order: no buffer may be handed out again, nor
+// overwritten, while a buffer allocated after it is still live.
+void enc_test_ocall_buffers()
+{
+    const size_t size = 256;
+    uint8_t* first;
+    uint8_t* second;
+    uint8_t* third;
+
+    OE_TEST((first = (uint8_t*)oe_allocate_ocall_buffer(size)) != NULL);
+    OE_TEST((second = (uint8_t*)oe_allocate_ocall_buffer(size)) != NULL);
+    memset(first, 0xAA, size);
+    memset(second, 0xBB, size);
+
+    /* Free in allocation order, reallocating in between */
+    oe_free_ocall_buffer(first);
+    OE_TEST((third = (uint8_t*)oe_allocate_ocall_buffer(size)) != NULL);
+    memset(third, 0xCC, size);
+
+    for (size_t i = 0; i < size; i++)
+        OE_TEST(second[i] == 0xBB);
+
+    oe_free_ocall_buffer(second);
+
+    for (size_t i = 0; i < size; i++)
+        OE_TEST(third[i] == 0xCC);
+
+    oe_free_ocall_buffer(third);
+
+    /* Once all are freed, the arena is reused from the bottom */
+    OE_TEST((third = (uint8_t*)oe_allocate_ocall_buffer(size)) == first);
+    oe_free_ocall_buffer(third);
+}
+
+// Batched ecall. The host calls it through the generated
+// enc_batch_mac_batch() wrapper as well as one call at a time.
+uint64_t enc_batch_mac(uint64_t key, uint64_t record)
+{
+    return BatchMac(key, record);
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
@@ -173,5 +249,3 @@ OE_SET_ENCLAVE_SGX(
     256,  /* HeapPageCount */
     16,   /* StackPageCount */
     5);   /* TCSCount */
-
-OE_DEFINE_EMPTY_ECALL_TABLE();
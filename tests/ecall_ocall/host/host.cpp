@@ -7,6 +7,7 @@
 #include <openenclave/internal/types.h>
 #include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -16,6 +17,7 @@
 #include <thread>
 #include <vector>
 #include "../args.h"
+#include "ecall_ocall_u.h"
 
 #define THREAD_COUNT 5 // must not exceed what is configured in sign.conf
 
@@ -30,18 +32,17 @@ struct EnclaveWrap
         oe_enclave_t* enclave;
         oe_result_t result;
 
-        if ((result = oe_create_enclave(
+        if ((result = oe_create_ecall_ocall_enclave(
                  enclave_path,
                  OE_ENCLAVE_TYPE_SGX,
                  flags,
                  NULL,
                  0,
-                 NULL,
-                 0,
                  &enclave)) != OE_OK)
         {
-            oe_put_err("oe_create_enclave(): result=%u", result);
-            throw std::runtime_error("oe_create_enclave() failed");
+            oe_put_err("oe_create_ecall_ocall_enclave(): result=%u", result);
+            throw std::runtime_error(
+                "oe_create_ecall_ocall_enclave() failed");
         }
         m_id = static_cast<unsigned>(m_enclaves.size());
 
@@ -350,6 +351,107 @@ static void TestCrossEnclaveCalls()
     printf("=== TestCrossEnclaveCalls passed\n");
 }
 
+int host_benchmark_ocall(int value)
+{
+    return value + 1;
+}
+
+// Ocall benchmark - time generated ocalls with and without the extra
+// OE_OCALL_MALLOC/OE_OCALL_FREE transitions they used to require.
+static void BenchmarkOcalls(unsigned enclave_id)
+{
+    const uint64_t iterations = 100000;
+    double per_ocall[2];
+
+    for (int legacy = 1; legacy >= 0; legacy--)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        OE_TEST(
+            enc_benchmark_ocalls(
+                EnclaveWrap::Get(enclave_id), iterations, legacy != 0) ==
+            OE_OK);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        double elapsed =
+            std::chrono::duration<double, std::micro>(end - start).count();
+
+        per_ocall[legacy] = elapsed / iterations;
+        printf(
+            "%s(): %s: %llu ocalls in %.0f us (%.3f us/ocall)\n",
+            __FUNCTION__,
+            legacy ? "before (5 transitions)" : "after (1 transition)",
+            OE_LLU(iterations),
+            elapsed,
+            per_ocall[legacy]);
+    }
+
+    printf(
+        "%s(): speedup %.2fx\n", __FUNCTION__, per_ocall[1] / per_ocall[0]);
+}
+
+// Batched ecalls - check that each call of a batch is dispatched and its
+// results unmarshalled, then time a batch against the same calls made one at
+// a time.
+static void TestBatchEcalls(unsigned enclave_id)
+{
+    const size_t count = 10000;
+    const uint64_t key = 0x0123456789abcdef;
+    oe_enclave_t* enclave = EnclaveWrap::Get(enclave_id);
+    std::vector<enc_batch_mac_args_t> batch(count);
+    double per_ecall[2];
+
+    OE_TEST(enc_batch_mac_batch(enclave, NULL, 0) == OE_OK);
+
+    for (int batched = 0; batched <= 1; batched++)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            batch[i] = enc_batch_mac_args_t();
+            batch[i].key = key;
+            batch[i].record = i;
+            batch[i]._result = OE_FAILURE;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        if (batched)
+        {
+            OE_TEST(enc_batch_mac_batch(enclave, &batch[0], count) == OE_OK);
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                batch[i]._result = enc_batch_mac(
+                    enclave, &batch[i]._retval, batch[i].key, batch[i].record);
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        double elapsed =
+            std::chrono::duration<double, std::micro>(end - start).count();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            OE_TEST(batch[i]._result == OE_OK);
+            OE_TEST(batch[i]._retval == BatchMac(key, i));
+        }
+
+        per_ecall[batched] = elapsed / static_cast<double>(count);
+        printf(
+            "%s(): %s: %llu ecalls in %.0f us (%.3f us/ecall)\n",
+            __FUNCTION__,
+            batched ? "batched" : "one at a time",
+            OE_LLU(count),
+            elapsed,
+            per_ecall[batched]);
+    }
+
+    printf(
+        "%s(): speedup %.2fx\n", __FUNCTION__, per_ecall[0] / per_ecall[1]);
+}
+
 int main(int argc, const char* argv[])
 {
     if (argc != 2)
@@ -374,6 +476,13 @@ int main(int argc, const char* argv[])
     // verify threads execute in parallel
     TestExecutionParallel({enc1.GetId()}, THREAD_COUNT);
 
+    // verify ocall buffers freed out of order
+    OE_TEST(enc_test_ocall_buffers(EnclaveWrap::Get(enc1.GetId())) == OE_OK);
+
+    // measure the cost of generated ocalls
+    BenchmarkOcalls(enc1.GetId());
+    TestBatchEcalls(enc1.GetId());
+
     // Test in a 2nd enclave
     EnclaveWrap enc2(argv[1], flags);
     // verify initial OCall succeeded
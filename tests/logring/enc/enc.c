@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/trace.h>
+#include "logring_t.h"
+
+void enc_log_messages(uint64_t count)
+{
+    for (uint64_t i = 0; i < count; i++)
+        OE_TRACE_INFO("logring message %llu", (unsigned long long)i);
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    8);   /* TCSCount */
@@ -0,0 +1,153 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "../../../host/sgx/enclave.h"
+#include "../../../host/sgx/logring.h"
+#include "logring_u.h"
+
+/* Must not exceed the TCSCount of the enclave */
+const size_t NUM_THREADS = 4;
+
+const uint64_t MESSAGES_PER_THREAD = 20000;
+
+/* Messages logged by _test_corrupt_head(), which are all dropped */
+const uint64_t NUM_CORRUPT_MESSAGES = 2;
+
+static void _set_env(const char* name, const char* value)
+{
+#if defined(_WIN32)
+    OE_TEST(_putenv_s(name, value) == 0);
+#else
+    OE_TEST(setenv(name, value, 1) == 0);
+#endif
+}
+
+/* Log one message while the host has set the head of the ring to HEAD */
+static void _log_with_head(oe_enclave_t* enclave, uint64_t head)
+{
+    oe_log_ring_t* ring = enclave->log_flusher->ring;
+    uint64_t saved = ring->head;
+    uint64_t dropped = ring->dropped;
+
+    ring->head = head;
+    OE_TEST(enc_log_messages(enclave, 1) == OE_OK);
+
+    /* The enclave counts the message as dropped rather than writing it */
+    OE_TEST(ring->head == head);
+    OE_TEST(ring->dropped == dropped + 1);
+
+    ring->head = saved;
+}
+
+/* The ring is in host memory: check that the enclave does not trust its head
+ * (the bytes past the end of the ring could be enclave memory) */
+static void _test_corrupt_head(oe_enclave_t* enclave)
+{
+    oe_log_ring_t* ring = enclave->log_flusher->ring;
+    uint64_t tail;
+
+    /* Wait for the flusher to drain the ring, so that nobody moves head */
+    while (ring->tail != ring->head)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    tail = ring->tail;
+
+    /* Misaligned: a padding record would end past the end of the ring */
+    _log_with_head(
+        enclave, tail - (tail & (OE_LOG_RING_SIZE - 1)) + OE_LOG_RING_SIZE - 8);
+
+    /* More than the size of the ring ahead of the tail */
+    _log_with_head(enclave, tail + OE_LOG_RING_SIZE + sizeof(oe_log_record_t));
+}
+
+static void _log_thread(oe_enclave_t* enclave)
+{
+    OE_TEST(enc_log_messages(enclave, MESSAGES_PER_THREAD) == OE_OK);
+}
+
+int main(int argc, const char* argv[])
+{
+    const char path[] = "logring.log";
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    std::thread threads[NUM_THREADS];
+    char line[512];
+    FILE* stream;
+    uint64_t num_messages = 0;
+    uint64_t num_dropped = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    /* The log settings are read when the first enclave is created */
+    remove(path);
+    _set_env("OE_LOG_LEVEL", "INFO");
+    _set_env("OE_LOG_DEVICE", path);
+
+    const uint32_t flags = oe_get_create_flags();
+
+    result = oe_create_logring_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+        threads[i] = std::thread(_log_thread, enclave);
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+        threads[i].join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    _test_corrupt_head(enclave);
+
+    /* Terminating the enclave writes the messages left in the ring */
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    /* Each message was either written or counted as dropped */
+    OE_TEST((stream = fopen(path, "r")) != NULL);
+
+    while (fgets(line, sizeof(line), stream))
+    {
+        const char* p;
+        unsigned long long n;
+
+        if (strstr(line, "(E)[INFO]") && strstr(line, "logring message "))
+            num_messages++;
+        else if (
+            (p = strstr(line, "(E)[WARN]")) &&
+            sscanf(p, "(E)[WARN]%llu log messages dropped", &n) == 1)
+            num_dropped += n;
+    }
+
+    fclose(stream);
+    remove(path);
+
+    OE_TEST(num_messages > 0);
+    OE_TEST(
+        num_messages + num_dropped ==
+        NUM_THREADS * MESSAGES_PER_THREAD + NUM_CORRUPT_MESSAGES);
+
+    printf(
+        "%s: %zu threads: %.2f M messages per second, %llu dropped\n",
+        argv[0],
+        NUM_THREADS,
+        static_cast<double>(NUM_THREADS * MESSAGES_PER_THREAD) /
+            std::chrono::duration<double, std::micro>(end - start).count(),
+        static_cast<unsigned long long>(num_dropped));
+
+    printf("=== passed all tests (logring)\n");
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/malloc.h>
+#include <openenclave/internal/tests.h>
+#include "mtmalloc_t.h"
+
+#if defined(USE_THREAD_ARENAS)
+OE_USE_THREAD_ARENAS();
+#endif
+
+/* Number of live blocks kept by each thread */
+#define NUM_LOCAL_BLOCKS 64
+
+/* Blocks handed from one thread to another, to be freed by the receiver */
+#define NUM_HANDOFF_SLOTS 64
+static void* volatile _handoff[NUM_HANDOFF_SLOTS];
+
+bool enc_uses_thread_arenas()
+{
+    return oe_use_thread_arenas;
+}
+
+static uint64_t _next_random(uint64_t* state)
+{
+    /* xorshift64 */
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+/* Allocate and free blocks of 16 to 4096 bytes. Every 8th block is handed
+ * off to another thread through _handoff[], and the block taken out of the
+ * slot (allocated by some other thread) is freed. */
+oe_result_t enc_malloc_loop(uint64_t iterations)
+{
+    uint8_t* blocks[NUM_LOCAL_BLOCKS] = {NULL};
+    uint64_t state = (uint64_t)blocks | 1;
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        uint64_t r = _next_random(&state);
+        size_t n = (size_t)(r % NUM_LOCAL_BLOCKS);
+        size_t size = 16 + (size_t)((r >> 8) % 4081);
+        uint8_t* p;
+
+        if (blocks[n])
+        {
+            /* Check the pattern written when the block was allocated */
+            OE_TEST(blocks[n][0] == (uint8_t)n);
+            oe_free(blocks[n]);
+            blocks[n] = NULL;
+        }
+
+        if (!(p = (uint8_t*)oe_malloc(size)))
+            return OE_OUT_OF_MEMORY;
+
+        oe_memset(p, (int)n, size);
+
+        if (i % 8 == 0)
+        {
+            size_t slot = (size_t)((r >> 32) % NUM_HANDOFF_SLOTS);
+            void* other =
+                __atomic_exchange_n(&_handoff[slot], p, __ATOMIC_ACQ_REL);
+
+            if (other)
+                oe_free(other);
+        }
+        else
+        {
+            blocks[n] = p;
+        }
+    }
+
+    for (size_t n = 0; n < NUM_LOCAL_BLOCKS; n++)
+        oe_free(blocks[n]);
+
+    return OE_OK;
+}
+
+/* Free the blocks left in _handoff[] and check the heap statistics */
+oe_result_t enc_check_malloc_stats()
+{
+    oe_malloc_stats_t stats;
+
+    for (size_t i = 0; i < NUM_HANDOFF_SLOTS; i++)
+    {
+        oe_free(_handoff[i]);
+        _handoff[i] = NULL;
+    }
+
+    OE_TEST(oe_get_malloc_stats(&stats) == OE_OK);
+    OE_TEST(stats.system_bytes > 0);
+    OE_TEST(stats.peak_system_bytes >= stats.system_bytes);
+    OE_TEST(stats.in_use_bytes <= stats.system_bytes);
+
+    {
+        oe_heap_stats_t heap_stats;
+
+        OE_TEST(oe_get_heap_stats(&heap_stats) == OE_OK);
+        OE_TEST(heap_stats.heap_size == 4096 * OE_PAGE_SIZE);
+        OE_TEST(heap_stats.sbrk_bytes <= heap_stats.peak_sbrk_bytes);
+        OE_TEST(heap_stats.peak_sbrk_bytes <= heap_stats.heap_size);
+        OE_TEST(heap_stats.system_bytes <= heap_stats.peak_sbrk_bytes);
+        OE_TEST(heap_stats.system_bytes <= heap_stats.peak_system_bytes);
+        OE_TEST(heap_stats.in_use_bytes > 0);
+        OE_TEST(heap_stats.fragmented_bytes <= heap_stats.free_bytes);
+    }
+
+    return OE_OK;
+}
+
+#define POOL_OBJECT_SIZE 64
+
+/* Pool shared by the threads of enc_pool_loop() */
+static oe_pool_t* _pool;
+
+static void* volatile _pool_handoff[NUM_HANDOFF_SLOTS];
+
+oe_result_t enc_pool_tests()
+{
+    static void* objects[1000];
+    oe_pool_t* pool;
+
+    /* Invalid sizes and alignments */
+    OE_TEST(oe_pool_create(0, 0) == NULL);
+    OE_TEST(oe_pool_create(1024 * 1024, 0) == NULL);
+    OE_TEST(oe_pool_create(16, 3) == NULL);
+    OE_TEST(oe_pool_create(16, 2 * OE_PAGE_SIZE) == NULL);
+    OE_TEST(oe_pool_alloc(NULL) == NULL);
+    oe_pool_free(NULL, NULL);
+    oe_pool_destroy(NULL);
+
+    /* Objects are aligned, distinct and span several slabs */
+    OE_TEST((pool = oe_pool_create(24, 64)) != NULL);
+
+    for (size_t i = 0; i < OE_COUNTOF(objects); i++)
+    {
+        OE_TEST((objects[i] = oe_pool_alloc(pool)) != NULL);
+        OE_TEST((uint64_t)objects[i] % 64 == 0);
+        oe_memset(objects[i], (int)i, 24);
+    }
+
+    for (size_t i = 0; i < OE_COUNTOF(objects); i++)
+    {
+        OE_TEST(*(uint8_t*)objects[i] == (uint8_t)i);
+        oe_pool_free(pool, objects[i]);
+    }
+
+    /* Released objects are reused */
+    {
+        void* object = oe_pool_alloc(pool);
+        bool found = false;
+
+        for (size_t i = 0; i < OE_COUNTOF(objects); i++)
+            found = found || objects[i] == object;
+
+        OE_TEST(found);
+        oe_pool_free(pool, object);
+    }
+
+    oe_pool_destroy(pool);
+
+    /* Create the pool for enc_pool_loop() */
+    OE_TEST((_pool = oe_pool_create(POOL_OBJECT_SIZE, 0)) != NULL);
+
+    return OE_OK;
+}
+
+/* Same pattern as enc_malloc_loop() with objects from _pool */
+oe_result_t enc_pool_loop(uint64_t iterations)
+{
+    uint8_t* objects[NUM_LOCAL_BLOCKS] = {NULL};
+    uint64_t state = (uint64_t)objects | 1;
+
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        uint64_t r = _next_random(&state);
+        size_t n = (size_t)(r % NUM_LOCAL_BLOCKS);
+        uint8_t* p;
+
+        if (objects[n])
+        {
+            OE_TEST(objects[n][0] == (uint8_t)n);
+            oe_pool_free(_pool, objects[n]);
+            objects[n] = NULL;
+        }
+
+        if (!(p = (uint8_t*)oe_pool_alloc(_pool)))
+            return OE_OUT_OF_MEMORY;
+
+        oe_memset(p, (int)n, POOL_OBJECT_SIZE);
+
+        if (i % 8 == 0)
+        {
+            size_t slot = (size_t)((r >> 32) % NUM_HANDOFF_SLOTS);
+            void* other =
+                __atomic_exchange_n(&_pool_handoff[slot], p, __ATOMIC_ACQ_REL);
+
+            oe_pool_free(_pool, other);
+        }
+        else
+        {
+            objects[n] = p;
+        }
+    }
+
+    for (size_t n = 0; n < NUM_LOCAL_BLOCKS; n++)
+        oe_pool_free(_pool, objects[n]);
+
+    return OE_OK;
+}
+
+oe_result_t enc_pool_destroy()
+{
+    oe_pool_destroy(_pool);
+    _pool = NULL;
+
+    return OE_OK;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    4096, /* HeapPageCount */
+    64,   /* StackPageCount */
+    16);  /* TCSCount */
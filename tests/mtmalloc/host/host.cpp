@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include "mtmalloc_u.h"
+
+/* Must not exceed the TCSCount of the enclave */
+const size_t MAX_THREADS = 16;
+
+const uint64_t ITERATIONS_PER_THREAD = 200000;
+
+/* enc_malloc_loop() or enc_pool_loop() */
+typedef oe_result_t (*loop_ecall_t)(oe_enclave_t*, oe_result_t*, uint64_t);
+
+static void _loop_thread(oe_enclave_t* enclave, loop_ecall_t loop)
+{
+    oe_result_t return_value = OE_UNEXPECTED;
+
+    OE_TEST(loop(enclave, &return_value, ITERATIONS_PER_THREAD) == OE_OK);
+    OE_TEST(return_value == OE_OK);
+}
+
+/* Time ITERATIONS_PER_THREAD allocate/free pairs on each of num_threads
+ * threads, and return the throughput in millions of pairs per second */
+static double _run_threads(
+    oe_enclave_t* enclave,
+    loop_ecall_t loop,
+    size_t num_threads)
+{
+    std::thread threads[MAX_THREADS];
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < num_threads; i++)
+        threads[i] = std::thread(_loop_thread, enclave, loop);
+
+    for (size_t i = 0; i < num_threads; i++)
+        threads[i].join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double elapsed =
+        std::chrono::duration<double, std::micro>(end - start).count();
+
+    return static_cast<double>(num_threads * ITERATIONS_PER_THREAD) / elapsed;
+}
+
+/* Sample the allocations of two threads and check the written profile */
+static void _test_heap_profile(oe_enclave_t* enclave)
+{
+    const char path[] = "mtmalloc.heap";
+    char line[256];
+    FILE* stream;
+    size_t num_samples = 0;
+    bool mapped = false;
+
+    OE_TEST(oe_set_heap_profile_rate(NULL, 4096) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_write_heap_profile(enclave, NULL) == OE_INVALID_PARAMETER);
+
+    OE_TEST(oe_set_heap_profile_rate(enclave, 64 * 1024) == OE_OK);
+    _run_threads(enclave, enc_malloc_loop, 2);
+    OE_TEST(oe_set_heap_profile_rate(enclave, 0) == OE_OK);
+
+    OE_TEST(oe_write_heap_profile(enclave, path) == OE_OK);
+
+    OE_TEST((stream = fopen(path, "r")) != NULL);
+    OE_TEST(fgets(line, sizeof(line), stream) != NULL);
+    OE_TEST(strncmp(line, "heap profile: ", 14) == 0);
+    OE_TEST(strstr(line, "@ heap_v2/65536") != NULL);
+
+    while (fgets(line, sizeof(line), stream))
+    {
+        if (strstr(line, "] @ 0x"))
+            num_samples++;
+        else if (strcmp(line, "MAPPED_LIBRARIES:\n") == 0)
+            mapped = true;
+    }
+
+    fclose(stream);
+    remove(path);
+
+    OE_TEST(num_samples > 0);
+    OE_TEST(mapped);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+    bool arenas = false;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    result = oe_create_mtmalloc_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(enc_uses_thread_arenas(enclave, &arenas) == OE_OK);
+
+    for (size_t num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2)
+    {
+        double rate = _run_threads(enclave, enc_malloc_loop, num_threads);
+
+        printf(
+            "%s: %s: %zu threads: %.2f M malloc/free per second\n",
+            argv[0],
+            arenas ? "thread arenas" : "global heap",
+            num_threads,
+            rate);
+    }
+
+    _test_heap_profile(enclave);
+
+    {
+        oe_result_t return_value = OE_UNEXPECTED;
+        OE_TEST(enc_check_malloc_stats(enclave, &return_value) == OE_OK);
+        OE_TEST(return_value == OE_OK);
+    }
+
+    {
+        oe_result_t return_value = OE_UNEXPECTED;
+        OE_TEST(enc_pool_tests(enclave, &return_value) == OE_OK);
+        OE_TEST(return_value == OE_OK);
+    }
+
+    for (size_t num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2)
+    {
+        double rate = _run_threads(enclave, enc_pool_loop, num_threads);
+
+        printf(
+            "%s: pool: %zu threads: %.2f M alloc/free per second\n",
+            argv[0],
+            num_threads,
+            rate);
+    }
+
+    {
+        oe_result_t return_value = OE_UNEXPECTED;
+        OE_TEST(enc_pool_destroy(enclave, &return_value) == OE_OK);
+        OE_TEST(return_value == OE_OK);
+    }
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (mtmalloc)\n");
+
+    return 0;
+}
@@ -33,7 +33,20 @@ typedef struct _test_enclave_args
 {
     const char* path;
     uint32_t flags;
+    oe_enclave_t* enclave;
     int ret;
 } TestEnclaveArgs;
 
+typedef struct _nested_call_args
+{
+    /* The enclave making the OCALL and the enclave called from its handler */
+    oe_enclave_t* enclave;
+    oe_enclave_t* other;
+
+    /* oe_thread_self() of the ECALL made back into the first enclave */
+    uint64_t thread;
+
+    oe_result_t ret;
+} NestedCallArgs;
+
 #endif /* _ARGS_H */
@@ -6,6 +6,7 @@
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/tests.h>
+#include <openenclave/internal/thread.h>
 #include "../args.h"
 
 OE_ECALL void Double(void* args_)
@@ -29,6 +30,14 @@ OE_ECALL void DoubleOCall(void* args_)
     OE_TEST(oe_call_host("Double", args_) == OE_OK);
 }
 
+OE_ECALL void GetThreadSelf(void* args_)
+{
+    if (!args_ || !oe_is_outside_enclave(args_, sizeof(uint64_t)))
+        return;
+
+    *(uint64_t*)args_ = oe_thread_self();
+}
+
 OE_ECALL void CreateEnclave(void* args_)
 {
     oe_host_printf("==== Enclave: CreateEnclave\n");
@@ -122,6 +131,28 @@ static void _terminate_enclave(oe_enclave_t* enclave)
     oe_host_free(terminate_args);
 }
 
+/* The OCALL handler calls the other enclave, then this one again. The
+ * second ECALL is nested in this thread's ECALL and must use its TCS. */
+static void _test_nested_call(oe_enclave_t* self, oe_enclave_t* other)
+{
+    NestedCallArgs* nested_args =
+        (NestedCallArgs*)oe_host_malloc(sizeof(NestedCallArgs));
+
+    OE_TEST(nested_args != NULL);
+
+    nested_args->enclave = self;
+    nested_args->other = other;
+    nested_args->thread = 0;
+    nested_args->ret = OE_UNEXPECTED;
+
+    oe_result_t result = oe_call_host("CallNestedHost", nested_args);
+    OE_TEST(result == OE_OK);
+    OE_TEST(nested_args->ret == OE_OK);
+    OE_TEST(nested_args->thread == oe_thread_self());
+
+    oe_host_free(nested_args);
+}
+
 OE_ECALL void TestOCallEnclave(void* args_)
 {
     oe_host_printf("==== Host: TestOCallEnclave\n");
@@ -144,6 +175,9 @@ OE_ECALL void TestOCallEnclave(void* args_)
     /* Test OCALL on this enclave. */
     _call_enclave(enclave, "DoubleOCall");
 
+    /* Test calling back into this enclave after calling the other one. */
+    _test_nested_call(args->enclave, enclave);
+
     /* Test terminating the enclave. */
     _terminate_enclave(enclave);
 
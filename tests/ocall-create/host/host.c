@@ -31,6 +31,19 @@ OE_OCALL void CallEnclaveHost(void* args_)
     args->ret = result;
 }
 
+OE_OCALL void CallNestedHost(void* args_)
+{
+    printf("==== Host: CallNested\n");
+    NestedCallArgs* args = (NestedCallArgs*)args_;
+    int num = 1;
+
+    args->ret = oe_call_enclave(args->other, "Double", &num);
+
+    if (args->ret == OE_OK)
+        args->ret =
+            oe_call_enclave(args->enclave, "GetThreadSelf", &args->thread);
+}
+
 OE_OCALL void TerminateEnclave(void* args_)
 {
     printf("==== Host: TerminateEnclave\n");
@@ -128,7 +141,8 @@ static void _test_create_enclave_ocall_for_enclave(
     if (result != OE_OK)
         oe_put_err("oe_create_enclave(): result=%u", result);
 
-    TestEnclaveArgs args = {.path = path, .flags = flags, .ret = 1};
+    TestEnclaveArgs args = {
+        .path = path, .flags = flags, .enclave = enclave, .ret = 1};
 
     result = oe_call_enclave(enclave, "TestOCallEnclave", &args);
     if (result != OE_OK)
@@ -126,6 +126,43 @@ OE_ECALL void TestMyOCall(void* args_)
     }
 }
 
+OE_ECALL void TestCallHostByHandle(void* args_)
+{
+    TestMyOCallArgs* args = (TestMyOCallArgs*)args_;
+    uint64_t handle = 0;
+    uint64_t other_handle = 0;
+
+    /* Resolving a name twice yields the same handle */
+    OE_TEST(oe_get_host_function_handle("my_ocall", &handle) == OE_OK);
+    OE_TEST(handle != 0);
+    OE_TEST(oe_get_host_function_handle("my_ocall", &other_handle) == OE_OK);
+    OE_TEST(other_handle == handle);
+
+    if (args)
+    {
+        my_ocall_args_t* a =
+            (my_ocall_args_t*)oe_host_calloc(1, sizeof(my_ocall_args_t));
+
+        for (uint64_t i = 1; i <= 3; i++)
+        {
+            a->in = 1000 * i;
+            a->out = 0;
+            OE_TEST(oe_call_host_by_handle(handle, a) == OE_OK);
+            OE_TEST(a->out == a->in * 7);
+        }
+
+        args->result = a->out;
+        oe_host_free(a);
+    }
+
+    /* Unknown names and handles */
+    OE_TEST(oe_get_host_function_handle("B", &other_handle) == OE_NOT_FOUND);
+    OE_TEST(other_handle == 0);
+    OE_TEST(oe_get_host_function_handle(NULL, &handle) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_call_host_by_handle(0, NULL) == OE_NOT_FOUND);
+    OE_TEST(oe_call_host_by_handle(~0ULL, NULL) == OE_NOT_FOUND);
+}
+
 OE_ECALL void TestOCallEdgeCases(void* args_)
 {
     oe_result_t result;
@@ -112,6 +112,39 @@ int main(int argc, const char* argv[])
         OE_TEST(_func2_ok);
     }
 
+    /* Call Test2() by handle */
+    {
+        Test2Args args;
+        uint64_t handle = 0;
+        oe_result_t result;
+
+        result = oe_get_enclave_function_handle(enclave, "Test2", &handle);
+        OE_TEST(result == OE_OK);
+        OE_TEST(handle != 0);
+
+        for (int64_t i = 0; i < 1000; i++)
+        {
+            args.in = i;
+            args.out = 0;
+            result = oe_call_enclave_by_handle(enclave, handle, &args);
+            OE_TEST(result == OE_OK);
+            OE_TEST(args.out == args.in);
+        }
+
+        result = oe_get_enclave_function_handle(enclave, "foobar", &handle);
+        OE_TEST(result == OE_NOT_FOUND);
+        OE_TEST(handle == 0);
+
+        result = oe_get_enclave_function_handle(enclave, "", &handle);
+        OE_TEST(result == OE_NOT_FOUND);
+
+        result = oe_call_enclave_by_handle(enclave, 0, &args);
+        OE_TEST(result == OE_NOT_FOUND);
+
+        result = oe_call_enclave_by_handle(enclave, 1ULL << 32, &args);
+        OE_TEST(result == OE_NOT_FOUND);
+    }
+
     /* Call was_destructor_called() */
     {
         oe_result_t result;
@@ -161,7 +194,16 @@ int main(int argc, const char* argv[])
         OE_TEST(args.result == 7000);
     }
 
-    /* Call TestOCallEdgeCases() */
+    /* Call TestCallHostByHandle() */
+    {
+        TestMyOCallArgs args;
+        args.result = 0;
+        result = oe_call_enclave(enclave, "TestCallHostByHandle", &args);
+        OE_TEST(result == OE_OK);
+        OE_TEST(args.result == 21000);
+    }
+
+        /* Call TestOCallEdgeCases() */
     {
         oe_result_t result =
             oe_call_enclave(enclave, "TestOCallEdgeCases", NULL);
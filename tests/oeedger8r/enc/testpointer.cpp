@@ -1363,6 +1363,28 @@ void ecall_pointer_assert_all_called()
     OE_TEST(num_ecalls == expected_num_calls);
 }
 
+void ecall_pointer_shared(const int* p1, int* p2, int* p3, size_t count)
+{
+    if (!p1)
+    {
+        OE_TEST(p2 == NULL && p3 == NULL);
+        return;
+    }
+
+    // The parameters have been copied out of the shared region.
+    OE_TEST(oe_is_within_enclave(p1, count * sizeof(int)));
+    OE_TEST(oe_is_within_enclave(p2, count * sizeof(int)));
+    OE_TEST(oe_is_within_enclave(p3, count * sizeof(int)));
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        OE_TEST(p1[i] == (int)i);
+        OE_TEST(p3[i] == 0);
+        p3[i] = p1[i] + p2[i];
+        p2[i] *= 2;
+    }
+}
+
 // The following functions exists to make sure there are no
 // compile errors when various basic types are used as size,
 // count attributes.
@@ -160,6 +160,53 @@ static void test_ecall_pointer_fun(oe_enclave_t* enclave, F ecall_pointer_fun)
             psize) == OE_OK);
 }
 
+// Host memory registered with the enclave for [shared] parameters. It must
+// outlive the enclave.
+static int _shared_region[4 * 64];
+
+static void test_ecall_pointer_shared(oe_enclave_t* enclave)
+{
+    const size_t count = 64;
+    int* region = _shared_region;
+    int outside[count];
+    int* p1 = region;
+    int* p2 = region + count;
+    int* p3 = region + 2 * count;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        p1[i] = (int)i;
+        p2[i] = (int)(i * 10);
+        p3[i] = -1;
+    }
+
+    // Shared parameters are rejected until a region is registered.
+    OE_TEST(ecall_pointer_shared(enclave, p1, p2, p3, count) != OE_OK);
+
+    OE_TEST(
+        oe_register_shared_region(
+            enclave, region, sizeof(_shared_region)) == OE_OK);
+    OE_TEST(
+        oe_register_shared_region(
+            enclave, region, sizeof(_shared_region)) == OE_UNSUPPORTED);
+
+    OE_TEST(ecall_pointer_shared(enclave, p1, p2, p3, count) == OE_OK);
+    for (size_t i = 0; i < count; ++i)
+    {
+        OE_TEST(p1[i] == (int)i);
+        OE_TEST(p2[i] == (int)(i * 20));
+        OE_TEST(p3[i] == (int)(i * 11));
+    }
+
+    OE_TEST(ecall_pointer_shared(enclave, NULL, NULL, NULL, count) == OE_OK);
+
+    // Parameters must lie entirely within the region.
+    OE_TEST(ecall_pointer_shared(enclave, outside, p2, p3, count) != OE_OK);
+    OE_TEST(
+        ecall_pointer_shared(enclave, p1, p2, region + 3 * count + 1, count) !=
+        OE_OK);
+}
+
 void test_pointer_edl_ecalls(oe_enclave_t* enclave)
 {
     test_ecall_pointer_fun<char>(enclave, ecall_pointer_char);
@@ -195,6 +242,7 @@ void test_pointer_edl_ecalls(oe_enclave_t* enclave)
         enclave, ecall_pointer_unsigned_long_long);
 
     OE_TEST(ecall_pointer_assert_all_called(enclave) == OE_OK);
+    test_ecall_pointer_shared(enclave);
     printf("=== test_pointer_edl_ecalls passed\n");
 }
 
@@ -7,6 +7,13 @@
 #include <stdio.h>
 #include "print_t.h"
 
+/* The partial line is written when the switchless ECALL returns, although
+ * the enclave worker that runs it stays in the enclave */
+void enclave_print_switchless()
+{
+    oe_host_printf("oe_host_printf(stdout) in a switchless ECALL");
+}
+
 int enclave_test_print()
 {
     size_t n;
@@ -32,6 +39,25 @@ int enclave_test_print()
         const char str[] = "oe_host_write(stdout)\n";
         oe_host_write(0, str, (size_t)-1);
         oe_host_write(0, str, sizeof(str) - 1);
+
+        /* Partial lines are buffered until the newline */
+        oe_host_printf("oe_host_printf");
+        oe_host_printf("(%s)", "stdout");
+        oe_host_printf("\n");
+
+        /* Direct writes come after the buffered output */
+        oe_host_printf("oe_host_printf(stdout) + ");
+        oe_host_write(0, str, (size_t)-1);
+
+        /* So does the output of user OCALLs */
+        oe_host_printf("oe_host_printf(stdout) + ");
+        OE_TEST(host_print("host_print(stdout)\n") == OE_OK);
+
+        /* Including switchless OCALLs */
+        oe_host_printf("oe_host_printf(stdout) + ");
+        OE_TEST(
+            host_print_switchless("host_print_switchless(stdout)\n") ==
+            OE_OK);
     }
 
     /* Write to standard error */
@@ -48,8 +74,18 @@ int enclave_test_print()
         const char str[] = "oe_host_write(stderr)\n";
         oe_host_write(1, str, (size_t)-1);
         oe_host_write(1, str, sizeof(str) - 1);
+
+        /* Output to stderr is not buffered, so there is nothing to flush */
+        oe_host_fprintf(1, "oe_host_fprintf");
+        oe_host_fprintf(1, "(%s)", "stderr");
+        OE_TEST(oe_host_flush(1) == 0);
+        r = fputs(" + fputs(stderr)\n", stderr);
+        OE_TEST(r >= 0);
     }
 
+    /* The partial line is written when the ECALL returns */
+    oe_host_printf("oe_host_printf(stdout) at return");
+
     return 0;
 }
 
@@ -10,6 +10,16 @@
 #include <cstring>
 #include "print_u.h"
 
+void host_print(const char* str)
+{
+    printf("%s", str);
+}
+
+void host_print_switchless(const char* str)
+{
+    printf("%s", str);
+}
+
 void TestPrint(oe_enclave_t* enclave)
 {
     oe_result_t result;
@@ -19,6 +29,13 @@ void TestPrint(oe_enclave_t* enclave)
     result = enclave_test_print(enclave, &return_value);
     OE_TEST(result == OE_OK);
     OE_TEST(return_value == 0);
+
+    /* End the line the enclave left for the ECALL return to write */
+    printf("\n");
+
+    result = enclave_print_switchless(enclave);
+    OE_TEST(result == OE_OK);
+    printf(" + printf(stdout)\n");
 }
 
 int main(int argc, const char* argv[])
@@ -34,8 +51,16 @@ int main(int argc, const char* argv[])
 
     const uint32_t flags = oe_get_create_flags();
 
+    /* One host and one enclave worker for the switchless calls */
+    oe_enclave_config_t config = {1, 1};
+
     if ((result = oe_create_print_enclave(
-             argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave)) != OE_OK)
+             argv[1],
+             OE_ENCLAVE_TYPE_SGX,
+             flags,
+             &config,
+             sizeof(config),
+             &enclave)) != OE_OK)
     {
         oe_put_err("oe_create_enclave(): result=%u", result);
     }
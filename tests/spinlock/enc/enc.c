@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include <openenclave/internal/thread.h>
+#include "spinlock_t.h"
+
+/* Number of lock/unlock pairs that wrap the 16-bit tickets around */
+#define WRAP_ITERATIONS 70000
+
+static oe_spinlock_t _ticket_lock = OE_SPINLOCK_INITIALIZER;
+
+/* Test-and-test-and-set lock (the former oe_spin_lock()) as the baseline */
+static volatile uint32_t _tas_lock;
+
+static volatile bool _use_ticket_lock;
+static volatile size_t _num_threads;
+static volatile size_t _num_ready;
+static volatile bool _stop;
+
+/* Incremented with the lock held */
+static volatile uint64_t _count;
+
+static void _tas_acquire(void)
+{
+    while (__sync_lock_test_and_set(&_tas_lock, 1))
+    {
+        while (_tas_lock)
+            asm volatile("pause" ::: "memory");
+    }
+}
+
+static void _tas_release(void)
+{
+    __sync_lock_release(&_tas_lock);
+}
+
+oe_result_t enc_spinlock_tests()
+{
+    oe_spinlock_t lock = OE_SPINLOCK_INITIALIZER;
+
+    OE_TEST(oe_spin_lock(NULL) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_spin_trylock(NULL) == OE_INVALID_PARAMETER);
+    OE_TEST(oe_spin_unlock(NULL) == OE_INVALID_PARAMETER);
+
+    /* A held lock cannot be taken again */
+    OE_TEST(oe_spin_trylock(&lock) == OE_OK);
+    OE_TEST(oe_spin_trylock(&lock) == OE_BUSY);
+    OE_TEST(oe_spin_unlock(&lock) == OE_OK);
+
+    OE_TEST(oe_spin_lock(&lock) == OE_OK);
+    OE_TEST(oe_spin_trylock(&lock) == OE_BUSY);
+    OE_TEST(oe_spin_unlock(&lock) == OE_OK);
+
+    /* Unlocking a free lock leaves it free */
+    OE_TEST(oe_spin_unlock(&lock) == OE_OK);
+    OE_TEST(oe_spin_trylock(&lock) == OE_OK);
+    OE_TEST(oe_spin_unlock(&lock) == OE_OK);
+
+    /* The tickets wrap around */
+    for (size_t i = 0; i < WRAP_ITERATIONS; i++)
+    {
+        OE_TEST(oe_spin_lock(&lock) == OE_OK);
+        OE_TEST(oe_spin_unlock(&lock) == OE_OK);
+    }
+
+    OE_TEST(oe_spin_trylock(&lock) == OE_OK);
+    OE_TEST(oe_spin_trylock(&lock) == OE_BUSY);
+    OE_TEST(oe_spin_unlock(&lock) == OE_OK);
+    OE_TEST(oe_spin_destroy(&lock) == OE_OK);
+
+    return OE_OK;
+}
+
+void enc_start_run(bool ticket_lock, size_t num_threads)
+{
+    _use_ticket_lock = ticket_lock;
+    _num_threads = num_threads;
+    _num_ready = 0;
+    _stop = false;
+    _count = 0;
+}
+
+size_t enc_ready_count()
+{
+    return _num_ready;
+}
+
+void enc_stop_run()
+{
+    _stop = true;
+}
+
+/* Wait for the other threads of the run, then acquire and release the lock
+ * until enc_stop_run() is called. Return the number of acquisitions. */
+uint64_t enc_lock_loop()
+{
+    const bool ticket_lock = _use_ticket_lock;
+    uint64_t n = 0;
+
+    __sync_fetch_and_add(&_num_ready, 1);
+
+    while (_num_ready < _num_threads)
+        asm volatile("pause" ::: "memory");
+
+    while (!_stop)
+    {
+        if (ticket_lock)
+            oe_spin_lock(&_ticket_lock);
+        else
+            _tas_acquire();
+
+        _count++;
+
+        if (ticket_lock)
+            oe_spin_unlock(&_ticket_lock);
+        else
+            _tas_release();
+
+        n++;
+    }
+
+    return n;
+}
+
+uint64_t enc_run_count()
+{
+    return _count;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    40);  /* TCSCount */
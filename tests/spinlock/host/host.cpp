@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "spinlock_u.h"
+
+/* Must leave a few TCSs of the enclave for the controlling ECALLs */
+const size_t MAX_THREADS = 32;
+
+const size_t RUN_MSEC = 100;
+
+static void _lock_thread(oe_enclave_t* enclave, uint64_t* count)
+{
+    OE_TEST(enc_lock_loop(enclave, count) == OE_OK);
+}
+
+/* Let num_threads threads take the lock for RUN_MSEC milliseconds, and print
+ * the throughput and Jain's fairness index of the acquisitions (1.0 when all
+ * threads got the lock as often) */
+static void _run_threads(
+    oe_enclave_t* enclave,
+    bool ticket_lock,
+    size_t num_threads)
+{
+    std::thread threads[MAX_THREADS];
+    uint64_t counts[MAX_THREADS] = {0};
+    size_t num_ready = 0;
+    uint64_t run_count = 0;
+    uint64_t total = 0;
+    double sum = 0;
+    double sum_squares = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+
+    OE_TEST(enc_start_run(enclave, ticket_lock, num_threads) == OE_OK);
+
+    for (size_t i = 0; i < num_threads; i++)
+        threads[i] = std::thread(_lock_thread, enclave, &counts[i]);
+
+    while (num_ready < num_threads)
+    {
+        std::this_thread::yield();
+        OE_TEST(enc_ready_count(enclave, &num_ready) == OE_OK);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(RUN_MSEC));
+    OE_TEST(enc_stop_run(enclave) == OE_OK);
+
+    for (size_t i = 0; i < num_threads; i++)
+        threads[i].join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        double count = static_cast<double>(counts[i]);
+
+        total += counts[i];
+        sum += count;
+        sum_squares += count * count;
+        min = counts[i] < min ? counts[i] : min;
+        max = counts[i] > max ? counts[i] : max;
+    }
+
+    /* No increment of the shared count was lost */
+    OE_TEST(enc_run_count(enclave, &run_count) == OE_OK);
+    OE_TEST(run_count == total);
+    OE_TEST(total > 0);
+
+    printf(
+        "%s lock: %zu threads: %.2f M acquisitions per second, "
+        "fairness %.3f (min %llu, max %llu)\n",
+        ticket_lock ? "ticket" : "test-and-set",
+        num_threads,
+        sum / std::chrono::duration<double, std::micro>(end - start).count(),
+        sum * sum / (static_cast<double>(num_threads) * sum_squares),
+        static_cast<unsigned long long>(min),
+        static_cast<unsigned long long>(max));
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_result_t return_value = OE_UNEXPECTED;
+    oe_enclave_t* enclave = NULL;
+    const size_t thread_counts[] = {2, 8, MAX_THREADS};
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    result = oe_create_spinlock_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+
+    OE_TEST(enc_spinlock_tests(enclave, &return_value) == OE_OK);
+    OE_TEST(return_value == OE_OK);
+
+    for (size_t i = 0; i < OE_COUNTOF(thread_counts); i++)
+    {
+        _run_threads(enclave, false, thread_counts[i]);
+        _run_threads(enclave, true, thread_counts[i]);
+    }
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (spinlock)\n");
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/tests.h>
+#include "switchless_t.h"
+
+int enc_echo_switchless(int repeats)
+{
+    int n = 0;
+
+    for (int i = 0; i < repeats; i++)
+    {
+        char out[100];
+        int ret = -1;
+
+        OE_TEST(host_echo_switchless(&ret, "Hello World", out) == OE_OK);
+        OE_TEST(ret == 0);
+        OE_TEST(oe_strcmp(out, "Hello World") == 0);
+
+        OE_TEST(host_increment_switchless(&ret, n) == OE_OK);
+        OE_TEST(ret == n + 1);
+        n = ret;
+    }
+
+    return n;
+}
+
+int enc_increment_switchless(int n)
+{
+    return n + 1;
+}
+
+#define MAX_ASYNC_OCALLS 8
+
+/* Keep count calls of host_delay_switchless() in flight (marshalled by hand
+ * as generated code would) and reap each of them once */
+int enc_async_ocalls(int count)
+{
+    oe_ocall_token_t tokens[MAX_ASYNC_OCALLS];
+    host_delay_switchless_args_t* in[MAX_ASYNC_OCALLS];
+    host_delay_switchless_args_t* out[MAX_ASYNC_OCALLS];
+    size_t size = 0;
+    size_t index = 0;
+    size_t bytes_written = 0;
+    int completed = 0;
+    oe_result_t result;
+
+    OE_TEST(count <= MAX_ASYNC_OCALLS);
+    OE_TEST(oe_add_size(&size, sizeof(host_delay_switchless_args_t)) == OE_OK);
+    oe_memset(tokens, 0, sizeof(tokens));
+
+    /* Nothing is in flight yet */
+    OE_TEST(
+        oe_ocall_wait_any(tokens, (size_t)count, &index, &bytes_written) ==
+        OE_NOT_FOUND);
+    OE_TEST(oe_ocall_poll(&tokens[0], &bytes_written) == OE_NOT_FOUND);
+
+    /* Buffers must be in host memory */
+    OE_TEST(
+        oe_call_host_function_async(
+            fcn_id_host_delay_switchless,
+            tokens,
+            size,
+            tokens,
+            size,
+            &tokens[0]) == OE_INVALID_PARAMETER);
+
+    for (int i = 0; i < count; i++)
+    {
+        OE_TEST((in[i] = oe_host_calloc(1, size)) != NULL);
+        OE_TEST((out[i] = oe_host_calloc(1, size)) != NULL);
+        in[i]->n = i;
+
+        OE_TEST(
+            oe_call_host_function_async(
+                fcn_id_host_delay_switchless,
+                in[i],
+                size,
+                out[i],
+                size,
+                &tokens[i]) == OE_OK);
+    }
+
+    while ((result = oe_ocall_wait_any(
+                tokens, (size_t)count, &index, &bytes_written)) !=
+           OE_NOT_FOUND)
+    {
+        OE_TEST(result == OE_OK);
+        OE_TEST(index < (size_t)count);
+        OE_TEST(bytes_written == size);
+        OE_TEST(out[index]->_result == OE_OK);
+        OE_TEST(out[index]->_retval == (int)index + 1);
+
+        /* The token was released */
+        OE_TEST(oe_ocall_poll(&tokens[index], &bytes_written) == OE_NOT_FOUND);
+        completed++;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        oe_host_free(in[i]);
+        oe_host_free(out[i]);
+    }
+
+    return completed;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    64,   /* StackPageCount */
+    4);   /* TCSCount */
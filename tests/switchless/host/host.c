@@ -0,0 +1,206 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/tests.h>
+#include <openenclave/internal/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "switchless_u.h"
+
+#define NUM_HOST_WORKERS 2
+#define NUM_ENCLAVE_WORKERS 2
+#define NUM_REPEATS 10000
+#define NUM_ASYNC_OCALLS 8
+
+int host_echo_switchless(const char* in, char out[100])
+{
+    if (strcmp(in, "Hello World") != 0)
+        return -1;
+
+    strcpy(out, in);
+    return 0;
+}
+
+int host_increment_switchless(int n)
+{
+    return n + 1;
+}
+
+/* Slow enough that enclave threads waiting for it go to sleep */
+int host_delay_switchless(int n)
+{
+#if defined(_WIN32)
+    Sleep(10);
+#else
+    usleep(10000);
+#endif
+    return n + 1;
+}
+
+/* Switchless ocalls must also work when no host workers were requested */
+static void _test_without_workers(const char* path, uint32_t flags)
+{
+    oe_enclave_t* enclave = NULL;
+    oe_switchless_stats_t stats;
+    int ret = 0;
+
+    OE_TEST(
+        oe_create_switchless_enclave(
+            path, OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    OE_TEST(enc_echo_switchless(enclave, &ret, 10) == OE_OK);
+    OE_TEST(ret == 10);
+
+    OE_TEST(enc_increment_switchless(enclave, &ret, 1) == OE_OK);
+    OE_TEST(ret == 2);
+
+    /* Asynchronous ocalls are made synchronously */
+    OE_TEST(enc_async_ocalls(enclave, &ret, NUM_ASYNC_OCALLS) == OE_OK);
+    OE_TEST(ret == NUM_ASYNC_OCALLS);
+
+    OE_TEST(oe_get_switchless_stats(enclave, &stats) == OE_OK);
+    OE_TEST(stats.ocall_hits == 0);
+    OE_TEST(stats.ocall_fallbacks == 0);
+    OE_TEST(stats.ecall_hits == 0);
+    OE_TEST(stats.ecall_fallbacks == 0);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+}
+
+static void _test_with_host_workers(const char* path, uint32_t flags)
+{
+    oe_enclave_t* enclave = NULL;
+    oe_enclave_config_t config = {NUM_HOST_WORKERS, 0};
+    oe_switchless_stats_t stats;
+    int ret = 0;
+
+    OE_TEST(
+        oe_create_switchless_enclave(
+            path,
+            OE_ENCLAVE_TYPE_SGX,
+            flags,
+            &config,
+            sizeof(config),
+            &enclave) == OE_OK);
+
+    OE_TEST(enc_echo_switchless(enclave, &ret, NUM_REPEATS) == OE_OK);
+    OE_TEST(ret == NUM_REPEATS);
+
+    /* Each repeat makes two switchless ocalls */
+    OE_TEST(oe_get_switchless_stats(enclave, &stats) == OE_OK);
+    OE_TEST(stats.ocall_hits + stats.ocall_fallbacks == 2 * NUM_REPEATS);
+    OE_TEST(stats.ocall_hits > 0);
+
+    printf(
+        "switchless ocalls: %llu hits, %llu fallbacks\n",
+        OE_LLU(stats.ocall_hits),
+        OE_LLU(stats.ocall_fallbacks));
+
+    /* More asynchronous ocalls than host workers: the calls beyond the
+     * number of workers are made synchronously */
+    OE_TEST(enc_async_ocalls(enclave, &ret, NUM_ASYNC_OCALLS) == OE_OK);
+    OE_TEST(ret == NUM_ASYNC_OCALLS);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+}
+
+static void _test_with_enclave_workers(const char* path, uint32_t flags)
+{
+    oe_enclave_t* enclave = NULL;
+    oe_enclave_config_t config = {NUM_HOST_WORKERS, NUM_ENCLAVE_WORKERS};
+    oe_switchless_stats_t stats;
+    int n = 0;
+
+    OE_TEST(
+        oe_create_switchless_enclave(
+            path,
+            OE_ENCLAVE_TYPE_SGX,
+            flags,
+            &config,
+            sizeof(config),
+            &enclave) == OE_OK);
+
+    for (int i = 0; i < NUM_REPEATS; i++)
+    {
+        int ret = 0;
+        OE_TEST(enc_increment_switchless(enclave, &ret, n) == OE_OK);
+        OE_TEST(ret == n + 1);
+        n = ret;
+    }
+
+    /* Regular ecalls still work while the workers hold their TCSs */
+    OE_TEST(enc_echo_switchless(enclave, &n, 10) == OE_OK);
+    OE_TEST(n == 10);
+
+    OE_TEST(oe_get_switchless_stats(enclave, &stats) == OE_OK);
+    OE_TEST(stats.ecall_hits + stats.ecall_fallbacks == NUM_REPEATS);
+    OE_TEST(stats.ecall_hits > 0);
+
+    printf(
+        "switchless ecalls: %llu hits, %llu fallbacks\n",
+        OE_LLU(stats.ecall_hits),
+        OE_LLU(stats.ecall_fallbacks));
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+}
+
+static void _test_invalid_config(const char* path, uint32_t flags)
+{
+    oe_enclave_t* enclave = NULL;
+    oe_enclave_config_t config = {NUM_HOST_WORKERS, 0};
+
+    OE_TEST(
+        oe_create_switchless_enclave(
+            path, OE_ENCLAVE_TYPE_SGX, flags, &config, 1, &enclave) ==
+        OE_INVALID_PARAMETER);
+
+    config.num_host_workers = 1000;
+    OE_TEST(
+        oe_create_switchless_enclave(
+            path,
+            OE_ENCLAVE_TYPE_SGX,
+            flags,
+            &config,
+            sizeof(config),
+            &enclave) == OE_INVALID_PARAMETER);
+
+    /* Enclave workers must leave a TCS for regular ecalls (TCSCount is 4) */
+    config.num_host_workers = 0;
+    config.num_enclave_workers = 4;
+    OE_TEST(
+        oe_create_switchless_enclave(
+            path,
+            OE_ENCLAVE_TYPE_SGX,
+            flags,
+            &config,
+            sizeof(config),
+            &enclave) == OE_INVALID_PARAMETER);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    _test_without_workers(argv[1], flags);
+    _test_with_host_workers(argv[1], flags);
+    _test_with_enclave_workers(argv[1], flags);
+    _test_invalid_config(argv[1], flags);
+
+    printf("=== passed all tests (switchless)\n");
+
+    return 0;
+}
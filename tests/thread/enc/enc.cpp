@@ -7,10 +7,12 @@
 
 #include <openenclave/edger8r/enclave.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/syscall.h>
 #include <openenclave/internal/tests.h>
 #include <openenclave/internal/thread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include <atomic>
 #include "thread_t.h"
 
@@ -300,6 +302,87 @@ size_t enc_tcs_used_thread_count()
     return g_tcs_used_thread_count;
 }
 
+static oe_result_t _ignoring_syscall_hook(
+    long number,
+    long arg1,
+    long arg2,
+    long arg3,
+    long arg4,
+    long arg5,
+    long arg6,
+    long* ret)
+{
+    OE_UNUSED(number);
+    OE_UNUSED(arg1);
+    OE_UNUSED(arg2);
+    OE_UNUSED(arg3);
+    OE_UNUSED(arg4);
+    OE_UNUSED(arg5);
+    OE_UNUSED(arg6);
+    OE_UNUSED(ret);
+
+    return OE_UNSUPPORTED;
+}
+
+// Make MUSL syscalls from many threads at once, one of which may install and
+// remove a syscall hook meanwhile. nanosleep() performs an OCALL.
+void enc_test_syscalls(size_t iterations, bool toggle_hook)
+{
+    for (size_t i = 0; i < iterations; i++)
+    {
+        struct timespec ts = {0, 0};
+        struct timespec req = {0, 1000000};
+
+        if (toggle_hook)
+            oe_register_syscall_hook(i % 2 ? NULL : _ignoring_syscall_hook);
+
+        OE_TEST(clock_gettime(CLOCK_REALTIME, &ts) == 0);
+        OE_TEST(ts.tv_sec > 0);
+        OE_TEST(nanosleep(&req, NULL) == 0);
+    }
+
+    if (toggle_hook)
+        oe_register_syscall_hook(NULL);
+}
+
+#ifdef _PTHREAD_ENC_
+// Declared by the internal thread.h, which the pthread build does not include
+extern "C" uint32_t oe_mutex_spin_count;
+#endif
+
+// test_mutex_contention
+static oe_mutex_t contention_mutex = OE_MUTEX_INITIALIZER;
+static volatile size_t contention_count = 0;
+
+uint32_t enc_set_mutex_spin_count(uint32_t spin_count)
+{
+    uint32_t old_spin_count = oe_mutex_spin_count;
+
+    oe_mutex_spin_count = spin_count;
+
+    return old_spin_count;
+}
+
+// Increment a counter that all threads share under contention_mutex. The
+// increment is a separate load and store so that lost updates would show.
+void enc_mutex_contention(size_t iterations)
+{
+    for (size_t i = 0; i < iterations; i++)
+    {
+        OE_TEST(oe_mutex_lock(&contention_mutex) == 0);
+
+        size_t count = contention_count;
+        contention_count = count + 1;
+
+        OE_TEST(oe_mutex_unlock(&contention_mutex) == 0);
+    }
+}
+
+size_t enc_mutex_contention_count()
+{
+    return contention_count;
+}
+
 OE_SET_ENCLAVE_SGX(
     1,    /* ProductID */
     1,    /* SecurityVersion */
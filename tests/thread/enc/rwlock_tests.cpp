@@ -7,6 +7,7 @@
 
 #include <openenclave/enclave.h>
 #include <openenclave/internal/print.h>
+#include <openenclave/internal/tests.h>
 #include <openenclave/internal/thread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -149,6 +150,81 @@ void enc_writer_thread_impl()
     oe_host_printf("%llu: Writer Exiting\n", OE_LLU(oe_thread_self()));
 }
 
+// Read locks taken by enc_test_rwlock_bias() before it checks that writers
+// are kept out, enough for the lock to become read-biased
+const size_t RWLOCK_BIAS_READS = 1000;
+
+void enc_test_rwlock_bias()
+{
+    oe_rwlock_t lock = OE_RWLOCK_INITIALIZER;
+
+    for (size_t i = 0; i < RWLOCK_BIAS_READS; i++)
+    {
+        OE_TEST(oe_rwlock_rdlock(&lock) == 0);
+        OE_TEST(oe_rwlock_unlock(&lock) == 0);
+    }
+
+    // Readers, nested or not, keep writers out.
+    OE_TEST(oe_rwlock_rdlock(&lock) == 0);
+    OE_TEST(oe_rwlock_trywrlock(&lock) != 0);
+    OE_TEST(oe_rwlock_tryrdlock(&lock) == 0);
+    OE_TEST(oe_rwlock_trywrlock(&lock) != 0);
+    OE_TEST(oe_rwlock_unlock(&lock) == 0);
+    OE_TEST(oe_rwlock_trywrlock(&lock) != 0);
+    OE_TEST(oe_rwlock_unlock(&lock) == 0);
+
+    // A writer keeps readers out.
+    OE_TEST(oe_rwlock_trywrlock(&lock) == 0);
+    OE_TEST(oe_rwlock_tryrdlock(&lock) != 0);
+    OE_TEST(oe_rwlock_unlock(&lock) == 0);
+
+    // Readers are let in again after the writer leaves.
+    for (size_t i = 0; i < RWLOCK_BIAS_READS; i++)
+    {
+        OE_TEST(oe_rwlock_rdlock(&lock) == 0);
+        OE_TEST(oe_rwlock_unlock(&lock) == 0);
+    }
+
+    OE_TEST(oe_rwlock_rdlock(&lock) == 0);
+    OE_TEST(oe_rwlock_destroy(&lock) != 0);
+    OE_TEST(oe_rwlock_unlock(&lock) == 0);
+    OE_TEST(oe_rwlock_destroy(&lock) == 0);
+}
+
+// Read-mostly table: writers set all the entries to a new value under
+// table_lock, so readers must always see equal entries.
+static oe_rwlock_t table_lock = OE_RWLOCK_INITIALIZER;
+static volatile size_t table[16];
+
+// Read the table iterations times, updating it instead every write_period
+// iterations (never if zero).
+void enc_read_mostly_thread_impl(size_t iterations, size_t write_period)
+{
+    for (size_t i = 1; i <= iterations; i++)
+    {
+        if (write_period && i % write_period == 0)
+        {
+            OE_TEST(oe_rwlock_wrlock(&table_lock) == 0);
+
+            size_t value = table[0] + 1;
+
+            for (size_t j = 0; j < OE_COUNTOF(table); j++)
+                table[j] = value;
+
+            OE_TEST(oe_rwlock_unlock(&table_lock) == 0);
+        }
+        else
+        {
+            OE_TEST(oe_rwlock_rdlock(&table_lock) == 0);
+
+            for (size_t j = 1; j < OE_COUNTOF(table); j++)
+                OE_TEST(table[j] == table[0]);
+
+            OE_TEST(oe_rwlock_unlock(&table_lock) == 0);
+        }
+    }
+}
+
 void enc_rw_results(
     size_t* readers,
     size_t* writers,
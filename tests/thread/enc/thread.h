@@ -45,5 +45,8 @@ typedef pthread_rwlock_t oe_rwlock_t;
 #define oe_rwlock_rdlock pthread_rwlock_rdlock
 #define oe_rwlock_wrlock pthread_rwlock_wrlock
 #define oe_rwlock_unlock pthread_rwlock_unlock
+#define oe_rwlock_tryrdlock pthread_rwlock_tryrdlock
+#define oe_rwlock_trywrlock pthread_rwlock_trywrlock
+#define oe_rwlock_destroy pthread_rwlock_destroy
 
 #endif /* _OE_INCLUDE_THREAD_H */
@@ -211,6 +211,10 @@ void test_thread_locking_patterns(oe_enclave_t* enclave)
 
 void test_readers_writer_lock(oe_enclave_t* enclave);
 
+void test_rwlock_bias(oe_enclave_t* enclave);
+
+void test_read_mostly_rwlock(oe_enclave_t* enclave);
+
 // test_tcs_exhaustion
 static std::atomic<size_t> g_tcs_out_thread_count(0);
 
@@ -286,6 +290,149 @@ size_t host_tcs_out_thread_count()
     return g_tcs_out_thread_count;
 }
 
+// test_tcs_contention
+const size_t TCS_CONTENTION_ECALLS = 20000;
+
+void* tcs_contention_thread(oe_enclave_t* enclave)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < TCS_CONTENTION_ECALLS; i++)
+        OE_TEST(enc_tcs_used_thread_count(enclave, &count) == OE_OK);
+
+    return NULL;
+}
+
+// this benchmark measures the ecall throughput when an increasing number of
+// host threads (up to one per TCS) make trivial ecalls into the same enclave,
+// which makes assigning and releasing TCS bindings the contended operation
+void test_tcs_contention(oe_enclave_t* enclave)
+{
+    for (size_t num_threads = 1; num_threads <= enclave->num_bindings;
+         num_threads *= 2)
+    {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (size_t i = 0; i < num_threads; i++)
+            threads.push_back(std::thread(tcs_contention_thread, enclave));
+
+        for (size_t i = 0; i < num_threads; i++)
+            threads[i].join();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        double elapsed =
+            std::chrono::duration<double, std::micro>(end - start).count();
+        size_t num_ecalls = num_threads * TCS_CONTENTION_ECALLS;
+        double ecalls = static_cast<double>(num_ecalls);
+
+        printf(
+            "test_tcs_contention: threads=%zu; ecalls=%zu; "
+            "%.3f us/ecall; %.0f ecalls/s\n",
+            num_threads,
+            num_ecalls,
+            elapsed / ecalls,
+            ecalls * 1000000.0 / elapsed);
+    }
+}
+
+// test_syscalls
+const size_t SYSCALL_ITERATIONS = 100;
+
+void* syscalls_thread(oe_enclave_t* enclave, bool toggle_hook)
+{
+    OE_TEST(
+        enc_test_syscalls(enclave, SYSCALL_ITERATIONS, toggle_hook) == OE_OK);
+
+    return NULL;
+}
+
+// enclave threads call clock_gettime() and nanosleep() (1 ms) concurrently
+// while one of them installs and removes a syscall hook; the sleeps of the
+// threads overlap since the syscall dispatcher takes no lock
+void test_syscalls(oe_enclave_t* enclave)
+{
+    std::thread threads[NUM_THREADS];
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+        threads[i] = std::thread(syscalls_thread, enclave, i == 0);
+
+    for (size_t i = 0; i < NUM_THREADS; i++)
+        threads[i].join();
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    printf(
+        "test_syscalls: threads=%zu; syscalls=%zu; %.1f ms\n",
+        NUM_THREADS,
+        NUM_THREADS * SYSCALL_ITERATIONS * 2,
+        std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+// test_mutex_contention
+const size_t MUTEX_CONTENTION_ITERATIONS = 10000;
+
+void* mutex_contention_thread(oe_enclave_t* enclave)
+{
+    OE_TEST(
+        enc_mutex_contention(enclave, MUTEX_CONTENTION_ITERATIONS) == OE_OK);
+
+    return NULL;
+}
+
+// this benchmark measures the cost of a short critical section guarded by an
+// enclave mutex that 1 to NUM_THREADS threads contend for, first with
+// contended threads sleeping at once (spin count zero) and then spinning for
+// the default spin count before they sleep
+void test_mutex_contention(oe_enclave_t* enclave)
+{
+    uint32_t spin_count = 0;
+    size_t expected_count = 0;
+
+    OE_TEST(enc_set_mutex_spin_count(enclave, &spin_count, 0) == OE_OK);
+
+    for (uint32_t spin : {0U, spin_count})
+    {
+        uint32_t old_spin_count = 0;
+
+        OE_TEST(
+            enc_set_mutex_spin_count(enclave, &old_spin_count, spin) == OE_OK);
+
+        for (size_t num_threads = 1; num_threads <= NUM_THREADS;
+             num_threads *= 2)
+        {
+            std::vector<std::thread> threads;
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (size_t i = 0; i < num_threads; i++)
+                threads.push_back(
+                    std::thread(mutex_contention_thread, enclave));
+
+            for (size_t i = 0; i < num_threads; i++)
+                threads[i].join();
+
+            auto end = std::chrono::high_resolution_clock::now();
+            double elapsed =
+                std::chrono::duration<double, std::micro>(end - start).count();
+            size_t num_locks = num_threads * MUTEX_CONTENTION_ITERATIONS;
+
+            printf(
+                "test_mutex_contention: spin_count=%u; threads=%zu; "
+                "%.3f us/lock\n",
+                spin,
+                num_threads,
+                elapsed / static_cast<double>(num_locks));
+
+            expected_count += num_locks;
+        }
+    }
+
+    size_t count = 0;
+    OE_TEST(enc_mutex_contention_count(enclave, &count) == OE_OK);
+    OE_TEST(count == expected_count);
+}
+
 int main(int argc, const char* argv[])
 {
     oe_result_t result;
@@ -318,8 +465,18 @@ int main(int argc, const char* argv[])
 
     test_readers_writer_lock(enclave);
 
+    test_rwlock_bias(enclave);
+
+    test_read_mostly_rwlock(enclave);
+
     test_tcs_exhaustion(enclave);
 
+    test_tcs_contention(enclave);
+
+    test_syscalls(enclave);
+
+    test_mutex_contention(enclave);
+
     if ((result = oe_terminate_enclave(enclave)) != OE_OK)
     {
         oe_put_err("oe_terminate_enclave(): result=%u", result);
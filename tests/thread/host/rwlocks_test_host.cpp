@@ -83,3 +83,58 @@ void test_readers_writer_lock(oe_enclave_t* enclave)
     // simultaneously active at least once.
     OE_TEST(max_readers == NUM_READER_THREADS);
 }
+
+void test_rwlock_bias(oe_enclave_t* enclave)
+{
+    OE_TEST(enc_test_rwlock_bias(enclave) == OE_OK);
+}
+
+// test_read_mostly_rwlock
+const size_t READ_MOSTLY_ITERATIONS = 100000;
+
+void* read_mostly_thread(oe_enclave_t* enclave, size_t write_period)
+{
+    OE_TEST(
+        enc_read_mostly_thread_impl(
+            enclave, READ_MOSTLY_ITERATIONS, write_period) == OE_OK);
+
+    return NULL;
+}
+
+// this benchmark measures the cost of a read-mostly table guarded by a
+// readers-writer lock for 1 to NUM_RW_TEST_THREADS threads that only read it
+// or also update it once every 1000 accesses; readers check that they never
+// see a partial update
+void test_read_mostly_rwlock(oe_enclave_t* enclave)
+{
+    const size_t write_periods[] = {0, 1000};
+
+    for (size_t write_period : write_periods)
+    {
+        for (size_t num_threads = 1; num_threads <= NUM_RW_TEST_THREADS;
+             num_threads *= 2)
+        {
+            std::thread threads[NUM_RW_TEST_THREADS];
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (size_t i = 0; i < num_threads; i++)
+                threads[i] =
+                    std::thread(read_mostly_thread, enclave, write_period);
+
+            for (size_t i = 0; i < num_threads; i++)
+                threads[i].join();
+
+            auto end = std::chrono::high_resolution_clock::now();
+            double elapsed =
+                std::chrono::duration<double, std::nano>(end - start).count();
+
+            printf(
+                "test_read_mostly_rwlock: write_period=%zu; threads=%zu; "
+                "%.1f ns/access\n",
+                write_period,
+                num_threads,
+                elapsed /
+                    static_cast<double>(num_threads * READ_MOSTLY_ITERATIONS));
+        }
+    }
+}
@@ -233,6 +233,10 @@ let oe_gen_wrapper_prototype (fd: Ast.func_decl) (is_ecall:bool) =
   in
   sprintf "oe_result_t %s(\n        %s)" fd.Ast.fname (String.concat ",\n        " args)
 
+let oe_gen_batch_wrapper_prototype (fd: Ast.func_decl) =
+  sprintf "oe_result_t %s_batch(\n        oe_enclave_t* enclave,\n        %s_args_t* _batch,\n        size_t _count)"
+    fd.Ast.fname fd.Ast.fname
+
 let emit_struct_or_union (os:out_channel) (s:Ast.struct_def) (union:bool) =
   fprintf os "typedef %s %s {\n" (if union then "union" else "struct") s.Ast.sname;
   List.iter (fun (atype, decl) ->
@@ -327,6 +331,12 @@ let get_cast_to_mem_expr (ptype, decl)=
     else
       sprintf "(%s) " (get_tystr t)
 
+(** Whether a pointer parameter is copied through the marshalling
+    buffers. [shared] parameters are passed by address instead and
+    copied by the enclave (see [oe_gen_get_shared_buffers]). *)
+let is_marshalled (ptr_attr: Ast.ptr_attr) =
+  ptr_attr.Ast.pa_chkptr && not ptr_attr.Ast.pa_isshared
+
 (** Prepare [input_buffer]. *)
 let oe_prepare_input_buffer (os:out_channel) (fd:Ast.func_decl) (alloc_func:string) =
   fprintf os "    /* Compute input buffer size. Include in and in-out parameters. */\n";
@@ -334,7 +344,7 @@ let oe_prepare_input_buffer (os:out_channel) (fd:Ast.func_decl) (alloc_func:stri
   List.iter (fun (ptype, decl) ->
       match ptype with
       | Ast.PTPtr (atype, ptr_attr) ->
-        if ptr_attr.Ast.pa_chkptr then
+        if is_marshalled ptr_attr then
           match ptr_attr.Ast.pa_direction with
           | Ast.PtrIn | Ast.PtrInOut ->
             let size = oe_get_param_size (ptype, decl, "_args.") in
@@ -349,7 +359,7 @@ let oe_prepare_input_buffer (os:out_channel) (fd:Ast.func_decl) (alloc_func:stri
   List.iter (fun (ptype, decl) ->
       match ptype with
       | Ast.PTPtr (atype, ptr_attr) ->
-        if ptr_attr.Ast.pa_chkptr then
+        if is_marshalled ptr_attr then
           match ptr_attr.Ast.pa_direction with
           | Ast.PtrOut | Ast.PtrInOut ->
             let size = oe_get_param_size (ptype, decl, "_args.") in
@@ -377,7 +387,7 @@ let oe_prepare_input_buffer (os:out_channel) (fd:Ast.func_decl) (alloc_func:stri
   List.iter (fun (ptype, decl) ->
       match ptype with
       | Ast.PTPtr (atype, ptr_attr) ->
-        if ptr_attr.Ast.pa_chkptr then
+        if is_marshalled ptr_attr then
           let size = oe_get_param_size (ptype, decl, "_args.") in
           match ptr_attr.Ast.pa_direction with
           | Ast.PtrIn -> fprintf os "    OE_WRITE_IN_PARAM(%s, %s);\n" decl.Ast.identifier size
@@ -411,7 +421,7 @@ let oe_process_output_buffer (os:out_channel) (fd:Ast.func_decl) =
   List.iter (fun (ptype, decl) ->
       match ptype with
       | Ast.PTPtr (atype, ptr_attr) ->
-        if ptr_attr.Ast.pa_chkptr then
+        if is_marshalled ptr_attr then
           let size = oe_get_param_size (ptype, decl, "_args.") in
           match ptr_attr.Ast.pa_direction with
           | Ast.PtrOut -> fprintf os "    OE_READ_OUT_PARAM(%s, (size_t)(%s));\n" decl.Ast.identifier size
@@ -516,7 +526,13 @@ let oe_gen_copy_outputs (os:out_channel) (fd: Ast.func_decl) =
 
 let oe_gen_call_function (os:out_channel) (fd: Ast.func_decl) =
   let params = List.map (fun (pt, decl) ->
-      sprintf "%spargs_in->%s" (get_cast_from_mem_expr (pt, decl))decl.Ast.identifier) fd.Ast.plist
+      match pt with
+      | Ast.PTPtr (t, ptr_attr) when ptr_attr.Ast.pa_isshared ->
+        let cast = get_cast_from_mem_expr (pt, decl) in
+        let cast = if cast = "" then sprintf "(%s) " (get_tystr t) else cast in
+        sprintf "%s_shared_%s" cast decl.Ast.identifier
+      | _ ->
+        sprintf "%spargs_in->%s" (get_cast_from_mem_expr (pt, decl))decl.Ast.identifier) fd.Ast.plist
   in
   let params_str = "(\n        " ^ (String.concat ",\n        " params ) ^ ")" in
   let ret_str = match fd.Ast.rtype with
@@ -526,6 +542,47 @@ let oe_gen_call_function (os:out_channel) (fd: Ast.func_decl) =
   fprintf os "    /* Call user function */\n";
   fprintf os "    %s;\n" call_str
 
+let iter_shared_params f (fd: Ast.func_decl) =
+  List.iter (fun (ptype, decl) ->
+      match ptype with
+      | Ast.PTPtr (_, ptr_attr) when ptr_attr.Ast.pa_isshared ->
+        f (ptype, decl, ptr_attr)
+      | _ -> ()
+    ) fd.Ast.plist
+
+(** Copy [shared] parameters from the registered host region into enclave
+    memory. This is the only copy made of them. *)
+let oe_gen_get_shared_buffers (os:out_channel) (fd: Ast.func_decl) =
+  fprintf os "    /* Copy shared parameters to enclave memory */\n";
+  iter_shared_params (fun (ptype, decl, ptr_attr) ->
+      let size = oe_get_param_size (ptype, decl, "pargs_in->") in
+      let copy_in =
+        match ptr_attr.Ast.pa_direction with
+        | Ast.PtrOut -> "false"
+        | _ -> "true"
+      in
+      fprintf os "    if (oe_get_shared_buffer(pargs_in->%s, %s, %s, &_shared_%s) != OE_OK)\n"
+        decl.Ast.identifier size copy_in decl.Ast.identifier;
+      fprintf os "        goto done;\n"
+    ) fd;
+  fprintf os "\n"
+
+(** Copy out and in-out [shared] parameters back to the host region and
+    release the enclave buffers. *)
+let oe_gen_put_shared_buffers (os:out_channel) (fd: Ast.func_decl) =
+  fprintf os "\n    /* Copy shared out and in-out parameters to host memory */\n";
+  iter_shared_params (fun (ptype, decl, ptr_attr) ->
+      let size = oe_get_param_size (ptype, decl, "pargs_in->") in
+      let copy_out =
+        match ptr_attr.Ast.pa_direction with
+        | Ast.PtrIn -> "false"
+        | _ -> "true"
+      in
+      fprintf os "    oe_put_shared_buffer((void*) pargs_in->%s, _shared_%s, %s, %s);\n"
+        decl.Ast.identifier decl.Ast.identifier size copy_out;
+      fprintf os "    _shared_%s = NULL;\n" decl.Ast.identifier
+    ) fd
+
 (** Generate ecall function. *)
 let oe_gen_ecall_function (os:out_channel) (fd: Ast.func_decl) =
   fprintf os "void ecall_%s(\n" fd.Ast.fname;
@@ -539,6 +596,8 @@ let oe_gen_ecall_function (os:out_channel) (fd: Ast.func_decl) =
   fprintf os "    /* Prepare parameters */\n";
   fprintf os "    %s_args_t* pargs_in = (%s_args_t*) input_buffer;\n" fd.Ast.fname fd.Ast.fname;
   fprintf os "    %s_args_t* pargs_out = (%s_args_t*) output_buffer;\n\n" fd.Ast.fname fd.Ast.fname;
+  iter_shared_params (fun (_, decl, _) ->
+      fprintf os "    void* _shared_%s = NULL;\n" decl.Ast.identifier) fd;
   fprintf os "    size_t input_buffer_offset = 0;\n";
   fprintf os "    size_t output_buffer_offset = 0;\n";
   fprintf os "    OE_ADD_SIZE(input_buffer_offset, sizeof(*pargs_in));\n";
@@ -556,7 +615,7 @@ let oe_gen_ecall_function (os:out_channel) (fd: Ast.func_decl) =
   List.iter (fun (ptype, decl) ->
       match ptype with
       | Ast.PTPtr (atype, ptr_attr) ->
-        if ptr_attr.Ast.pa_chkptr then
+        if is_marshalled ptr_attr then
           let size = oe_get_param_size (ptype, decl, "pargs_in->") in
           match ptr_attr.Ast.pa_direction with
           | Ast.PtrIn -> fprintf os "    OE_SET_IN_POINTER(%s, %s);\n" decl.Ast.identifier size
@@ -573,7 +632,7 @@ let oe_gen_ecall_function (os:out_channel) (fd: Ast.func_decl) =
   List.iter (fun (ptype, decl) ->
       match ptype with
       | Ast.PTPtr (atype, ptr_attr) ->
-        if ptr_attr.Ast.pa_chkptr then
+        if is_marshalled ptr_attr then
           let size = oe_get_param_size (ptype, decl, "pargs_in->") in
           match ptr_attr.Ast.pa_direction with
           | Ast.PtrOut -> fprintf os "    OE_SET_OUT_POINTER(%s, %s);\n" decl.Ast.identifier size
@@ -584,10 +643,21 @@ let oe_gen_ecall_function (os:out_channel) (fd: Ast.func_decl) =
     ) fd.Ast.plist;
   fprintf os "\n";
 
+  (* Copy shared parameters *)
+  let has_shared =
+    List.exists (fun (ptype, _) ->
+        match ptype with
+        | Ast.PTPtr (_, ptr_attr) -> ptr_attr.Ast.pa_isshared
+        | _ -> false
+      ) fd.Ast.plist
+  in
+  if has_shared then oe_gen_get_shared_buffers os fd;
+
   (* Call the enclave function *)
   fprintf os "    /* lfence after checks */\n";
   fprintf os "    oe_lfence();\n\n";
   oe_gen_call_function os fd;
+  if has_shared then oe_gen_put_shared_buffers os fd;
 
   (* Mark call as success *)
   fprintf os "\n    /* Success. */\n";
@@ -596,6 +666,10 @@ let oe_gen_ecall_function (os:out_channel) (fd: Ast.func_decl) =
   fprintf os "done:\n";
 
   (* oe_gen_free_buffers os fd; *)
+  iter_shared_params (fun (_, decl, _) ->
+      fprintf os "    if (_shared_%s)\n" decl.Ast.identifier;
+      fprintf os "        oe_put_shared_buffer(NULL, _shared_%s, 0, false);\n" decl.Ast.identifier
+    ) fd;
   fprintf os "    if (pargs_out && output_buffer_size >= sizeof(*pargs_out)) \n";
   fprintf os "        pargs_out->_result = _result;\n";
   fprintf os "}\n\n"
@@ -631,7 +705,8 @@ let gen_fill_marshal_struct (os:out_channel) (fd:Ast.func_decl)  (args:string) =
     ) fd.Ast.plist;
   fprintf os "\n"
 
-let oe_get_host_ecall_function (os:out_channel) (fd:Ast.func_decl) =
+let oe_get_host_ecall_function (os:out_channel) (tf:Ast.trusted_func) =
+  let fd = tf.Ast.tf_fdecl in
   fprintf os "%s" (oe_gen_wrapper_prototype fd true);
   fprintf os "\n";
   fprintf os "{\n";
@@ -652,8 +727,12 @@ let oe_get_host_ecall_function (os:out_channel) (fd:Ast.func_decl) =
   fprintf os "    memset(&_args, 0, sizeof(_args));\n";
   gen_fill_marshal_struct os fd "_args";
   oe_prepare_input_buffer os fd "malloc";
+  let call_enclave_function =
+    if tf.Ast.tf_is_switchless then "oe_switchless_call_enclave_function"
+    else "oe_call_enclave_function"
+  in
   fprintf os "    /* Call enclave function */\n";
-  fprintf os "    if((_result = oe_call_enclave_function(\n";
+  fprintf os "    if((_result = %s(\n" call_enclave_function;
   fprintf os "                        enclave,\n";
   fprintf os "                        %s,\n" (get_function_id fd);
   fprintf os "                        _input_buffer, _input_buffer_size,\n";
@@ -668,6 +747,82 @@ let oe_get_host_ecall_function (os:out_channel) (fd:Ast.func_decl) =
   fprintf os "    return _result;\n";
   fprintf os "}\n\n"
 
+(** Generate the [_batch] host wrapper of a batchable ecall. Each element
+    of [_batch] holds the parameters of one call; its [_retval] and
+    [_result] are set from the outcome of that call. Batchable functions
+    only take parameters that are marshalled by value. *)
+let oe_get_host_ecall_batch_function (os:out_channel) (tf:Ast.trusted_func) =
+  let fd = tf.Ast.tf_fdecl in
+  fprintf os "%s" (oe_gen_batch_wrapper_prototype fd);
+  fprintf os "\n";
+  fprintf os "{\n";
+  fprintf os "    oe_result_t _result = OE_FAILURE;\n\n";
+  fprintf os "    /* Call descriptors and marshalling buffers of the batch */ \n";
+  fprintf os "    oe_enclave_function_call_t* _calls = NULL;\n";
+  fprintf os "    %s_args_t* _pargs_out = NULL;\n" fd.Ast.fname;
+  fprintf os "    size_t _input_buffer_size = 0;\n";
+  fprintf os "    size_t _output_buffer_size = 0;\n";
+  fprintf os "    size_t _total_buffer_size = 0;\n";
+  fprintf os "    uint8_t* _buffer = NULL;\n";
+  fprintf os "    size_t _i = 0;\n\n";
+  fprintf os "    if (_count == 0) {\n";
+  fprintf os "        _result = OE_OK;\n";
+  fprintf os "        goto done;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    if (_batch == NULL) {\n";
+  fprintf os "        _result = OE_INVALID_PARAMETER;\n";
+  fprintf os "        goto done;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    /* Compute buffer sizes of one call */\n";
+  fprintf os "    OE_ADD_SIZE(_input_buffer_size, sizeof(%s_args_t));\n" fd.Ast.fname;
+  fprintf os "    OE_ADD_SIZE(_output_buffer_size, sizeof(%s_args_t));\n" fd.Ast.fname;
+  fprintf os "    _total_buffer_size = _input_buffer_size;\n";
+  fprintf os "    OE_ADD_SIZE(_total_buffer_size, _output_buffer_size);\n\n";
+  fprintf os "    /* Allocate descriptors and marshalling buffers */\n";
+  fprintf os "    _calls = (oe_enclave_function_call_t*) calloc(_count, sizeof(*_calls));\n";
+  fprintf os "    _buffer = (uint8_t*) calloc(_count, _total_buffer_size);\n";
+  fprintf os "    if (_calls == NULL || _buffer == NULL) { \n";
+  fprintf os "        _result = OE_OUT_OF_MEMORY;\n";
+  fprintf os "        goto done;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    /* Copy the args structure of each call to its input buffer */\n";
+  fprintf os "    for (_i = 0; _i < _count; _i++) {\n";
+  fprintf os "        uint8_t* _input_buffer = _buffer + _i * _total_buffer_size;\n";
+  fprintf os "        memcpy(_input_buffer, &_batch[_i], sizeof(%s_args_t));\n" fd.Ast.fname;
+  fprintf os "        _calls[_i].function_id = %s;\n" (get_function_id fd);
+  fprintf os "        _calls[_i].input_buffer = _input_buffer;\n";
+  fprintf os "        _calls[_i].input_buffer_size = _input_buffer_size;\n";
+  fprintf os "        _calls[_i].output_buffer = _input_buffer + _input_buffer_size;\n";
+  fprintf os "        _calls[_i].output_buffer_size = _output_buffer_size;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    /* Call enclave functions */\n";
+  fprintf os "    if((_result = oe_call_enclave_function_batch(\n";
+  fprintf os "                        enclave, _calls, _count)) != OE_OK)\n";
+  fprintf os "        goto done;\n\n";
+  fprintf os "    /* Unmarshal the outcome of each call */\n";
+  fprintf os "    for (_i = 0; _i < _count; _i++) {\n";
+  fprintf os "        *(uint8_t**)&_pargs_out = (uint8_t*) _calls[_i].output_buffer;\n";
+  fprintf os "        if ((_batch[_i]._result = _calls[_i].result) != OE_OK)\n";
+  fprintf os "            continue;\n";
+  fprintf os "        /* Currently exactly _output_buffer_size bytes must be written */\n";
+  fprintf os "        if (_calls[_i].output_bytes_written != _output_buffer_size) {\n";
+  fprintf os "            _batch[_i]._result = OE_FAILURE;\n";
+  fprintf os "            continue;\n";
+  fprintf os "        }\n";
+  fprintf os "        if ((_batch[_i]._result = _pargs_out->_result) != OE_OK)\n";
+  fprintf os "            continue;\n";
+  (if fd.Ast.rtype <> Ast.Void then
+     fprintf os "        _batch[_i]._retval = _pargs_out->_retval;\n");
+  fprintf os "    }\n\n";
+  fprintf os "    _result = OE_OK;\n";
+  fprintf os "done:    \n";
+  fprintf os "    if (_buffer)\n";
+  fprintf os "        free(_buffer);\n";
+  fprintf os "    if (_calls)\n";
+  fprintf os "        free(_calls);\n";
+  fprintf os "    return _result;\n";
+  fprintf os "}\n\n"
+
 let iter_ptr_params f params =
   List.iter (fun (ptype, decl)->
       match ptype with
@@ -699,8 +854,12 @@ let oe_gen_ocall_enclave_wrapper (os:out_channel) (uf:Ast.untrusted_func) =
   fprintf os "    memset(&_args, 0, sizeof(_args));\n";
   gen_fill_marshal_struct os fd "_args";
   oe_prepare_input_buffer os fd "oe_allocate_ocall_buffer";
+  let call_host_function =
+    if uf.Ast.uf_is_switchless then "oe_switchless_call_host_function"
+    else "oe_call_host_function"
+  in
   fprintf os "    /* Call host function */\n";
-  fprintf os "    if((_result = oe_call_host_function(\n";
+  fprintf os "    if((_result = %s(\n" call_host_function;
   fprintf os "                        %s,\n" (get_function_id fd);
   fprintf os "                        _input_buffer, _input_buffer_size,\n";
   fprintf os "                        _output_buffer, _output_buffer_size,\n";
@@ -912,10 +1071,21 @@ let validate_oe_support (ec: enclave_content) (ep: edger8r_params) =
   List.iter (fun f ->
       (if f.Ast.tf_is_priv then
          failwithf "Function '%s': 'private' specifier is not supported by oeedger8r" f.Ast.tf_fdecl.fname);
-      (if f.Ast.tf_is_switchless then
-         failwithf "Function '%s': switchless ecalls and ocalls are not yet supported by Open Enclave SDK." f.Ast.tf_fdecl.fname);
+      (if f.Ast.tf_is_batchable then
+         List.iter (fun (ptype, decl) ->
+             match ptype with
+             | Ast.PTPtr (_, ptr_attr) when ptr_attr.Ast.pa_chkptr ->
+               failwithf "Function '%s': batchable ecalls cannot take parameter '%s' marshalled by pointer; use user_check or by-value parameters." f.Ast.tf_fdecl.fname decl.Ast.identifier
+             | _ -> ()
+           ) f.Ast.tf_fdecl.Ast.plist);
     ) ec.tfunc_decls;
   List.iter (fun f ->
+      List.iter (fun (ptype, decl) ->
+          match ptype with
+          | Ast.PTPtr (_, ptr_attr) when ptr_attr.Ast.pa_isshared ->
+            failwithf "Function '%s': 'shared' attribute of parameter '%s' is only supported for ecalls." f.Ast.uf_fdecl.fname decl.Ast.identifier
+          | _ -> ()
+        ) f.Ast.uf_fdecl.Ast.plist;
       (if f.Ast.uf_fattr.fa_convention <> Ast.CC_NONE then
          let cconv_str = Ast.get_call_conv_str f.Ast.uf_fattr.Ast.fa_convention in
          printf "Warning: Function '%s': Calling convention '%s' for ocalls is not supported by oeedger8r.\n" f.Ast.uf_fdecl.fname cconv_str);
@@ -923,8 +1093,6 @@ let validate_oe_support (ec: enclave_content) (ep: edger8r_params) =
          failwithf "Function '%s': dllimport is not supported by oeedger8r." f.Ast.uf_fdecl.fname);
       (if f.Ast.uf_allow_list != [] then
          printf "Warning: Function '%s': Reentrant ocalls are not supported by Open Enclave. Allow list ignored.\n" f.Ast.uf_fdecl.fname);
-      (if f.Ast.uf_is_switchless then
-         failwithf "Function '%s': switchless ecalls and ocalls are not yet supported by Open Enclave SDK." f.Ast.uf_fdecl.fname);
     ) ec.ufunc_decls;
   (* Map warning functions over trusted and untrusted function
      declarations *)
@@ -1023,6 +1191,13 @@ let gen_u_h (ec: enclave_content) (ep: edger8r_params) =
     fprintf os "/* List of ecalls */\n\n";
     List.iter (fun f -> fprintf os "%s;\n" (oe_gen_wrapper_prototype f.Ast.tf_fdecl true)) ec.tfunc_decls;
     fprintf os "\n");
+  if List.exists (fun f -> f.Ast.tf_is_batchable) ec.tfunc_decls then (
+    fprintf os "/* List of batched ecalls */\n\n";
+    List.iter (fun f ->
+        if f.Ast.tf_is_batchable then
+          fprintf os "%s;\n" (oe_gen_batch_wrapper_prototype f.Ast.tf_fdecl)
+      ) ec.tfunc_decls;
+    fprintf os "\n");
   if ec.ufunc_decls <> [] then (
     fprintf os "/* List of ocalls */\n\n";
     List.iter (fun d -> fprintf os"%s;\n" (oe_gen_prototype d.Ast.uf_fdecl))  ec.ufunc_decls;
@@ -1043,7 +1218,11 @@ let gen_u_c (ec: enclave_content) (ep: edger8r_params) =
   fprintf os "OE_EXTERNC_BEGIN\n\n";
   if ec.tfunc_decls <> [] then (
     fprintf os "/* Wrappers for ecalls */\n\n";
-    List.iter (fun d -> oe_get_host_ecall_function os d.Ast.tf_fdecl; fprintf os "\n\n")  ec.tfunc_decls);
+    List.iter (fun d ->
+        oe_get_host_ecall_function os d; fprintf os "\n\n";
+        if d.Ast.tf_is_batchable then (
+          oe_get_host_ecall_batch_function os d; fprintf os "\n\n")
+      ) ec.tfunc_decls);
   if ec.ufunc_decls <> [] then (
     fprintf os "\n/* ocall functions */\n\n";
     List.iter (fun d -> oe_gen_ocall_host_wrapper os d) ec.ufunc_decls);
@@ -82,6 +82,7 @@ type ptr_attr = {
   pa_iswstr     : bool;
   pa_rdonly     : bool;       (* If the pointer is 'const' qualified *)
   pa_chkptr     : bool;       (* Whether to generate code to check pointer *)
+  pa_isshared   : bool;       (* If the buffer lies in the registered shared region *)
 }
 
 (* parameter type *)
@@ -158,6 +159,7 @@ type trusted_func = {
   tf_fdecl   : func_decl;
   tf_is_priv : bool;
   tf_is_switchless : bool;
+  tf_is_batchable : bool;
 }
 
 type untrusted_func = {